@@ -0,0 +1,373 @@
+/* bcache.c - block buffer cache with LRU eviction and write-back
+ * vim:ts=4 noexpandtab
+ */
+
+#include "bcache.h"
+#include "lib.h"
+
+static buf_t bcache[BCACHE_SIZE];
+/* block aligned so a DMA region never crosses a 64KB boundary */
+static uint8_t bcache_data[BCACHE_SIZE][BLKDEV_BLOCK_SIZE] __attribute__((aligned(BLKDEV_BLOCK_SIZE)));
+static buf_t* bcache_hash[BCACHE_HASH_SIZE];
+/* sentinel of the LRU list, lru_next is the most recently used buffer and lru_prev the least */
+static buf_t bcache_lru;
+static uint32_t bcache_ticks = 0;
+
+/* bcache_slot
+ *
+ * hash a (device, block) pair
+ * Inputs: dev - the device
+ *         block - the block number
+ * Outputs: the bucket index
+ * Side Effects: None
+ */
+static uint32_t bcache_slot(blkdev_t* dev, uint32_t block){
+    return (block ^ ((uint32_t)dev >> 4)) & (BCACHE_HASH_SIZE - 1);
+}
+
+/* lru_remove
+ *
+ * unlink a buffer from the LRU list
+ * Inputs: buf - the buffer
+ * Outputs: None
+ * Side Effects: None
+ */
+static void lru_remove(buf_t* buf){
+    buf->lru_prev->lru_next = buf->lru_next;
+    buf->lru_next->lru_prev = buf->lru_prev;
+}
+
+/* lru_push_front
+ *
+ * make a buffer the most recently used
+ * Inputs: buf - the buffer, not in the list
+ * Outputs: None
+ * Side Effects: None
+ */
+static void lru_push_front(buf_t* buf){
+    buf->lru_prev = &bcache_lru;
+    buf->lru_next = bcache_lru.lru_next;
+    bcache_lru.lru_next->lru_prev = buf;
+    bcache_lru.lru_next = buf;
+}
+
+/* hash_remove
+ *
+ * unlink a buffer from its hash bucket
+ * Inputs: buf - the buffer
+ * Outputs: None
+ * Side Effects: None
+ */
+static void hash_remove(buf_t* buf){
+    buf_t** pos;
+    if(buf->dev == NULL) return;
+    for(pos = &(bcache_hash[bcache_slot(buf->dev, buf->block)]); *pos != NULL; pos = &((*pos)->hash_next)){
+        if(*pos == buf){
+            *pos = buf->hash_next;
+            return;
+        }
+    }
+}
+
+/* bcache_lookup
+ *
+ * find the buffer of a block
+ * Inputs: dev - the device
+ *         block - the block number
+ * Outputs: the buffer, NULL if the block is not cached
+ * Side Effects: None
+ */
+static buf_t* bcache_lookup(blkdev_t* dev, uint32_t block){
+    buf_t* buf;
+    for(buf = bcache_hash[bcache_slot(dev, block)]; buf != NULL; buf = buf->hash_next){
+        if(buf->dev == dev && buf->block == block) return buf;
+    }
+    return NULL;
+}
+
+/* bcache_reap
+ *
+ * finish the bookkeeping of a completed asynchronous write-back, a failed one leaves the buffer dirty
+ * Inputs: buf - the buffer
+ * Outputs: None
+ * Side Effects: None
+ */
+static void bcache_reap(buf_t* buf){
+    if(!(buf->flags & B_WRITING) || buf->io.status == IDE_PENDING) return;
+    buf->flags &= ~B_WRITING;
+    if(buf->io.status == IDE_FAILED) buf->flags |= B_DIRTY;
+}
+
+/* bcache_victim
+ *
+ * find the least recently used buffer nobody holds
+ * Inputs: None
+ * Outputs: the buffer, NULL if every buffer is busy
+ * Side Effects: None
+ */
+static buf_t* bcache_victim(void){
+    buf_t* buf;
+    for(buf = bcache_lru.lru_prev; buf != &bcache_lru; buf = buf->lru_prev){
+        bcache_reap(buf);
+        if(buf->refcnt == 0 && !(buf->flags & (B_LOADING | B_WRITING))) return buf;
+    }
+    return NULL;
+}
+
+/* bcache_init
+ *
+ * set up the empty cache
+ * Inputs: None
+ * Outputs: None
+ * Side Effects: None
+ */
+void bcache_init(void){
+    uint32_t i;
+    bcache_lru.lru_prev = &bcache_lru;
+    bcache_lru.lru_next = &bcache_lru;
+    for(i = 0; i < BCACHE_HASH_SIZE; i++){
+        bcache_hash[i] = NULL;
+    }
+    for(i = 0; i < BCACHE_SIZE; i++){
+        bcache[i].dev = NULL;
+        bcache[i].refcnt = 0;
+        bcache[i].flags = 0;
+        bcache[i].data = bcache_data[i];
+        bcache[i].hash_next = NULL;
+        lru_push_front(&(bcache[i]));
+    }
+}
+
+/* bgetblk
+ *
+ * hold the buffer of a block, taking the least recently used free buffer on a miss,
+ * must be called with interrupts enabled since the device may have to be waited for
+ * Inputs: dev - the device
+ *         block - the block number
+ *         fill - 1 to read the block in if the buffer does not hold it yet
+ * Outputs: the held buffer, NULL if the block is invalid, cannot be read or every buffer is busy
+ * Side Effects: a dirty victim is written back first
+ */
+static buf_t* bgetblk(blkdev_t* dev, uint32_t block, int32_t fill){
+    uint32_t flags;
+    buf_t* buf;
+    int32_t result;
+    int32_t load = 0;
+    if(dev == NULL || block >= dev->num_blocks) return NULL;
+
+    cli_and_save(flags);
+    while(1){
+        buf = bcache_lookup(dev, block);
+        if(buf != NULL){
+            buf->refcnt++;
+            break;
+        }
+        buf = bcache_victim();
+        if(buf == NULL){
+            restore_flags(flags);
+            return NULL;
+        }
+        if(!(buf->flags & B_DIRTY)){
+            /* give the buffer its new identity */
+            hash_remove(buf);
+            buf->dev = dev;
+            buf->block = block;
+            buf->flags = 0;
+            buf->refcnt = 1;
+            buf->hash_next = bcache_hash[bcache_slot(dev, block)];
+            bcache_hash[bcache_slot(dev, block)] = buf;
+            break;
+        }
+        /* write the victim back first, its old block can still be found meanwhile */
+        buf->refcnt++;
+        buf->flags |= B_LOADING;
+        restore_flags(flags);
+        result = buf->dev->write_block(buf->dev, buf->block, buf->data);
+        cli_and_save(flags);
+        buf->flags &= ~B_LOADING;
+        if(result != -1) buf->flags &= ~B_DIRTY;
+        buf->refcnt--;
+        if(result == -1){
+            restore_flags(flags);
+            return NULL;
+        }
+        /* somebody may have wanted the victim or our block meanwhile, look again */
+    }
+    lru_remove(buf);
+    lru_push_front(buf);
+    if(fill && !(buf->flags & (B_VALID | B_LOADING))){
+        buf->flags |= B_LOADING;
+        load = 1;
+    }
+    restore_flags(flags);
+
+    if(load){
+        result = dev->read_block(dev, block, buf->data);
+        cli_and_save(flags);
+        buf->flags &= ~B_LOADING;
+        if(result != -1) buf->flags |= B_VALID;
+        restore_flags(flags);
+    }
+    /* wait for whoever is reading the block in or writing it back */
+    while(buf->flags & B_LOADING);
+    if(buf->flags & B_WRITING){
+        ide_wait(&(buf->io));
+        cli_and_save(flags);
+        bcache_reap(buf);
+        restore_flags(flags);
+    }
+    if(fill && !(buf->flags & B_VALID)){
+        brelse(buf);
+        return NULL;
+    }
+    return buf;
+}
+
+/* bread
+ *
+ * get a block with its content
+ * Inputs: dev - the device
+ *         block - the block number
+ * Outputs: the held buffer, NULL if the block cannot be read
+ * Side Effects: the buffer must be given back with brelse
+ */
+buf_t* bread(blkdev_t* dev, uint32_t block){
+    return bgetblk(dev, block, 1);
+}
+
+/* bread_direct
+ *
+ * copy a run of blocks with a single device transfer, bypassing the cache so a
+ * long sequential read neither pays a second copy nor evicts the working set,
+ * the run is refused if any of its blocks may be newer in the cache than on the device
+ * Inputs: dev - the device
+ *         block - the first block
+ *         count - the number of blocks
+ *         data - count * BLKDEV_BLOCK_SIZE bytes to fill
+ * Outputs: 0 if successful, -1 if the blocks have to be read through bread
+ * Side Effects: change data
+ */
+int32_t bread_direct(blkdev_t* dev, uint32_t block, uint32_t count, uint8_t* data){
+    uint32_t flags;
+    uint32_t i;
+    buf_t* buf;
+    if(dev == NULL || dev->read_blocks == NULL || count == 0) return -1;
+    if(block >= dev->num_blocks || count > dev->num_blocks - block) return -1;
+
+    cli_and_save(flags);
+    for(i = 0; i < count; i++){
+        buf = bcache_lookup(dev, block + i);
+        /* a clean idle buffer matches the device, anything else may not */
+        if(buf != NULL && (buf->refcnt != 0 || buf->flags != B_VALID)){
+            restore_flags(flags);
+            return -1;
+        }
+    }
+    restore_flags(flags);
+    return dev->read_blocks(dev, block, count, data);
+}
+
+/* bget
+ *
+ * get a block the caller will overwrite completely, followed by bdirty
+ * Inputs: dev - the device
+ *         block - the block number
+ * Outputs: the held buffer, NULL if the block is invalid or every buffer is busy
+ * Side Effects: the buffer must be given back with brelse
+ */
+buf_t* bget(blkdev_t* dev, uint32_t block){
+    return bgetblk(dev, block, 0);
+}
+
+/* bdirty
+ *
+ * mark a held block as modified, it reaches the device on the next write-back
+ * Inputs: buf - the buffer
+ * Outputs: None
+ * Side Effects: None
+ */
+void bdirty(buf_t* buf){
+    uint32_t flags;
+    cli_and_save(flags);
+    buf->flags |= B_VALID | B_DIRTY;
+    restore_flags(flags);
+}
+
+/* brelse
+ *
+ * give a held block back
+ * Inputs: buf - the buffer
+ * Outputs: None
+ * Side Effects: the buffer may be evicted once nobody holds it
+ */
+void brelse(buf_t* buf){
+    uint32_t flags;
+    cli_and_save(flags);
+    buf->refcnt--;
+    restore_flags(flags);
+}
+
+/* bsync
+ *
+ * write every modified block back and wait for it, must be called with interrupts enabled
+ * Inputs: None
+ * Outputs: 0 if successful, -1 if some block could not be written
+ * Side Effects: None
+ */
+int32_t bsync(void){
+    uint32_t i;
+    uint32_t flags;
+    int32_t ret = 0;
+    buf_t* buf;
+    for(i = 0; i < BCACHE_SIZE; i++){
+        buf = &(bcache[i]);
+        if(buf->flags & B_WRITING) ide_wait(&(buf->io));
+        cli_and_save(flags);
+        bcache_reap(buf);
+        if(!(buf->flags & B_DIRTY) || (buf->flags & (B_LOADING | B_WRITING))){
+            restore_flags(flags);
+            continue;
+        }
+        /* a change made while writing dirties the buffer again */
+        buf->refcnt++;
+        buf->flags &= ~B_DIRTY;
+        restore_flags(flags);
+        if(buf->dev->write_block(buf->dev, buf->block, buf->data) == -1){
+            bdirty(buf);
+            ret = -1;
+        }
+        brelse(buf);
+    }
+    return ret;
+}
+
+/* bcache_flush_tick
+ *
+ * count PIT ticks and every BCACHE_FLUSH_TICKS start writing back the modified blocks nobody
+ * holds, devices that would have to wait get an asynchronous write instead
+ * Inputs: None
+ * Outputs: None
+ * Side Effects: runs in interrupt context
+ */
+void bcache_flush_tick(void){
+    uint32_t i;
+    buf_t* buf;
+    if(++bcache_ticks < BCACHE_FLUSH_TICKS) return;
+    bcache_ticks = 0;
+
+    for(i = 0; i < BCACHE_SIZE; i++){
+        buf = &(bcache[i]);
+        bcache_reap(buf);
+        if(!(buf->flags & B_DIRTY) || buf->refcnt != 0 || (buf->flags & (B_LOADING | B_WRITING))) continue;
+        buf->flags &= ~B_DIRTY;
+        if(buf->dev->start_write != NULL){
+            buf->flags |= B_WRITING;
+            if(buf->dev->start_write(buf->dev, buf->block, buf->data, &(buf->io)) == -1){
+                buf->flags &= ~B_WRITING;
+                buf->flags |= B_DIRTY;
+            }
+        } else if(buf->dev->write_block(buf->dev, buf->block, buf->data) == -1){
+            buf->flags |= B_DIRTY;
+        }
+    }
+}
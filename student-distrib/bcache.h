@@ -0,0 +1,51 @@
+/* bcache.h - Defines the block buffer cache
+ * vim:ts=4 noexpandtab
+ */
+
+#ifndef _BCACHE_H
+#define _BCACHE_H
+
+#include "types.h"
+#include "blkdev.h"
+
+#define BCACHE_SIZE 64              // cached blocks, 256 KB
+#define BCACHE_HASH_SIZE 64         // hash buckets keyed by (device, block), power of 2
+#define BCACHE_FLUSH_TICKS 300      // PIT ticks between write-backs, 3 seconds at 100Hz
+
+/* buffer flags */
+#define B_VALID 0x1                 // data holds the block
+#define B_DIRTY 0x2                 // data is newer than the device
+#define B_LOADING 0x4               // a process is reading the block in or writing it back, wait
+#define B_WRITING 0x8               // an asynchronous write-back is in flight, the data must not change
+
+typedef struct buf buf_t;
+struct buf {
+    blkdev_t* dev;
+    uint32_t block;
+    uint32_t refcnt;                // holders between bread and brelse, only free buffers are evicted
+    volatile uint32_t flags;
+    uint8_t* data;                  // BLKDEV_BLOCK_SIZE bytes
+    buf_t* hash_next;
+    buf_t* lru_prev;
+    buf_t* lru_next;
+    ide_request_t io;               // the write-back of a device with start_write
+};
+
+/* set up the empty cache */
+void bcache_init(void);
+/* get a block with its content, NULL if it cannot be read */
+buf_t* bread(blkdev_t* dev, uint32_t block);
+/* copy a run of blocks the cache does not hold straight from the device, -1 to go through bread */
+int32_t bread_direct(blkdev_t* dev, uint32_t block, uint32_t count, uint8_t* data);
+/* get a block the caller will overwrite completely, its content is not read */
+buf_t* bget(blkdev_t* dev, uint32_t block);
+/* mark a held block as modified */
+void bdirty(buf_t* buf);
+/* give a block back */
+void brelse(buf_t* buf);
+/* write every modified block back */
+int32_t bsync(void);
+/* called on every PIT tick, writes modified blocks back now and then */
+void bcache_flush_tick(void);
+
+#endif /* _BCACHE_H */
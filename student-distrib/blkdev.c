@@ -0,0 +1,136 @@
+/* blkdev.c - RAM disk and IDE block devices
+ * vim:ts=4 noexpandtab
+ */
+
+#include "blkdev.h"
+#include "lib.h"
+
+/* ramdisk_read_block
+ *
+ * copy a block out of the image
+ * Inputs: dev - the device
+ *         block - the block number
+ *         data - BLKDEV_BLOCK_SIZE bytes to fill
+ * Outputs: 0
+ * Side Effects: change data
+ */
+static int32_t ramdisk_read_block(blkdev_t* dev, uint32_t block, uint8_t* data){
+    memcpy(data, dev->base + block * BLKDEV_BLOCK_SIZE, BLKDEV_BLOCK_SIZE);
+    return 0;
+}
+
+/* ramdisk_write_block
+ *
+ * copy a block into the image
+ * Inputs: dev - the device
+ *         block - the block number
+ *         data - BLKDEV_BLOCK_SIZE bytes to store
+ * Outputs: 0
+ * Side Effects: change the image
+ */
+static int32_t ramdisk_write_block(blkdev_t* dev, uint32_t block, const uint8_t* data){
+    memcpy(dev->base + block * BLKDEV_BLOCK_SIZE, data, BLKDEV_BLOCK_SIZE);
+    return 0;
+}
+
+/* ramdisk_read_blocks
+ *
+ * copy a run of blocks out of the image at once
+ * Inputs: dev - the device
+ *         block - the first block
+ *         count - the number of blocks
+ *         data - count * BLKDEV_BLOCK_SIZE bytes to fill
+ * Outputs: 0
+ * Side Effects: change data
+ */
+static int32_t ramdisk_read_blocks(blkdev_t* dev, uint32_t block, uint32_t count, uint8_t* data){
+    memcpy(data, dev->base + block * BLKDEV_BLOCK_SIZE, count * BLKDEV_BLOCK_SIZE);
+    return 0;
+}
+
+/* ramdisk_init
+ *
+ * set up a device over an image in memory
+ * Inputs: dev - the device to set up
+ *         base - the first byte of the image
+ *         num_blocks - the size of the image in blocks
+ * Outputs: None
+ * Side Effects: None
+ */
+void ramdisk_init(blkdev_t* dev, uint8_t* base, uint32_t num_blocks){
+    dev->num_blocks = num_blocks;
+    dev->read_block = ramdisk_read_block;
+    dev->write_block = ramdisk_write_block;
+    dev->start_write = NULL;
+    dev->read_blocks = ramdisk_read_blocks;
+    dev->base = base;
+}
+
+/* ide_read_block
+ *
+ * read a block from the drive, waiting for the transfer
+ * Inputs: dev - the device
+ *         block - the block number
+ *         data - BLKDEV_BLOCK_SIZE bytes to fill
+ * Outputs: 0 if successful, -1 if the transfer fails
+ * Side Effects: change data
+ */
+static int32_t ide_read_block(blkdev_t* dev, uint32_t block, uint8_t* data){
+    return ide_read(dev->drive, dev->first_lba + block * IDE_SECTORS_PER_BLOCK, data, IDE_SECTORS_PER_BLOCK);
+}
+
+/* ide_write_block
+ *
+ * write a block to the drive, waiting for the transfer
+ * Inputs: dev - the device
+ *         block - the block number
+ *         data - BLKDEV_BLOCK_SIZE bytes to store
+ * Outputs: 0 if successful, -1 if the transfer fails
+ * Side Effects: change the drive
+ */
+static int32_t ide_write_block(blkdev_t* dev, uint32_t block, const uint8_t* data){
+    return ide_write(dev->drive, dev->first_lba + block * IDE_SECTORS_PER_BLOCK, data, IDE_SECTORS_PER_BLOCK);
+}
+
+/* ide_start_write
+ *
+ * queue a block write to the drive without waiting
+ * Inputs: dev - the device
+ *         block - the block number
+ *         data - BLKDEV_BLOCK_SIZE bytes to store, unchanged until req completes
+ *         req - the request to use, it completes asynchronously
+ * Outputs: 0 if queued, -1 if fails
+ * Side Effects: None
+ */
+static int32_t ide_start_write(blkdev_t* dev, uint32_t block, const uint8_t* data, ide_request_t* req){
+    req->drive = dev->drive;
+    req->lba = dev->first_lba + block * IDE_SECTORS_PER_BLOCK;
+    req->count = IDE_SECTORS_PER_BLOCK;
+    req->buf = (uint8_t*)data;
+    req->write = 1;
+    return ide_submit(req);
+}
+
+/* ide_blkdev_init
+ *
+ * set up a device over an IDE drive
+ * Inputs: dev - the device to set up
+ *         drive - 0 for master, 1 for slave
+ *         first_lba - the sector of block 0
+ * Outputs: 0 if successful, -1 if the drive is not there or too small
+ * Side Effects: None
+ */
+int32_t ide_blkdev_init(blkdev_t* dev, uint32_t drive, uint32_t first_lba){
+    uint32_t sectors = ide_sectors(drive);
+    if(sectors <= first_lba) return -1;
+    dev->num_blocks = (sectors - first_lba) / IDE_SECTORS_PER_BLOCK;
+    dev->read_block = ide_read_block;
+    dev->write_block = ide_write_block;
+    dev->start_write = ide_start_write;
+    /* DMA needs a physical address, which a user buffer does not have */
+    dev->read_blocks = NULL;
+    dev->base = NULL;
+    dev->drive = drive;
+    dev->first_lba = first_lba;
+    return 0;
+}
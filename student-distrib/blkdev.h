@@ -0,0 +1,34 @@
+/* blkdev.h - Defines the block devices the buffer cache reads and writes
+ * vim:ts=4 noexpandtab
+ */
+
+#ifndef _BLKDEV_H
+#define _BLKDEV_H
+
+#include "types.h"
+#include "devices/ide.h"
+
+#define BLKDEV_BLOCK_SIZE 4096      // bytes per block, the same as the file system block
+#define IDE_SECTORS_PER_BLOCK (BLKDEV_BLOCK_SIZE / IDE_SECTOR_SIZE)
+
+typedef struct blkdev blkdev_t;
+struct blkdev {
+    uint32_t num_blocks;
+    int32_t (*read_block)(blkdev_t* dev, uint32_t block, uint8_t* data);
+    /* may wait for an interrupt only if start_write is given */
+    int32_t (*write_block)(blkdev_t* dev, uint32_t block, const uint8_t* data);
+    /* start writing a block back and return without waiting, NULL if write_block never waits */
+    int32_t (*start_write)(blkdev_t* dev, uint32_t block, const uint8_t* data, ide_request_t* req);
+    /* copy a run of blocks into any buffer, user memory included, NULL if the device cannot */
+    int32_t (*read_blocks)(blkdev_t* dev, uint32_t block, uint32_t count, uint8_t* data);
+    uint8_t* base;          // ram disk: first byte of the image
+    uint32_t drive;         // ide: the drive holding the image
+    uint32_t first_lba;     // ide: the sector of block 0
+};
+
+/* a device over an image in memory, such as the multiboot module */
+void ramdisk_init(blkdev_t* dev, uint8_t* base, uint32_t num_blocks);
+/* a device over an IDE drive starting at sector first_lba */
+int32_t ide_blkdev_init(blkdev_t* dev, uint32_t drive, uint32_t first_lba);
+
+#endif /* _BLKDEV_H */
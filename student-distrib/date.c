@@ -1,5 +1,6 @@
 #include "date.h"
 #include "GUI/gui.h"
+#include "vdso.h"
 
 int32_t get_update_in_progress_flag() { // learnt from https://wiki.osdev.org/CMOS#Accessing_CMOS_Registers
       outb(0x0A, CMOS_SELE_PORT);
@@ -36,6 +37,7 @@ void get_date() {
         year = (year & 0x0F) + ((year >> 4) * 10);
     }
 
+    vdso_set_date(sec, min, hour, day, month, year);
     draw_time();
     // Convert 12 hour clock to 24 hour clock if necessary
     /*
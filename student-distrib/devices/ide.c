@@ -0,0 +1,410 @@
+#include "ide.h"
+#include "../lib.h"
+#include "../i8259.h"
+
+/* I/O base of the bus master registers, 0 if there is no PCI IDE controller and only PIO is used */
+static uint16_t ide_bm_base = 0;
+
+/* sectors of each drive on the primary channel, 0 if the drive is not there */
+static uint32_t ide_drive_sectors[IDE_DRIVE_NUM];
+
+/* pending requests sorted by drive and sector, and the batch the controller is working on */
+static ide_request_t* ide_queue = NULL;
+static ide_request_t* ide_active = NULL;
+
+/* the table must not cross a 64KB boundary, aligning it to its own size is enough */
+static prd_t ide_prdt[IDE_PRD_NUM] __attribute__((aligned(IDE_PRD_NUM * sizeof(prd_t))));
+
+/* pci_read - read a dword from the configuration space of a device on bus 0
+ * Inputs: dev - the device number
+ *         func - the function number
+ *         offset - the register offset
+ * Outputs: the dword read
+ * Side Effects: None
+ */
+static uint32_t pci_read(uint32_t dev, uint32_t func, uint32_t offset) {
+    outl(PCI_ENABLE | (dev << 11) | (func << 8) | (offset & ~3), PCI_CONFIG_ADDR);
+    return inl(PCI_CONFIG_DATA);
+}
+
+/* pci_write - write a dword to the configuration space of a device on bus 0
+ * Inputs: dev - the device number
+ *         func - the function number
+ *         offset - the register offset
+ *         data - the dword to write
+ * Outputs: None
+ * Side Effects: change the configuration of the device
+ */
+static void pci_write(uint32_t dev, uint32_t func, uint32_t offset, uint32_t data) {
+    outl(PCI_ENABLE | (dev << 11) | (func << 8) | (offset & ~3), PCI_CONFIG_ADDR);
+    outl(data, PCI_CONFIG_DATA);
+}
+
+/* ide_find_bus_master - find the PCI IDE controller (the PIIX on QEMU) and enable bus mastering
+ * Inputs: None
+ * Outputs: the I/O base of the bus master registers, 0 if there is none
+ * Side Effects: change the PCI command register of the controller
+ */
+static uint16_t ide_find_bus_master(void) {
+    uint32_t dev, func;
+    uint32_t bar;
+    for (dev = 0; dev < PCI_MAX_DEV; dev++) {
+        for (func = 0; func < PCI_MAX_FUNC; func++) {
+            if ((pci_read(dev, func, 0) & 0xFFFF) == PCI_VENDOR_NONE) continue;
+            if ((pci_read(dev, func, PCI_CLASS) >> 16) != PCI_CLASS_IDE) continue;
+            bar = pci_read(dev, func, PCI_BAR4);
+            if (!(bar & 1)) return 0;      // the bus master registers must be in I/O space
+            pci_write(dev, func, PCI_COMMAND, pci_read(dev, func, PCI_COMMAND) | PCI_COMMAND_IO | PCI_COMMAND_MASTER);
+            return bar & PCI_BAR_IO_MASK;
+        }
+    }
+    return 0;
+}
+
+/* ide_wait_ready - wait until the drive is not busy
+ * Inputs: None
+ * Outputs: the status register, -1 if the drive stays busy
+ * Side Effects: None
+ */
+static int32_t ide_wait_ready(void) {
+    uint32_t i;
+    uint8_t status;
+    for (i = 0; i < IDE_TIMEOUT; i++) {
+        status = inb(IDE_STATUS);
+        if (!(status & IDE_STATUS_BSY)) return status;
+    }
+    return -1;
+}
+
+/* ide_identify - ask a drive for its size
+ * Inputs: drive - 0 for master, 1 for slave
+ * Outputs: number of sectors reachable with LBA28, 0 if there is no ATA drive
+ * Side Effects: None
+ */
+static uint32_t ide_identify(uint32_t drive) {
+    uint16_t id[IDE_IDENTIFY_WORDS];
+    int32_t status;
+    uint32_t i;
+
+    outb(IDE_SEL_LBA | (drive << IDE_SEL_SLAVE_SHIFT), IDE_DRIVE_SEL);
+    outb(0, IDE_SECCOUNT);
+    outb(0, IDE_LBA_LO);
+    outb(0, IDE_LBA_MID);
+    outb(0, IDE_LBA_HI);
+    outb(IDE_CMD_IDENTIFY, IDE_COMMAND);
+
+    status = inb(IDE_STATUS);
+    if (status == 0 || status == IDE_STATUS_FLOATING) return 0;
+    status = ide_wait_ready();
+    /* ATAPI drives abort IDENTIFY */
+    if (status == -1 || (status & IDE_STATUS_ERR) || !(status & IDE_STATUS_DRQ)) return 0;
+
+    for (i = 0; i < IDE_IDENTIFY_WORDS; i++) {
+        id[i] = inw(IDE_DATA);
+    }
+    return id[IDE_ID_SECTORS_LO] | ((uint32_t)id[IDE_ID_SECTORS_HI] << 16);
+}
+
+/* ide_issue - select the drive and the sectors and send a command
+ * Inputs: drive - 0 for master, 1 for slave
+ *         lba - the first sector
+ *         count - the number of sectors, at most IDE_MAX_SECTORS
+ *         command - the ATA command
+ * Outputs: 0 if the command is sent, -1 if the drive stays busy
+ * Side Effects: None
+ */
+static int32_t ide_issue(uint32_t drive, uint32_t lba, uint32_t count, uint8_t command) {
+    if (ide_wait_ready() == -1) return -1;
+    outb(IDE_SEL_LBA | (drive << IDE_SEL_SLAVE_SHIFT) | ((lba >> 24) & 0x0F), IDE_DRIVE_SEL);
+    outb((uint8_t)count, IDE_SECCOUNT);    // IDE_MAX_SECTORS becomes 0
+    outb(lba & 0xFF, IDE_LBA_LO);
+    outb((lba >> 8) & 0xFF, IDE_LBA_MID);
+    outb((lba >> 16) & 0xFF, IDE_LBA_HI);
+    outb(command, IDE_COMMAND);
+    return 0;
+}
+
+/* ide_pio - move a batch of requests with programmed I/O, polling the drive
+ * Inputs: batch - requests covering consecutive sectors, linked by next
+ *         total - the number of sectors of the batch
+ * Outputs: IDE_DONE or IDE_FAILED
+ * Side Effects: the drive does not interrupt while this runs
+ */
+static int32_t ide_pio(ide_request_t* batch, uint32_t total) {
+    ide_request_t* req;
+    uint16_t* words;
+    uint32_t i, j;
+    int32_t status;
+    int32_t result = IDE_DONE;
+
+    outb(IDE_CTRL_NIEN, IDE_CTRL);
+    if (ide_issue(batch->drive, batch->lba, total, batch->write ? IDE_CMD_WRITE_PIO : IDE_CMD_READ_PIO) == -1) {
+        result = IDE_FAILED;
+    }
+    for (req = batch; req != NULL && result == IDE_DONE; req = req->next) {
+        words = (uint16_t*)req->buf;
+        for (i = 0; i < req->count && result == IDE_DONE; i++) {
+            status = ide_wait_ready();
+            if (status == -1 || (status & (IDE_STATUS_ERR | IDE_STATUS_DF)) || !(status & IDE_STATUS_DRQ)) {
+                result = IDE_FAILED;
+                break;
+            }
+            for (j = 0; j < IDE_SECTOR_SIZE / 2; j++, words++) {
+                if (req->write) outw(*words, IDE_DATA);
+                else *words = inw(IDE_DATA);
+            }
+        }
+    }
+    /* PIO writes may sit in the drive's cache */
+    if (result == IDE_DONE && batch->write) {
+        if (ide_wait_ready() == -1) result = IDE_FAILED;
+        else outb(IDE_CMD_FLUSH, IDE_COMMAND);
+        if (ide_wait_ready() == -1) result = IDE_FAILED;
+    }
+    if (ide_bm_base != 0) outb(0, IDE_CTRL);
+    return result;
+}
+
+/* ide_dma_start - start a batch of requests with bus-master DMA, one region per buffer
+ * Inputs: batch - requests covering consecutive sectors, linked by next
+ *         total - the number of sectors of the batch
+ * Outputs: 0 if the transfer is started, -1 if the buffers do not fit the PRD table or the drive is busy
+ * Side Effects: IRQ 14 fires when the transfer completes
+ */
+static int32_t ide_dma_start(ide_request_t* batch, uint32_t total) {
+    ide_request_t* req;
+    uint32_t n = 0;
+    uint32_t addr, remaining, chunk;
+    uint8_t direction = batch->write ? 0 : IDE_BM_CMD_READ;
+
+    for (req = batch; req != NULL; req = req->next) {
+        addr = (uint32_t)req->buf;
+        if (addr & 1) return -1;          // regions must be word aligned
+        remaining = req->count * IDE_SECTOR_SIZE;
+        while (remaining > 0) {
+            if (n >= IDE_PRD_NUM) return -1;
+            chunk = IDE_PRD_MAX_BYTES - (addr & (IDE_PRD_MAX_BYTES - 1));
+            if (chunk > remaining) chunk = remaining;
+            ide_prdt[n].addr = addr;
+            ide_prdt[n].count = (uint16_t)chunk;    // IDE_PRD_MAX_BYTES becomes 0
+            ide_prdt[n].flags = 0;
+            addr += chunk;
+            remaining -= chunk;
+            n++;
+        }
+    }
+    ide_prdt[n - 1].flags = IDE_PRD_EOT;
+
+    outb(direction, ide_bm_base + IDE_BM_CMD);
+    outl((uint32_t)ide_prdt, ide_bm_base + IDE_BM_PRDT);
+    outb(IDE_BM_STATUS_ERR | IDE_BM_STATUS_IRQ, ide_bm_base + IDE_BM_STATUS);     // write 1 to clear
+    if (ide_issue(batch->drive, batch->lba, total, batch->write ? IDE_CMD_WRITE_DMA : IDE_CMD_READ_DMA) == -1) return -1;
+    outb(direction | IDE_BM_CMD_START, ide_bm_base + IDE_BM_CMD);
+    return 0;
+}
+
+/* ide_complete - finish the active batch
+ * Inputs: result - IDE_DONE or IDE_FAILED
+ * Outputs: None
+ * Side Effects: the requests leave the driver, their owners may reuse them right away
+ */
+static void ide_complete(int32_t result) {
+    ide_request_t* req = ide_active;
+    ide_request_t* next;
+    ide_active = NULL;
+    while (req != NULL) {
+        next = req->next;
+        req->next = NULL;
+        req->status = result;
+        req = next;
+    }
+}
+
+/* ide_start - start the next batch if the controller is idle, must be called with interrupts off
+ * Inputs: None
+ * Outputs: None
+ * Side Effects: requests that continue each other on the disk are merged into one command
+ */
+static void ide_start(void) {
+    ide_request_t* last;
+    uint32_t total;
+    while (ide_active == NULL && ide_queue != NULL) {
+        /* take the head of the queue and every request that continues it on the disk */
+        ide_active = ide_queue;
+        last = ide_queue;
+        total = last->count;
+        while (last->next != NULL && last->next->drive == last->drive && last->next->write == last->write &&
+               last->next->lba == last->lba + last->count && total + last->next->count <= IDE_MAX_SECTORS) {
+            last = last->next;
+            total += last->count;
+        }
+        ide_queue = last->next;
+        last->next = NULL;
+
+        if (ide_bm_base != 0 && ide_dma_start(ide_active, total) == 0) return;     // completes in __intr_IDE_handler
+        ide_complete(ide_pio(ide_active, total));
+    }
+}
+
+/* ide_init - Initialization of the primary IDE channel
+ *
+ * Finds the bus master registers of the PCI IDE controller and probes both drives.
+ *
+ * Inputs: none
+ * Outputs: none
+ * Side Effects: enables IRQ 14 if DMA can be used
+ */
+void ide_init(void) {
+    uint32_t drive;
+    ide_bm_base = ide_find_bus_master();
+    outb(IDE_CTRL_NIEN, IDE_CTRL);
+    for (drive = 0; drive < IDE_DRIVE_NUM; drive++) {
+        ide_drive_sectors[drive] = ide_identify(drive);
+    }
+    if (ide_bm_base != 0) {
+        outb(0, IDE_CTRL);
+        enable_irq(IDE_IRQ);
+    }
+}
+
+/* ide_dma_done - complete the active DMA batch and start the next one, must be called with interrupts off
+ * Inputs: None
+ * Outputs: None
+ * Side Effects: acknowledges the drive and the controller
+ */
+static void ide_dma_done(void) {
+    uint8_t bm_status;
+    uint8_t status;
+    bm_status = inb(ide_bm_base + IDE_BM_STATUS);
+    outb(0, ide_bm_base + IDE_BM_CMD);                 // stop the engine
+    status = inb(IDE_STATUS);                           // reading the status acknowledges the drive
+    outb(IDE_BM_STATUS_ERR | IDE_BM_STATUS_IRQ, ide_bm_base + IDE_BM_STATUS);
+    ide_complete(((bm_status & IDE_BM_STATUS_ERR) || (status & (IDE_STATUS_ERR | IDE_STATUS_DF))) ? IDE_FAILED : IDE_DONE);
+    ide_start();
+}
+
+/* __intr_IDE_handler - IDE Interrupt Handler
+ *
+ * Completes the active DMA batch and starts the next one. An interrupt left latched
+ * from a batch that ide_wait already polled to completion finds the controller's
+ * interrupt bit clear and is only acknowledged.
+ *
+ * Inputs: None (Triggered by IDE interrupt)
+ * Outputs: None
+ * Side Effects: acknowledges the drive and the controller
+ */
+void __intr_IDE_handler(void) {
+    if (ide_bm_base == 0 || ide_active == NULL || !(inb(ide_bm_base + IDE_BM_STATUS) & IDE_BM_STATUS_IRQ)) {
+        inb(IDE_STATUS);
+        send_eoi(IDE_IRQ);
+        return;
+    }
+    ide_dma_done();
+    send_eoi(IDE_IRQ);
+}
+
+/* ide_submit - queue a request
+ * Inputs: req - the request, it must stay valid until its status is no longer IDE_PENDING
+ * Outputs: 0 if queued, -1 if the request is invalid
+ * Side Effects: the request is started right away if the controller is idle
+ */
+int32_t ide_submit(ide_request_t* req) {
+    uint32_t flags;
+    ide_request_t** pos;
+    ide_request_t* cur;
+    int32_t overlap = 0;
+    if (req == NULL || req->buf == NULL || req->drive >= IDE_DRIVE_NUM || req->count == 0 || req->count > IDE_MAX_SECTORS) return -1;
+    if (req->lba + req->count < req->lba || req->lba + req->count > ide_drive_sectors[req->drive]) return -1;
+    req->status = IDE_PENDING;
+
+    cli_and_save(flags);
+    /* a request overlapping a queued one keeps its place after it */
+    for (cur = ide_queue; cur != NULL; cur = cur->next) {
+        if (cur->drive == req->drive && cur->lba < req->lba + req->count && req->lba < cur->lba + cur->count) overlap = 1;
+    }
+    /* otherwise keep the queue sorted by drive and sector so neighbours can be merged */
+    for (pos = &ide_queue; *pos != NULL; pos = &((*pos)->next)) {
+        if (!overlap && ((*pos)->drive > req->drive || ((*pos)->drive == req->drive && (*pos)->lba > req->lba))) break;
+    }
+    req->next = *pos;
+    *pos = req;
+    ide_start();
+    restore_flags(flags);
+    return 0;
+}
+
+/* ide_wait - wait until a submitted request completes
+ * Inputs: req - the request
+ * Outputs: IDE_DONE or IDE_FAILED
+ * Side Effects: with interrupts off, as while booting, the controller is polled and the DMA batches
+ *               are completed here, otherwise IRQ 14 completes them
+ */
+int32_t ide_wait(ide_request_t* req) {
+    uint32_t flags;
+    cli_and_save(flags);
+    while (req->status == IDE_PENDING && !(flags & EFLAGS_IF)) {
+        if (inb(ide_bm_base + IDE_BM_STATUS) & IDE_BM_STATUS_IRQ) ide_dma_done();
+    }
+    restore_flags(flags);
+    while (req->status == IDE_PENDING);
+    return req->status;
+}
+
+/* ide_transfer - move count sectors synchronously, in commands of at most IDE_MAX_SECTORS
+ * Inputs: drive - 0 for master, 1 for slave
+ *         lba - the first sector
+ *         buf - a kernel buffer
+ *         count - the number of sectors
+ *         write - 1 to write to the disk, 0 to read
+ * Outputs: 0 if successful, -1 if fails
+ * Side Effects: None
+ */
+static int32_t ide_transfer(uint32_t drive, uint32_t lba, uint8_t* buf, uint32_t count, uint32_t write) {
+    ide_request_t req;
+    while (count > 0) {
+        req.drive = drive;
+        req.lba = lba;
+        req.count = (count < IDE_MAX_SECTORS) ? count : IDE_MAX_SECTORS;
+        req.buf = buf;
+        req.write = write;
+        if (ide_submit(&req) == -1 || ide_wait(&req) != IDE_DONE) return -1;
+        lba += req.count;
+        buf += req.count * IDE_SECTOR_SIZE;
+        count -= req.count;
+    }
+    return 0;
+}
+
+/* ide_read - read sectors from a drive
+ * Inputs: drive - 0 for master, 1 for slave
+ *         lba - the first sector
+ *         buf - a kernel buffer of count * IDE_SECTOR_SIZE bytes
+ *         count - the number of sectors
+ * Outputs: 0 if successful, -1 if fails
+ * Side Effects: change buf
+ */
+int32_t ide_read(uint32_t drive, uint32_t lba, void* buf, uint32_t count) {
+    return ide_transfer(drive, lba, (uint8_t*)buf, count, 0);
+}
+
+/* ide_write - write sectors to a drive
+ * Inputs: drive - 0 for master, 1 for slave
+ *         lba - the first sector
+ *         buf - a kernel buffer of count * IDE_SECTOR_SIZE bytes
+ *         count - the number of sectors
+ * Outputs: 0 if successful, -1 if fails
+ * Side Effects: change the disk
+ */
+int32_t ide_write(uint32_t drive, uint32_t lba, const void* buf, uint32_t count) {
+    return ide_transfer(drive, lba, (uint8_t*)buf, count, 1);
+}
+
+/* ide_sectors - get the size of a drive
+ * Inputs: drive - 0 for master, 1 for slave
+ * Outputs: number of sectors, 0 if the drive is not there
+ * Side Effects: None
+ */
+uint32_t ide_sectors(uint32_t drive) {
+    if (drive >= IDE_DRIVE_NUM) return 0;
+    return ide_drive_sectors[drive];
+}
@@ -0,0 +1,117 @@
+#ifndef _IDE_H
+#define _IDE_H
+#include "../types.h"
+
+#define IDE_IRQ             14      // the primary IDE channel will generate IRQ 14
+#define IDE_DRIVE_NUM       2       // master and slave on the primary channel
+
+/* primary channel command block registers */
+#define IDE_DATA            0x1F0
+#define IDE_ERROR           0x1F1
+#define IDE_SECCOUNT        0x1F2
+#define IDE_LBA_LO          0x1F3
+#define IDE_LBA_MID         0x1F4
+#define IDE_LBA_HI          0x1F5
+#define IDE_DRIVE_SEL       0x1F6
+#define IDE_STATUS          0x1F7   // read
+#define IDE_COMMAND         0x1F7   // write
+#define IDE_CTRL            0x3F6
+
+/* status register bits */
+#define IDE_STATUS_ERR      0x01
+#define IDE_STATUS_DRQ      0x08
+#define IDE_STATUS_DF       0x20
+#define IDE_STATUS_DRDY     0x40
+#define IDE_STATUS_BSY      0x80
+#define IDE_STATUS_FLOATING 0xFF    // nothing answers on the bus
+
+/* control register bits */
+#define IDE_CTRL_NIEN       0x02    // no interrupt from the drive
+
+/* drive select: LBA mode, the drive bit and the top 4 bits of the LBA */
+#define IDE_SEL_LBA         0xE0
+#define IDE_SEL_SLAVE_SHIFT 4
+
+/* ATA commands */
+#define IDE_CMD_READ_PIO    0x20
+#define IDE_CMD_WRITE_PIO   0x30
+#define IDE_CMD_READ_DMA    0xC8
+#define IDE_CMD_WRITE_DMA   0xCA
+#define IDE_CMD_FLUSH       0xE7
+#define IDE_CMD_IDENTIFY    0xEC
+
+/* bus master registers, offsets from BAR4 */
+#define IDE_BM_CMD          0x0
+#define IDE_BM_STATUS       0x2
+#define IDE_BM_PRDT         0x4
+#define IDE_BM_CMD_START    0x01
+#define IDE_BM_CMD_READ     0x08    // the controller writes to memory
+#define IDE_BM_STATUS_ERR   0x02
+#define IDE_BM_STATUS_IRQ   0x04
+
+/* PCI configuration space */
+#define PCI_CONFIG_ADDR     0xCF8
+#define PCI_CONFIG_DATA     0xCFC
+#define PCI_ENABLE          0x80000000
+#define PCI_MAX_DEV         32
+#define PCI_MAX_FUNC        8
+#define PCI_VENDOR_NONE     0xFFFF  // vendor id read where no device answers
+#define PCI_COMMAND         0x04
+#define PCI_CLASS           0x08
+#define PCI_BAR4            0x20
+#define PCI_COMMAND_IO      0x0001
+#define PCI_COMMAND_MASTER  0x0004
+#define PCI_CLASS_IDE       0x0101  // mass storage, IDE
+#define PCI_BAR_IO_MASK     0xFFFC
+
+/* transfer limits */
+#define IDE_SECTOR_SIZE     512
+#define IDE_MAX_SECTORS     256     // sectors moved by one command, a count of 0 means 256
+#define IDE_PRD_NUM         32      // entries in the physical region descriptor table
+#define IDE_PRD_MAX_BYTES   0x10000 // a region may not cross a 64KB boundary
+#define IDE_PRD_EOT         0x8000  // last entry of the table
+#define IDE_IDENTIFY_WORDS  256
+#define IDE_ID_SECTORS_LO   60      // identify words holding the LBA28 sector count
+#define IDE_ID_SECTORS_HI   61
+#define IDE_TIMEOUT         1000000 // polls of the status register before giving up
+#define EFLAGS_IF           0x200   // interrupts are enabled
+
+/* request status */
+#define IDE_DONE            0
+#define IDE_FAILED          -1
+#define IDE_PENDING         1
+
+/* a queued transfer, buf must be a kernel address, which is also its physical address */
+typedef struct ide_request ide_request_t;
+struct ide_request {
+    uint32_t drive;             // 0 for master, 1 for slave
+    uint32_t lba;               // first sector
+    uint32_t count;             // number of sectors
+    uint8_t* buf;
+    uint32_t write;             // 1 to write to the disk, 0 to read
+    volatile int32_t status;    // IDE_PENDING until the transfer completes
+    ide_request_t* next;
+};
+
+/* physical region descriptor */
+typedef struct prd {
+    uint32_t addr;
+    uint16_t count;             // 0 means 64KB
+    uint16_t flags;
+} prd_t;
+
+/* Initialize the IDE controller and probe the drives */
+void ide_init(void);
+/* deal with IDE interrupts */
+void __intr_IDE_handler(void);
+/* queue a request, it completes asynchronously */
+int32_t ide_submit(ide_request_t* req);
+/* wait until a submitted request completes */
+int32_t ide_wait(ide_request_t* req);
+/* synchronous transfers */
+int32_t ide_read(uint32_t drive, uint32_t lba, void* buf, uint32_t count);
+int32_t ide_write(uint32_t drive, uint32_t lba, const void* buf, uint32_t count);
+/* number of sectors of a drive, 0 if the drive is not there */
+uint32_t ide_sectors(uint32_t drive);
+
+#endif /* _IDE_H */
@@ -3,8 +3,11 @@
 #include "../lib.h"
 #include "../scheduler.h"
 #include "../signal.h"
+#include "../bcache.h"
+#include "../vdso.h"
 
 int32_t alarm_signal_counter = 0;
+volatile uint32_t pit_ticks = 0;
 
 /* PIT_init - Initialization of Programmable Interval Timer (PIT)
  * 
@@ -30,11 +33,14 @@ void pit_init(void) {
  * Side Effects: Call the scheduler
  */
 void __intr_PIT_handler(void) {
+    pit_ticks++;
+    vdso_tick(pit_ticks);
     alarm_signal_counter++;
     if(alarm_signal_counter >= 1000){
         alarm_signal_counter = 0;
         send_signal_by_pid(SIGNUM_ALARM, 3);
     }
+    bcache_flush_tick();
     send_eoi(PIT_IRQ);
     scheduler();
 }
@@ -1,6 +1,8 @@
 #ifndef _PIT_H
 #define _PIT_H
 
+#include "../types.h"
+
 /* oscillator's freq: 1.193182 MHz, actually 100Hz */
 #define PIT_FREQ 11931  
 
@@ -20,6 +22,9 @@ Bits
 
 #define PIT_IRQ 0
 
+/* interrupts since boot */
+extern volatile uint32_t pit_ticks;
+
 void pit_init(void);
 void __intr_PIT_handler(void);
 
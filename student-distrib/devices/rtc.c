@@ -5,6 +5,8 @@
 #include "../pcb.h"
 #include "../GUI/gui.h"
 #include "../signal.h"
+#include "../fdtable.h"
+#include "../poll.h"
 
 volatile int32_t max_freq = 32;
 volatile int32_t min_rate = 11;
@@ -18,12 +20,14 @@ typedef struct {
 
 static proc_freqcount_pair RTC_proc_list[MAX_PROC_NUM];
 static int GUI_counter;
+static int date_counter;            // RTC interrupts until the date is read again
 
 operation_table_t RTC_operation_table = {
     .open_operation = RTC_open,
     .close_operation = RTC_close,
     .read_operation = RTC_read,
-    .write_operation = RTC_write
+    .write_operation = RTC_write,
+    .poll_operation = RTC_poll
 };
 
 /* RTC_init - Initialization of Real-Time Clock (RTC)
@@ -138,7 +142,11 @@ void __intr_RTC_handler(void) {
     for (pid = 0; pid < MAX_PROC_NUM; ++pid) {
             RTC_proc_list[pid].proc_count --;
     }
-    get_date();
+    /* the date only changes once a second */
+    if(--date_counter <= 0){
+        date_counter = max_freq;
+        get_date();
+    }
     fill_terminal();
     /*if(--GUI_counter == 0) {
         fill_terminal();
@@ -162,21 +170,8 @@ void __intr_RTC_handler(void) {
  *               2. validates the process's id
  */
 int32_t RTC_open(const uint8_t* fd) {
-    int32_t i;
-    pcb_t* cur_pcb = get_current_pcb();
-    file_descriptor_t* cur_fd;
-    for(i = 2; i < NUM_FILES; i++){             // 2 as stdin and stdout already been used
-        cur_fd = &(cur_pcb->fd_array[i]);
-        if(cur_fd->flags == READY_TO_BE_USED){
-            /* if there exists empty file descriptor, assign it */
-            cur_fd->operation_table = &RTC_operation_table;
-            cur_fd->inode_index = 0;
-            cur_fd->file_position = 0;
-            cur_fd->flags = IN_USE;
-            return i;
-        }
-    }
-    return -1;  // if no empty, open fail
+    /* take the lowest free file descriptor, fail if there is none */
+    return fd_alloc(&RTC_operation_table, 0);
 }
 
 /* 
@@ -189,18 +184,25 @@ int32_t RTC_open(const uint8_t* fd) {
  * Side Effects: set the process's id invalid
  */
 int32_t RTC_close(int32_t fd) {
-    pcb_t* cur_pcb = get_current_pcb();
-    file_descriptor_t* cur_fd;
-    /* if if out of boundary, close fail */
-    if(fd < 2 || fd >= NUM_FILES) return -1;
-
-    cur_fd = &(cur_pcb->fd_array[fd]);
+    file_descriptor_t* cur_fd = fd_get(fd);
     /* if that id is invalid, close fail */
-    if(cur_fd->flags != IN_USE || cur_fd->inode_index != 0) return -1;
+    if(cur_fd == NULL || cur_fd->operation_table != &RTC_operation_table) return -1;
 
     /* free that file descriptor if every thing all right */
-    cur_fd->flags = READY_TO_BE_USED;
-    return 0;
+    return (fd_close(fd) == -1) ? -1 : 0;
+}
+
+/* 
+ * Function: RTC_poll
+ * Description: check if a read would return at once for the process
+ * Parameters:
+ *    fd: file descriptor
+ * Returns:
+ *    POLLIN if the next interrupt of the process has come, 0 if not
+ * Side Effects: none
+ */
+int32_t RTC_poll(int32_t fd) {
+    return (RTC_proc_list[get_current_pid()].proc_count > 0) ? 0 : POLLIN;
 }
 
 /* 
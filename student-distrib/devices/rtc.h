@@ -1,6 +1,7 @@
 #ifndef _RTC_H_
 #define _RTC_H_
 #include "../lib.h"
+#include "../filesys.h"
 
 #define RTC_IRQ         8       // the RTC will generate IRQ 8
 
@@ -31,5 +32,8 @@ int32_t RTC_open(const uint8_t* proc_id);
 int32_t RTC_close(int32_t proc_id);
 int32_t RTC_read(int32_t proc_id, void* buf, int32_t nbytes);
 int32_t RTC_write(int32_t proc_id, const void* buf, int32_t nbytes);
+int32_t RTC_poll(int32_t proc_id);
+
+extern operation_table_t RTC_operation_table;
 
 #endif /* _RTC_H_ */
@@ -3,6 +3,8 @@
 
 #include "vt.h"
 #include "../signal.h"
+#include "../fdtable.h"
+#include "../poll.h"
 
 static int32_t VIDEO = 0xB8000;
 #define FOUR_KB     0x1000
@@ -39,7 +41,8 @@ operation_table_t stdin_operation_table = {
     .open_operation = vt_open,
     .close_operation = vt_close,
     .read_operation = vt_read,
-    .write_operation = bad_write_call
+    .write_operation = bad_write_call,
+    .poll_operation = vt_poll
 };
 
 operation_table_t stdout_operation_table = {
@@ -75,6 +78,9 @@ void vt_init(void) {
         vt_state[i].kbd.ctrl = 0;
         vt_state[i].kbd.alt = 0;
         vt_state[i].input_buf_ptr = 0;
+        vt_state[i].key_ring.head = 0;
+        vt_state[i].key_ring.tail = 0;
+        vt_state[i].key_ring.dropped = 0;
         vt_state[i].enter_pressed = 0;
         vt_state[i].active_pid = -1;
         vt_state[i].halt_pending = 0;
@@ -99,33 +105,43 @@ int32_t vt_open(const uint8_t* id) {                        // return 0 as requi
 }
 
 /* vt_close
- *   DESCRIPTION: Close virtual terminal.
- *   INPUTS: none
+ *   DESCRIPTION: Close a file descriptor of the virtual terminal, such as a copy made by dup.
+ *   INPUTS: id - the file descriptor
  *   OUTPUTS: none
- *   RETURN VALUE: none
- *   SIDE EFFECTS: none
+ *   RETURN VALUE: 0 if successful, -1 if id is not open
+ *   SIDE EFFECTS: the terminal itself stays open
  */
-int32_t vt_close(int32_t id) {                              // return 0 as required by checkpoint 2 demo
-    // Do nothing
-    return 0;
+int32_t vt_close(int32_t id) {
+    return (fd_close(id) == -1) ? -1 : 0;
 }
 
+/* vt_read_raw
+ *   DESCRIPTION: Take keys out of the ring of a raw terminal, waiting until there is one.
+ *                The keyboard interrupt may add keys meanwhile, only head is written here.
+ *   INPUTS: buf -- buffer to read into
+ *           nbytes -- number of keys wanted
+ *   OUTPUTS: none
+ *   RETURN VALUE: number of keys read
+ *   SIDE EFFECTS: none
+ */
 static int32_t vt_read_raw(void* buf, int32_t nbytes) {
-    while (vt_state[cur_vt].input_buf_ptr == 0);
-    cli();
+    key_ring_t* ring = &vt_state[cur_vt].key_ring;
+    uint32_t head = ring->head;
+    uint32_t tail;
     int i;
-    for (i = 0; i < nbytes && i < vt_state[cur_vt].input_buf_ptr; i++) {
-        ((char*)buf)[i] = vt_state[cur_vt].input_buf[i];
+    while ((tail = ring->tail) == head);
+    for (i = 0; i < nbytes && head != tail; i++, head++) {
+        ((char*)buf)[i] = ring->keys[head & KEY_RING_MASK];
     }
-    memcpy(vt_state[cur_vt].input_buf, &vt_state[cur_vt].input_buf[i], vt_state[cur_vt].input_buf_ptr - i);
-    vt_state[cur_vt].input_buf_ptr -= i;
-    sti();
+    // the keys must be copied before the interrupt can reuse their slots
+    asm volatile ("" : : : "memory");
+    ring->head = head;
     return i;
 }
 
 /* vt_read
  *   DESCRIPTION: Read from virtual terminal.
- *   INPUTS: fd -- should be 0, which is stdin
+ *   INPUTS: fd -- stdin or a copy of it
  *           buf -- buffer to read into
  *           nbytes -- number of bytes to read
  *   OUTPUTS: none
@@ -133,7 +149,7 @@ static int32_t vt_read_raw(void* buf, int32_t nbytes) {
  *   SIDE EFFECTS: none
  */
 int32_t vt_read(int32_t fd, void* buf, int32_t nbytes) {
-    if (buf == NULL || nbytes < 0 || fd != 0)
+    if (buf == NULL || nbytes < 0)
         return -1;
 
     if (vt_state[cur_vt].raw)
@@ -159,11 +175,25 @@ int32_t vt_read(int32_t fd, void* buf, int32_t nbytes) {
     return i;
 }
 
+/* vt_poll
+ *   DESCRIPTION: Check if a read of the terminal would return at once, a whole line
+ *                is needed unless the terminal is raw.
+ *   INPUTS: fd -- stdin or a copy of it
+ *   OUTPUTS: none
+ *   RETURN VALUE: POLLIN if input is ready, 0 if not
+ *   SIDE EFFECTS: none
+ */
+int32_t vt_poll(int32_t fd) {
+    if (vt_state[cur_vt].raw)
+        return (vt_state[cur_vt].key_ring.head != vt_state[cur_vt].key_ring.tail) ? POLLIN : 0;
+    return vt_state[cur_vt].enter_pressed ? POLLIN : 0;
+}
+
 /* vt_write
  *   DESCRIPTION: Write to virtual terminal.
  *                This syscall does not recognize '\0' as the end of string.
  *                It will simply write nbytes bytes to the screen.
- *   INPUTS: fd -- should be 1, which is stdout
+ *   INPUTS: fd -- stdout or a copy of it
  *           buf -- buffer to write from
  *           nbytes -- number of bytes to write
  *   OUTPUTS: none
@@ -171,7 +201,7 @@ int32_t vt_read(int32_t fd, void* buf, int32_t nbytes) {
  *   SIDE EFFECTS: none
  */
 int32_t vt_write(int32_t fd, const void* buf, int32_t nbytes) {
-    if (buf == NULL || nbytes < 0 || fd != 1)
+    if (buf == NULL || nbytes < 0)
         return -1;
     int i;
     for (i = 0; i < nbytes; i++) {
@@ -408,13 +438,19 @@ static void process_default(keycode_t keycode, int release) {
 }
 
 static inline void vt_keyboard_raw(keycode_t keycode, int release) {
-    if (vt_state[foreground_vt].input_buf_ptr >= INPUT_BUF_SIZE)
+    key_ring_t* ring = &vt_state[foreground_vt].key_ring;
+    uint32_t tail = ring->tail;
+    if (tail - ring->head >= KEY_RING_SIZE) {
+        ring->dropped++;
         return;
+    }
     if (release) {
         keycode |= 0x80;
     }
-    vt_state[foreground_vt].input_buf[vt_state[foreground_vt].input_buf_ptr] = keycode;
-    vt_state[foreground_vt].input_buf_ptr++;
+    ring->keys[tail & KEY_RING_MASK] = keycode;
+    // the key must be in place before the reader sees the new tail
+    asm volatile ("" : : : "memory");
+    ring->tail = tail + 1;
 }
 
 /* vt_keyboard
@@ -651,6 +687,8 @@ void command_completion(){
 
 int32_t vt_ioctl(int32_t flag) {
     if (flag == 1) {
+        // drop keys left from an earlier raw program, the reader owns head
+        vt_state[cur_vt].key_ring.head = vt_state[cur_vt].key_ring.tail;
         vt_state[cur_vt].raw = 1;
     } else {
         vt_state[cur_vt].raw = 0;
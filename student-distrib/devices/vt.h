@@ -13,12 +13,15 @@
 #define NUM_TERMS 3
 #define NUM_CMDS 11
 #define NUM_HIST 10
+#define KEY_RING_SIZE 128       // keys a raw terminal holds, a power of 2
+#define KEY_RING_MASK (KEY_RING_SIZE - 1)
 
 extern void vt_init();
 extern int32_t vt_open(const uint8_t* id);
 extern int32_t vt_close(int32_t id);
 extern int32_t vt_read(int32_t fd, void* buf, int32_t nbytes);
 extern int32_t vt_write(int32_t fd, const void* buf, int32_t nbytes);
+extern int32_t vt_poll(int32_t fd);
 extern void vt_keyboard(keycode_t keycode, int release);
 void vt_putc(char c, int kdb);
 extern int32_t bad_read_call(int32_t fd, void* buf, int32_t nbytes);
@@ -38,12 +41,22 @@ extern operation_table_t stdin_operation_table;
 extern operation_table_t stdout_operation_table;
 
 
+/* keys of a raw terminal, the keyboard interrupt only moves tail and the reader only moves
+ * head, so neither needs interrupts off, each index only grows and is taken modulo the size */
+typedef struct {
+    uint8_t keys[KEY_RING_SIZE];
+    volatile uint32_t head;
+    volatile uint32_t tail;
+    volatile uint32_t dropped;  // keys lost while the ring was full
+} key_ring_t;
+
 typedef struct {
     int screen_x;
     int screen_y;
     char* video_mem;
     keyboard_state_t kbd;
     char input_buf[INPUT_BUF_SIZE]; // Temporary buffer for storing user input
+    key_ring_t key_ring; // raw mode input
     volatile int input_buf_ptr;
     volatile int enter_pressed;
     char user_buf[INPUT_BUF_SIZE]; // Buffer for storing user input after enter is pressed
@@ -0,0 +1,292 @@
+/* fdtable.c - per-process file descriptor tables over shared, reference counted open files
+ * vim:ts=4 noexpandtab
+ */
+
+#include "fdtable.h"
+#include "lib.h"
+
+/* every open file of the system, free while refcnt is 0 */
+static file_descriptor_t open_files[MAX_OPEN_FILES];
+
+/* the grown table of each pid, used once a process needs more than NUM_FILES fds */
+static file_descriptor_t* fd_ext[MAX_PID_NUM][MAX_FILES];
+
+/* fd_table_init
+ *
+ * set up the table of a new process with nothing open, it starts with the NUM_FILES slots in the pcb
+ * Inputs: pcb - the new process
+ * Outputs: None
+ * Side Effects: None
+ */
+void fd_table_init(pcb_t* pcb){
+    uint32_t i;
+    for(i = 0; i < NUM_FILES; i++){
+        pcb->fd_inline[i] = NULL;
+    }
+    for(i = 0; i < FD_BITMAP_WORDS; i++){
+        pcb->fd_bitmap[i] = 0;
+    }
+    pcb->fd_array = pcb->fd_inline;
+    pcb->fd_max = NUM_FILES;
+}
+
+/* fd_grow
+ *
+ * move the table of a process from the pcb to its grown table of MAX_FILES slots
+ * Inputs: pcb - the process
+ * Outputs: 0 if successful, -1 if the table is already grown
+ * Side Effects: None
+ */
+static int32_t fd_grow(pcb_t* pcb){
+    uint32_t i;
+    file_descriptor_t** table = fd_ext[pcb->pid];
+    if(pcb->fd_array != pcb->fd_inline) return -1;
+    for(i = 0; i < MAX_FILES; i++){
+        table[i] = (i < NUM_FILES) ? pcb->fd_inline[i] : NULL;
+    }
+    pcb->fd_array = table;
+    pcb->fd_max = MAX_FILES;
+    return 0;
+}
+
+/* fd_find_slot
+ *
+ * find the lowest free fd not below min with the bitmap, a word of used fds is skipped at once
+ * Inputs: pcb - the process
+ *         min - the lowest fd wanted
+ * Outputs: the fd, -1 if every fd is in use
+ * Side Effects: the table grows if the free fd is past its end
+ */
+static int32_t fd_find_slot(pcb_t* pcb, uint32_t min){
+    uint32_t i;
+    uint32_t free_bits;
+    uint32_t fd;
+    for(i = min / BITMAP_WORD_BITS; i < FD_BITMAP_WORDS; i++){
+        free_bits = ~pcb->fd_bitmap[i];
+        if(i == min / BITMAP_WORD_BITS) free_bits &= ~((1U << (min % BITMAP_WORD_BITS)) - 1);
+        if(free_bits == 0) continue;
+        fd = i * BITMAP_WORD_BITS + bsf(free_bits);
+        if(fd >= pcb->fd_max && fd_grow(pcb) == -1) return -1;
+        return fd;
+    }
+    return -1;
+}
+
+/* fd_install
+ *
+ * point a free fd at an open file
+ * Inputs: pcb - the process
+ *         fd - the free fd, less than fd_max
+ *         file - the open file
+ * Outputs: None
+ * Side Effects: None
+ */
+static void fd_install(pcb_t* pcb, uint32_t fd, file_descriptor_t* file){
+    pcb->fd_array[fd] = file;
+    pcb->fd_bitmap[fd / BITMAP_WORD_BITS] |= (1U << (fd % BITMAP_WORD_BITS));
+}
+
+/* fd_drop
+ *
+ * clear an fd and drop its reference to the open file
+ * Inputs: pcb - the process
+ *         fd - the fd
+ * Outputs: the references left to the open file, -1 if the fd is not open
+ * Side Effects: the open file is freed with its last reference
+ */
+static int32_t fd_drop(pcb_t* pcb, int32_t fd){
+    uint32_t flags;
+    int32_t refcnt;
+    file_descriptor_t* file = fd_get_pcb(pcb, fd);
+    if(file == NULL) return -1;
+    pcb->fd_array[fd] = NULL;
+    pcb->fd_bitmap[fd / BITMAP_WORD_BITS] &= ~(1U << (fd % BITMAP_WORD_BITS));
+
+    cli_and_save(flags);
+    refcnt = --file->refcnt;
+    if(refcnt == 0) file->flags = READY_TO_BE_USED;
+    restore_flags(flags);
+    return refcnt;
+}
+
+/* fd_table_release
+ *
+ * close everything a process has open through the close operation of each file,
+ * so the files shared with other processes only lose one reference
+ * Inputs: pcb - the process, must be the current one
+ * Outputs: None
+ * Side Effects: None
+ */
+void fd_table_release(pcb_t* pcb){
+    uint32_t i;
+    file_descriptor_t* file;
+    for(i = 0; i < pcb->fd_max; i++){
+        file = pcb->fd_array[i];
+        if(file == NULL) continue;
+        file->operation_table->close_operation(i);
+        /* the operation may refuse, the fd goes anyway */
+        fd_drop(pcb, i);
+    }
+    fd_table_init(pcb);
+}
+
+/* fd_table_inherit
+ *
+ * give a new process the fds of its parent, each at the same number and sharing the open file
+ * Inputs: pcb - the new process
+ *         parent - the process it is started from
+ * Outputs: None
+ * Side Effects: None
+ */
+void fd_table_inherit(pcb_t* pcb, pcb_t* parent){
+    uint32_t i;
+    uint32_t flags;
+    file_descriptor_t* file;
+    fd_table_init(pcb);
+    for(i = 0; i < parent->fd_max; i++){
+        file = parent->fd_array[i];
+        if(file == NULL) continue;
+        if(i >= pcb->fd_max) fd_grow(pcb);
+        cli_and_save(flags);
+        file->refcnt++;
+        restore_flags(flags);
+        fd_install(pcb, i, file);
+    }
+}
+
+/* fd_get_pcb
+ *
+ * get the open file behind an fd of a process
+ * Inputs: pcb - the process
+ *         fd - the fd
+ * Outputs: the open file, NULL if the fd is out of range or not open
+ * Side Effects: None
+ */
+file_descriptor_t* fd_get_pcb(pcb_t* pcb, int32_t fd){
+    if(fd < 0 || (uint32_t)fd >= pcb->fd_max) return NULL;
+    return pcb->fd_array[fd];
+}
+
+/* fd_get
+ *
+ * get the open file behind an fd of the current process
+ * Inputs: fd - the fd
+ * Outputs: the open file, NULL if the fd is out of range or not open
+ * Side Effects: None
+ */
+file_descriptor_t* fd_get(int32_t fd){
+    return fd_get_pcb(get_current_pcb(), fd);
+}
+
+/* fd_alloc_pcb
+ *
+ * open a new file at the lowest free fd of a process
+ * Inputs: pcb - the process
+ *         operation_table - the operations of the file type
+ *         inode_index - the inode of the file, 0 for other types
+ * Outputs: the fd, -1 if the process or the system has too many files open
+ * Side Effects: None
+ */
+int32_t fd_alloc_pcb(pcb_t* pcb, operation_table_t* operation_table, uint32_t inode_index){
+    uint32_t i;
+    uint32_t flags;
+    int32_t fd;
+    file_descriptor_t* file = NULL;
+
+    fd = fd_find_slot(pcb, 0);
+    if(fd == -1) return -1;
+
+    cli_and_save(flags);
+    for(i = 0; i < MAX_OPEN_FILES; i++){
+        if(open_files[i].refcnt == 0){
+            file = &(open_files[i]);
+            file->refcnt = 1;
+            break;
+        }
+    }
+    restore_flags(flags);
+    if(file == NULL) return -1;
+
+    file->operation_table = operation_table;
+    file->inode_index = inode_index;
+    file->file_position = 0;
+    file->flags = IN_USE;
+    fd_install(pcb, fd, file);
+    return fd;
+}
+
+/* fd_alloc
+ *
+ * open a new file at the lowest free fd of the current process
+ * Inputs: operation_table - the operations of the file type
+ *         inode_index - the inode of the file, 0 for other types
+ * Outputs: the fd, -1 if too many files are open
+ * Side Effects: None
+ */
+int32_t fd_alloc(operation_table_t* operation_table, uint32_t inode_index){
+    return fd_alloc_pcb(get_current_pcb(), operation_table, inode_index);
+}
+
+/* fd_close
+ *
+ * drop an fd of the current process, called by the close operation of each file type
+ * Inputs: fd - the fd
+ * Outputs: the references left to the open file, 0 if it was the last one, -1 if the fd is not open
+ * Side Effects: the open file is freed with its last reference
+ */
+int32_t fd_close(int32_t fd){
+    return fd_drop(get_current_pcb(), fd);
+}
+
+/* fd_dup
+ *
+ * make the lowest free fd share the open file of another, with its position
+ * Inputs: oldfd - the fd to copy
+ * Outputs: the new fd, -1 if oldfd is not open or every fd is in use
+ * Side Effects: None
+ */
+int32_t fd_dup(int32_t oldfd){
+    uint32_t flags;
+    int32_t fd;
+    pcb_t* pcb = get_current_pcb();
+    file_descriptor_t* file = fd_get_pcb(pcb, oldfd);
+    if(file == NULL) return -1;
+    fd = fd_find_slot(pcb, 0);
+    if(fd == -1) return -1;
+
+    cli_and_save(flags);
+    file->refcnt++;
+    restore_flags(flags);
+    fd_install(pcb, fd, file);
+    return fd;
+}
+
+/* fd_dup2
+ *
+ * make newfd share the open file of oldfd, whatever newfd had open is closed first
+ * Inputs: oldfd - the fd to copy
+ *         newfd - the fd to set, less than MAX_FILES
+ * Outputs: newfd, -1 if oldfd is not open or newfd is out of range
+ * Side Effects: None
+ */
+int32_t fd_dup2(int32_t oldfd, int32_t newfd){
+    uint32_t flags;
+    pcb_t* pcb = get_current_pcb();
+    file_descriptor_t* file = fd_get_pcb(pcb, oldfd);
+    file_descriptor_t* old_file;
+    if(file == NULL || newfd < 0 || newfd >= MAX_FILES) return -1;
+    if(oldfd == newfd) return newfd;
+    if((uint32_t)newfd >= pcb->fd_max && fd_grow(pcb) == -1) return -1;
+
+    old_file = fd_get_pcb(pcb, newfd);
+    if(old_file != NULL){
+        old_file->operation_table->close_operation(newfd);
+        fd_drop(pcb, newfd);
+    }
+
+    cli_and_save(flags);
+    file->refcnt++;
+    restore_flags(flags);
+    fd_install(pcb, newfd, file);
+    return newfd;
+}
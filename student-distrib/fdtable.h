@@ -0,0 +1,35 @@
+/* fdtable.h - Defines the per-process file descriptor tables and the open files they share
+ * vim:ts=4 noexpandtab
+ */
+
+#ifndef _FDTABLE_H
+#define _FDTABLE_H
+
+#include "types.h"
+#include "filesys.h"
+#include "pcb.h"
+
+#define MAX_OPEN_FILES 128      // open files in the whole system, shared by the fds pointing at them
+
+/* set up the table of a new process with nothing open */
+void fd_table_init(pcb_t* pcb);
+/* start a new process with the fds of its parent */
+void fd_table_inherit(pcb_t* pcb, pcb_t* parent);
+/* close everything a process has open */
+void fd_table_release(pcb_t* pcb);
+
+/* get the open file behind an fd, NULL if the fd is not open */
+file_descriptor_t* fd_get(int32_t fd);
+file_descriptor_t* fd_get_pcb(pcb_t* pcb, int32_t fd);
+
+/* open a new file at the lowest free fd */
+int32_t fd_alloc(operation_table_t* operation_table, uint32_t inode_index);
+int32_t fd_alloc_pcb(pcb_t* pcb, operation_table_t* operation_table, uint32_t inode_index);
+/* drop an fd, the open file goes away with its last fd */
+int32_t fd_close(int32_t fd);
+
+/* make another fd for the same open file */
+int32_t fd_dup(int32_t oldfd);
+int32_t fd_dup2(int32_t oldfd, int32_t newfd);
+
+#endif /* _FDTABLE_H */
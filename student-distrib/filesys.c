@@ -1,4 +1,4 @@
-/* filesys.c - implement the read-only file system
+/* filesys.c - implement the file system
  * vim:ts=4 noexpandtab
  */
 
@@ -6,15 +6,39 @@
 #include "x86_desc.h"
 #include "filesys.h"
 #include "pcb.h"
+#include "bcache.h"
+#include "devices/rtc.h"
+#include "fdtable.h"
 
 
-/* global variables for file system */
-boot_block_t* boot_block;
-dentry_t* dentries;
-inode_t* inodes;
-data_block_t* datablocks;
-int num_db;
-int occupy_db[64];
+/* the image as a block device, the boot block, the inodes and the data blocks all go
+ * through the buffer cache, so sync and the flusher write every change back */
+static blkdev_t fs_dev;
+
+/* sizes of the image, read from the boot block at mount, they never change */
+static uint32_t fs_inodes_num;
+static uint32_t fs_data_blocks_num;
+
+/* free data block bitmap, one bit per data block, set if the block is in use */
+static uint32_t db_bitmap[MAX_DATA_BLOCK_NUM / BITMAP_WORD_BITS];
+static uint32_t db_bitmap_words;
+
+/* free inode bitmap, one bit per inode, set if a dentry uses the inode */
+static uint32_t inode_bitmap[MAX_INODE_NUM / BITMAP_WORD_BITS];
+
+/* set for the inodes that hold a directory, including ROOT_DIR_INODE */
+static uint8_t dir_inode[MAX_INODE_NUM];
+
+/* hashed index from file name to dentry index of the root, built at filesys_init */
+static int32_t dentry_hash_table[DENTRY_HASH_SIZE];
+
+/* small cache of names recently looked up in the root and not found */
+static uint8_t neg_cache_name[NEG_CACHE_SIZE][MAX_FILE_NAME];
+static uint32_t neg_cache_hash[NEG_CACHE_SIZE];
+static uint32_t neg_cache_next = 0;
+
+/* per-component lookup cache for the directories other than the root */
+static dcache_entry_t dcache[DCACHE_SIZE];
 
 operation_table_t file_operation_table = {
     .open_operation = fopen,
@@ -30,47 +54,738 @@ operation_table_t dir_operation_table = {
     .write_operation = dir_write
 };
 
+/* fs_ide_probe
+ *
+ * point fs_dev at an IDE drive if the drive holds an image, recognised by a boot block
+ * that lists the root's "." first and sizes that fit the drive and the in-memory indexes
+ * Inputs: drive - 0 for master, 1 for slave
+ * Outputs: 0 if fs_dev is set up over the drive, -1 if the drive is not there or holds no image
+ * Side Effects: change fs_dev, the first sector is read without the buffer cache
+ */
+static int32_t fs_ide_probe(uint32_t drive){
+    uint16_t sector[IDE_SECTOR_SIZE / 2];   // word aligned for DMA
+    const boot_block_t* boot = (const boot_block_t*)sector;    // the statistics and the first dentries
+    if(ide_blkdev_init(&fs_dev, drive, 0) == -1) return -1;
+    if(ide_read(drive, 0, sector, 1) == -1) return -1;
+    if(boot->dir_entry_num == 0 || boot->dir_entry_num > MAX_FILE_NUM) return -1;
+    if(boot->inodes_num == 0 || boot->inodes_num > MAX_INODE_NUM || boot->data_blocks_num > MAX_DATA_BLOCK_NUM) return -1;
+    if(1 + boot->inodes_num + boot->data_blocks_num > fs_dev.num_blocks) return -1;
+    if(boot->dentries[0].file_type != DIR_FILE_TYPE || boot->dentries[0].inode_index != ROOT_DIR_INODE ||
+       strncmp((const int8_t*)boot->dentries[0].file_name, (const int8_t*)".", MAX_FILE_NAME) != 0) return -1;
+    fs_inodes_num = boot->inodes_num;
+    fs_data_blocks_num = boot->data_blocks_num;
+    return 0;
+}
+
 /* filesys_init
  *
- * initialize the file system with given in memory boot block
- * Inputs: in_memory_boot_block - the given boot block
+ * initialize the file system on the image of FS_IDE_DRIVE, so changes outlive a reboot,
+ * or on the given in memory image if the drive holds none
+ * Inputs: in_memory_boot_block - the boot block of the image loaded as a multiboot module
  * Outputs: none
  * Side Effects: None
  */
 void filesys_init(boot_block_t* in_memory_boot_block){
-    boot_block = in_memory_boot_block;
-    dentries = boot_block->dentries;
-    inodes = (inode_t*)(boot_block + 1);    // inodes following the boot_block
-    datablocks = (data_block_t*)(inodes + boot_block->inodes_num); // data blocks following the inodes
+    if(fs_ide_probe(FS_IDE_DRIVE) == -1){
+        fs_inodes_num = in_memory_boot_block->inodes_num;
+        fs_data_blocks_num = in_memory_boot_block->data_blocks_num;
+        ramdisk_init(&fs_dev, (uint8_t*)in_memory_boot_block, 1 + fs_inodes_num + fs_data_blocks_num);
+    }
+    dentry_index_build();
+    db_bitmap_build();
+    inode_bitmap_build();
     return;
 }
 
+/* boot_get
+ *
+ * hold the boot block, with the statistics and the root's dentries
+ * Inputs: buf - filled with the buffer to give back with brelse, after bdirty if it was changed
+ * Outputs: the boot block, NULL if it cannot be read
+ * Side Effects: None
+ */
+static boot_block_t* boot_get(buf_t** buf){
+    *buf = bread(&fs_dev, FS_BOOT_BLOCK);
+    return (*buf == NULL) ? NULL : (boot_block_t*)(*buf)->data;
+}
+
+/* inode_get
+ *
+ * hold an inode, each takes a whole block right after the boot block
+ * Inputs: inode - the inode index, less than fs_inodes_num
+ *         buf - filled with the buffer to give back with brelse, after bdirty if it was changed
+ * Outputs: the inode, NULL if it cannot be read
+ * Side Effects: None
+ */
+static inode_t* inode_get(uint32_t inode, buf_t** buf){
+    *buf = bread(&fs_dev, FS_BOOT_BLOCK + 1 + inode);
+    return (*buf == NULL) ? NULL : (inode_t*)(*buf)->data;
+}
+
+/* filename_hash
+ *
+ * FNV-1a hash of a file name, stopping at '\0' or MAX_FILE_NAME bytes
+ * since names in dentries are not terminated when they are exactly 32 bytes long
+ * Inputs: fname - the file name to hash
+ * Outputs: the 32-bit hash value
+ * Side Effects: None
+ */
+uint32_t filename_hash(const uint8_t* fname){
+    uint32_t i;
+    uint32_t hash = FNV_OFFSET_BASIS;
+    for(i = 0; i < MAX_FILE_NAME && fname[i] != '\0'; i++){
+        hash ^= fname[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+/* dentry_index_build
+ *
+ * (re)build the hashed name index over all dentries in the boot block and drop
+ * every cached lookup, must be called whenever dentries are added or removed in any directory
+ * Inputs: None
+ * Outputs: None
+ * Side Effects: overwrite dentry_hash_table, the negative lookup cache and the lookup cache,
+ *               the index stays empty if the boot block cannot be read
+ */
+void dentry_index_build(void){
+    uint32_t i;
+    uint32_t slot;
+    buf_t* buf;
+    boot_block_t* boot = boot_get(&buf);
+    for(i = 0; i < DENTRY_HASH_SIZE; i++){
+        dentry_hash_table[i] = -1;
+    }
+    for(i = 0; boot != NULL && i < boot->dir_entry_num && i < MAX_FILE_NUM; i++){
+        /* linear probing, the table is always at least half empty */
+        slot = filename_hash(boot->dentries[i].file_name) & (DENTRY_HASH_SIZE - 1);
+        while(dentry_hash_table[slot] != -1){
+            slot = (slot + 1) & (DENTRY_HASH_SIZE - 1);
+        }
+        dentry_hash_table[slot] = i;
+    }
+    if(boot != NULL) brelse(buf);
+    memset(neg_cache_name, 0, sizeof(neg_cache_name));
+    neg_cache_next = 0;
+    for(i = 0; i < DCACHE_SIZE; i++){
+        dcache[i].index = -1;
+    }
+}
+
+/* inode_size
+ *
+ * get the length in bytes of a file
+ * Inputs: cur_inode - the inode
+ * Outputs: the length without the INODE_INLINE flag
+ * Side Effects: None
+ */
+static uint32_t inode_size(const inode_t* cur_inode){
+    return cur_inode->length & ~INODE_INLINE;
+}
+
+/* inode_blocks
+ *
+ * get the number of data blocks a file owns
+ * Inputs: cur_inode - the inode
+ * Outputs: the number of blocks, 0 for a file held inline
+ * Side Effects: None
+ */
+static uint32_t inode_blocks(const inode_t* cur_inode){
+    if(cur_inode->length & INODE_INLINE) return 0;
+    return (cur_inode->length + BLOCK_SIZE - 1) / BLOCK_SIZE;
+}
+
+/* inode_length
+ *
+ * get the length in bytes of a file by its inode index
+ * Inputs: inode - the inode index, less than fs_inodes_num
+ * Outputs: the length, 0 if the inode cannot be read
+ * Side Effects: None
+ */
+static uint32_t inode_length(uint32_t inode){
+    buf_t* buf;
+    inode_t* cur_inode = inode_get(inode, &buf);
+    uint32_t length;
+    if(cur_inode == NULL) return 0;
+    length = inode_size(cur_inode);
+    brelse(buf);
+    return length;
+}
+
+/* dir_size
+ *
+ * get the number of dentries in a directory
+ * Inputs: dir - the inode of the directory, ROOT_DIR_INODE for the root
+ * Outputs: the number of dentries, 0 if the directory cannot be read
+ * Side Effects: None
+ */
+static uint32_t dir_size(uint32_t dir){
+    buf_t* buf;
+    boot_block_t* boot;
+    uint32_t size;
+    if(dir == ROOT_DIR_INODE){
+        boot = boot_get(&buf);
+        if(boot == NULL) return 0;
+        size = (boot->dir_entry_num < MAX_FILE_NUM) ? boot->dir_entry_num : MAX_FILE_NUM;
+        brelse(buf);
+        return size;
+    }
+    return inode_length(dir) / DIR_ENTRY_SIZE;
+}
+
+/* fs_block
+ *
+ * get the device block of a data block, the boot block and the inodes come first in the image
+ * Inputs: index - the data block index
+ * Outputs: the block number on fs_dev
+ * Side Effects: None
+ */
+static uint32_t fs_block(uint32_t index){
+    return FS_BOOT_BLOCK + 1 + fs_inodes_num + index;
+}
+
+/* dir_entry_read
+ *
+ * copy a dentry of a directory out, the root's dentries are in the boot block and
+ * every other directory keeps DENTRIES_PER_BLOCK dentries in its data blocks
+ * Inputs: dir - the inode of the directory, ROOT_DIR_INODE for the root
+ *         index - the index of the dentry, less than dir_size(dir)
+ *         cur_dentry - filled with the dentry
+ * Outputs: 0 if successful, -1 if the block cannot be read
+ * Side Effects: None
+ */
+static int32_t dir_entry_read(uint32_t dir, uint32_t index, dentry_t* cur_dentry){
+    buf_t* buf;
+    boot_block_t* boot;
+    if(dir == ROOT_DIR_INODE){
+        boot = boot_get(&buf);
+        if(boot == NULL) return -1;
+        memcpy(cur_dentry, &(boot->dentries[index]), sizeof(dentry_t));
+        brelse(buf);
+        return 0;
+    }
+    return (read_data(dir, index * DIR_ENTRY_SIZE, (uint8_t*)cur_dentry, sizeof(dentry_t)) == sizeof(dentry_t)) ? 0 : -1;
+}
+
+/* dir_entry_write
+ *
+ * overwrite a dentry of a directory
+ * Inputs: dir - the inode of the directory, ROOT_DIR_INODE for the root
+ *         index - the index of the dentry, less than dir_size(dir)
+ *         cur_dentry - the new dentry
+ * Outputs: 0 if successful, -1 if the block cannot be written
+ * Side Effects: change the directory
+ */
+static int32_t dir_entry_write(uint32_t dir, uint32_t index, const dentry_t* cur_dentry){
+    buf_t* buf;
+    boot_block_t* boot;
+    if(dir == ROOT_DIR_INODE){
+        boot = boot_get(&buf);
+        if(boot == NULL) return -1;
+        memcpy(&(boot->dentries[index]), cur_dentry, sizeof(dentry_t));
+        bdirty(buf);
+        brelse(buf);
+        return 0;
+    }
+    return (write_data(dir, index * DIR_ENTRY_SIZE, (const uint8_t*)cur_dentry, sizeof(dentry_t)) == sizeof(dentry_t)) ? 0 : -1;
+}
+
+/* is_dot_name
+ *
+ * check if a name is "." or ".."
+ * Inputs: name - the name to check
+ * Outputs: 1 if it is, 0 if not
+ * Side Effects: None
+ */
+static int32_t is_dot_name(const uint8_t* name){
+    return name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'));
+}
+
+/* dentry_has_inode
+ *
+ * check if a dentry owns an inode, that is a regular file or a directory other than the root
+ * Inputs: cur_dentry - the dentry to check
+ * Outputs: 1 if it does, 0 if not
+ * Side Effects: None
+ */
+static int32_t dentry_has_inode(const dentry_t* cur_dentry){
+    if(cur_dentry->inode_index >= fs_inodes_num) return 0;
+    if(cur_dentry->file_type == REGULAR_FILE_TYPE) return 1;
+    return cur_dentry->file_type == DIR_FILE_TYPE && cur_dentry->inode_index != ROOT_DIR_INODE;
+}
+
+/* dentry_length
+ *
+ * get the length in bytes of what a dentry names
+ * Inputs: cur_dentry - the dentry
+ * Outputs: the length of its inode, the size of the root's dentries, or 0 for devices
+ * Side Effects: None
+ */
+static uint32_t dentry_length(const dentry_t* cur_dentry){
+    if(dentry_has_inode(cur_dentry)) return inode_length(cur_dentry->inode_index);
+    if(cur_dentry->file_type == DIR_FILE_TYPE) return dir_size(ROOT_DIR_INODE) * DIR_ENTRY_SIZE;
+    return 0;
+}
+
+/* dir_walk
+ *
+ * call visit on every dentry of the tree except "." and "..", directories are
+ * visited breadth first so the walk needs no recursion on the kernel stack
+ * Inputs: visit - the function called on each dentry
+ * Outputs: None
+ * Side Effects: whatever visit does
+ */
+static void dir_walk(void (*visit)(const dentry_t* cur_dentry)){
+    static uint32_t queue[MAX_INODE_NUM];
+    uint32_t head = 0;
+    uint32_t tail = 0;
+    uint32_t i, dir, size;
+    dentry_t cur_dentry;
+
+    queue[tail++] = ROOT_DIR_INODE;
+    while(head < tail){
+        dir = queue[head++];
+        size = dir_size(dir);
+        for(i = 0; i < size; i++){
+            if(dir_entry_read(dir, i, &cur_dentry) == -1) break;
+            if(is_dot_name(cur_dentry.file_name)) continue;
+            visit(&cur_dentry);
+            if(cur_dentry.file_type == DIR_FILE_TYPE && dentry_has_inode(&cur_dentry) && tail < MAX_INODE_NUM){
+                queue[tail++] = cur_dentry.inode_index;
+            }
+        }
+    }
+}
+
+/* db_mark
+ *
+ * mark a data block as used or free in the free block bitmap
+ * Inputs: index - the data block index
+ *         used - 1 to mark it used, 0 to mark it free
+ * Outputs: None
+ * Side Effects: change db_bitmap
+ */
+static void db_mark(uint32_t index, int32_t used){
+    if(index >= MAX_DATA_BLOCK_NUM) return;
+    if(used){
+        db_bitmap[index / BITMAP_WORD_BITS] |= (1U << (index % BITMAP_WORD_BITS));
+    } else {
+        db_bitmap[index / BITMAP_WORD_BITS] &= ~(1U << (index % BITMAP_WORD_BITS));
+    }
+}
+
+/* db_visit
+ *
+ * mark the data blocks of the inode owned by a dentry as used
+ * Inputs: cur_dentry - the dentry
+ * Outputs: None
+ * Side Effects: change db_bitmap
+ */
+static void db_visit(const dentry_t* cur_dentry){
+    uint32_t j;
+    uint32_t num_blocks;
+    inode_t* cur_inode;
+    buf_t* buf;
+    if(!dentry_has_inode(cur_dentry)) return;
+    cur_inode = inode_get(cur_dentry->inode_index, &buf);
+    if(cur_inode == NULL) return;
+    num_blocks = inode_blocks(cur_inode);
+    for(j = 0; j < num_blocks && j < MAX_FILE_BLOCKS; j++){
+        db_mark(cur_inode->data_block_index[j], 1);
+    }
+    brelse(buf);
+}
+
+/* db_bitmap_build
+ *
+ * build the free block bitmap from the data blocks of every file and directory in the tree,
+ * blocks past the end of the image are marked used so they are never handed out
+ * Inputs: None
+ * Outputs: None
+ * Side Effects: overwrite db_bitmap
+ */
+void db_bitmap_build(void){
+    uint32_t i;
+
+    memset(db_bitmap, 0, sizeof(db_bitmap));
+    for(i = fs_data_blocks_num; i < MAX_DATA_BLOCK_NUM; i++){
+        db_mark(i, 1);
+    }
+    db_bitmap_words = (fs_data_blocks_num + BITMAP_WORD_BITS - 1) / BITMAP_WORD_BITS;
+    if(db_bitmap_words > MAX_DATA_BLOCK_NUM / BITMAP_WORD_BITS) db_bitmap_words = MAX_DATA_BLOCK_NUM / BITMAP_WORD_BITS;
+
+    dir_walk(db_visit);
+}
+
+/* db_alloc
+ *
+ * allocate one free data block, scanning the bitmap a word at a time
+ * Inputs: None
+ * Outputs: the allocated data block index, -1 if the image is full
+ * Side Effects: mark the block used
+ */
+static int32_t db_alloc(void){
+    uint32_t i;
+    uint32_t index;
+    for(i = 0; i < db_bitmap_words; i++){
+        if(db_bitmap[i] == BITMAP_WORD_FULL) continue;
+        /* the lowest clear bit of the word is the lowest set bit of its complement */
+        index = i * BITMAP_WORD_BITS + bsf(~db_bitmap[i]);
+        db_mark(index, 1);
+        return index;
+    }
+    return -1;
+}
+
+/* db_alloc_run
+ *
+ * allocate count contiguous free data blocks with first fit, whole free or used words are skipped at once
+ * Inputs: count - the number of blocks wanted
+ * Outputs: index of the first block of the run, -1 if no run is long enough
+ * Side Effects: mark the blocks of the run used
+ */
+static int32_t db_alloc_run(uint32_t count){
+    uint32_t i, j;
+    uint32_t run_start = 0;
+    uint32_t run_len = 0;
+    if(count == 0) return -1;
+
+    for(i = 0; i < db_bitmap_words && run_len < count; i++){
+        if(db_bitmap[i] == BITMAP_WORD_FULL){
+            run_len = 0;
+            continue;
+        }
+        if(db_bitmap[i] == 0){
+            if(run_len == 0) run_start = i * BITMAP_WORD_BITS;
+            run_len += BITMAP_WORD_BITS;
+            continue;
+        }
+        for(j = 0; j < BITMAP_WORD_BITS && run_len < count; j++){
+            if(db_bitmap[i] & (1U << j)){
+                run_len = 0;
+            } else {
+                if(run_len == 0) run_start = i * BITMAP_WORD_BITS + j;
+                run_len++;
+            }
+        }
+    }
+    if(run_len < count) return -1;
+
+    for(i = 0; i < count; i++){
+        db_mark(run_start + i, 1);
+    }
+    return run_start;
+}
+
+/* db_free_file_blocks
+ *
+ * release the data blocks of an inode starting at block "from" of the file
+ * Inputs: cur_inode - the inode
+ *         from - the first block of the file to release
+ * Outputs: None
+ * Side Effects: change db_bitmap, the released indices are zeroed in the inode
+ */
+static void db_free_file_blocks(inode_t* cur_inode, uint32_t from){
+    uint32_t i;
+    uint32_t num_blocks = inode_blocks(cur_inode);
+    for(i = from; i < num_blocks && i < MAX_FILE_BLOCKS; i++){
+        db_mark(cur_inode->data_block_index[i], 0);
+        cur_inode->data_block_index[i] = 0;
+    }
+}
+
+/* db_alloc_file_blocks
+ *
+ * give blocks [from, to) of an inode fresh data blocks, contiguous if possible
+ * Inputs: cur_inode - the inode
+ *         from - the first block of the file to allocate
+ *         to - one past the last block of the file to allocate
+ * Outputs: 0 if successful, -1 if the image is full (nothing stays allocated)
+ * Side Effects: change db_bitmap and the inode's data block indices
+ */
+static int32_t db_alloc_file_blocks(inode_t* cur_inode, uint32_t from, uint32_t to){
+    uint32_t i;
+    int32_t index;
+    if(to > MAX_FILE_BLOCKS) return -1;
+    if(from >= to) return 0;
+
+    /* keep the file as one extent so the image is read sequentially */
+    index = db_alloc_run(to - from);
+    if(index != -1){
+        for(i = from; i < to; i++){
+            cur_inode->data_block_index[i] = index + (i - from);
+        }
+        return 0;
+    }
+
+    for(i = from; i < to; i++){
+        index = db_alloc();
+        if(index == -1){
+            /* roll back what this call allocated */
+            while(i-- > from){
+                db_mark(cur_inode->data_block_index[i], 0);
+                cur_inode->data_block_index[i] = 0;
+            }
+            return -1;
+        }
+        cur_inode->data_block_index[i] = index;
+    }
+    return 0;
+}
+
+/* inode_mark
+ *
+ * mark an inode as used or free in the free inode bitmap
+ * Inputs: index - the inode index
+ *         used - 1 to mark it used, 0 to mark it free
+ * Outputs: None
+ * Side Effects: change inode_bitmap
+ */
+static void inode_mark(uint32_t index, int32_t used){
+    if(index >= MAX_INODE_NUM) return;
+    if(used){
+        inode_bitmap[index / BITMAP_WORD_BITS] |= (1U << (index % BITMAP_WORD_BITS));
+    } else {
+        inode_bitmap[index / BITMAP_WORD_BITS] &= ~(1U << (index % BITMAP_WORD_BITS));
+    }
+}
+
+/* inode_visit
+ *
+ * mark the inode owned by a dentry as used and remember if it is a directory
+ * Inputs: cur_dentry - the dentry
+ * Outputs: None
+ * Side Effects: change inode_bitmap and dir_inode
+ */
+static void inode_visit(const dentry_t* cur_dentry){
+    if(!dentry_has_inode(cur_dentry)) return;
+    inode_mark(cur_dentry->inode_index, 1);
+    if(cur_dentry->file_type == DIR_FILE_TYPE) dir_inode[cur_dentry->inode_index] = 1;
+}
+
+/* inode_bitmap_build
+ *
+ * build the free inode bitmap from the inodes of every file and directory in the tree,
+ * inode 0 stands for the root and inodes past the end of the image are marked used
+ * so they are never handed out
+ * Inputs: None
+ * Outputs: None
+ * Side Effects: overwrite inode_bitmap and dir_inode
+ */
+void inode_bitmap_build(void){
+    uint32_t i;
+    memset(inode_bitmap, 0, sizeof(inode_bitmap));
+    memset(dir_inode, 0, sizeof(dir_inode));
+    for(i = fs_inodes_num; i < MAX_INODE_NUM; i++){
+        inode_mark(i, 1);
+    }
+    inode_mark(ROOT_DIR_INODE, 1);
+    dir_inode[ROOT_DIR_INODE] = 1;
+    dir_walk(inode_visit);
+}
+
+/* inode_alloc
+ *
+ * allocate one free inode and make it an empty file held inline
+ * Inputs: None
+ * Outputs: the allocated inode index, -1 if every inode is in use or it cannot be read
+ * Side Effects: mark the inode used
+ */
+static int32_t inode_alloc(void){
+    uint32_t i;
+    uint32_t index;
+    inode_t* cur_inode;
+    buf_t* buf;
+    for(i = 0; i < MAX_INODE_NUM / BITMAP_WORD_BITS; i++){
+        if(inode_bitmap[i] == BITMAP_WORD_FULL) continue;
+        index = i * BITMAP_WORD_BITS + bsf(~inode_bitmap[i]);
+        cur_inode = inode_get(index, &buf);
+        if(cur_inode == NULL) return -1;
+        inode_mark(index, 1);
+        cur_inode->length = INODE_INLINE;
+        bdirty(buf);
+        brelse(buf);
+        return index;
+    }
+    return -1;
+}
+
+/* cur_dir
+ *
+ * get the working directory of the current process
+ * Inputs: None
+ * Outputs: the inode of the working directory, ROOT_DIR_INODE if it is not a directory
+ * Side Effects: None
+ */
+static uint32_t cur_dir(void){
+    uint32_t cwd = get_current_pcb()->cwd;
+    /* before the first process runs the pcb holds nothing meaningful */
+    if(cwd >= MAX_INODE_NUM || !dir_inode[cwd]) return ROOT_DIR_INODE;
+    return cwd;
+}
+
+/* dir_lookup
+ *
+ * find a name in one directory, the root is searched through the hashed index and the
+ * negative cache, other directories through the lookup cache and then a linear scan
+ * Inputs: dir - the inode of the directory, ROOT_DIR_INODE for the root
+ *         name - the name to find, at most MAX_FILE_NAME bytes and terminated
+ * Outputs: index of the dentry in the directory, -1 if not found
+ * Side Effects: change the negative cache or the lookup cache
+ */
+static int32_t dir_lookup(uint32_t dir, const uint8_t* name){
+    uint32_t i, j;
+    uint32_t size;
+    uint32_t hash = filename_hash(name);
+    uint32_t slot;
+    dentry_t cur_dentry;
+    const dentry_t* block_dentries;
+    inode_t* dir_inode_data;
+    boot_block_t* boot;
+    buf_t* buf;
+    buf_t* inode_buf;
+
+    if(dir == ROOT_DIR_INODE){
+        /* names that were recently not found fail without probing */
+        for(i = 0; i < NEG_CACHE_SIZE; i++){
+            if(neg_cache_hash[i] == hash && neg_cache_name[i][0] != '\0' &&
+               strncmp((const int8_t*)name, (const int8_t*)neg_cache_name[i], MAX_FILE_NAME) == 0){
+                return -1;
+            }
+        }
+
+        /* probe the hashed index for the target dentry with the same name */
+        boot = boot_get(&buf);
+        if(boot == NULL) return -1;
+        for(slot = hash & (DENTRY_HASH_SIZE - 1); dentry_hash_table[slot] != -1; slot = (slot + 1) & (DENTRY_HASH_SIZE - 1)){
+            i = dentry_hash_table[slot];
+            if(strncmp((const int8_t*)name, (const int8_t*)boot->dentries[i].file_name, MAX_FILE_NAME) == 0){
+                brelse(buf);
+                return i;
+            }
+        }
+        brelse(buf);
+
+        /* if not found, remember the miss */
+        strncpy((int8_t*)neg_cache_name[neg_cache_next], (const int8_t*)name, MAX_FILE_NAME);
+        neg_cache_hash[neg_cache_next] = hash;
+        neg_cache_next = (neg_cache_next + 1) % NEG_CACHE_SIZE;
+        return -1;
+    }
+
+    size = dir_size(dir);
+    slot = (hash ^ (dir * FNV_PRIME)) & (DCACHE_SIZE - 1);
+    if(dcache[slot].index != -1 && dcache[slot].dir == dir && dcache[slot].hash == hash && (uint32_t)dcache[slot].index < size &&
+       dir_entry_read(dir, dcache[slot].index, &cur_dentry) == 0 &&
+       strncmp((const int8_t*)name, (const int8_t*)cur_dentry.file_name, MAX_FILE_NAME) == 0){
+        return dcache[slot].index;
+    }
+
+    /* scan a whole block of dentries per buffer, or the inode of a directory held inline */
+    dir_inode_data = inode_get(dir, &inode_buf);
+    if(dir_inode_data == NULL) return -1;
+    for(i = 0; i < size; i += DENTRIES_PER_BLOCK){
+        if(dir_inode_data->length & INODE_INLINE){
+            buf = NULL;
+            block_dentries = (const dentry_t*)dir_inode_data->inline_data;
+        } else {
+            buf = bread(&fs_dev, fs_block(dir_inode_data->data_block_index[i / DENTRIES_PER_BLOCK]));
+            if(buf == NULL) break;
+            block_dentries = (const dentry_t*)buf->data;
+        }
+        for(j = 0; j < DENTRIES_PER_BLOCK && i + j < size; j++){
+            if(strncmp((const int8_t*)name, (const int8_t*)block_dentries[j].file_name, MAX_FILE_NAME) == 0){
+                if(buf != NULL) brelse(buf);
+                brelse(inode_buf);
+                dcache[slot].dir = dir;
+                dcache[slot].hash = hash;
+                dcache[slot].index = i + j;
+                return i + j;
+            }
+        }
+        if(buf != NULL) brelse(buf);
+    }
+    brelse(inode_buf);
+    return -1;
+}
+
+/* path_resolve
+ *
+ * walk a path one component at a time, an absolute path starts at the root and a
+ * relative one at the working directory, a path of only slashes names the root itself
+ * Inputs: path - the path, components separated by '/'
+ *         dir - filled with the directory holding the last component
+ *         last - filled with the last component, MAX_FILE_NAME + 1 bytes
+ *         index - filled with the index of the last component in dir, -1 if it does not exist
+ * Outputs: 0 if every component before the last is a directory, -1 if not or the path is invalid
+ * Side Effects: None
+ */
+static int32_t path_resolve(const uint8_t* path, uint32_t* dir, uint8_t* last, int32_t* index){
+    uint32_t len;
+    uint32_t cur = ROOT_DIR_INODE;
+    int32_t found = -1;
+    int32_t has_last = 0;
+    dentry_t cur_dentry;
+
+    /* fail if path invalid */
+    if(path == NULL || path[0] == '\0' || strlen((const int8_t*)path) > MAX_PATH_LEN) return -1;
+    if(path[0] != '/') cur = cur_dir();
+    last[0] = '.';
+    last[1] = '\0';
+
+    while(1){
+        while(*path == '/') path++;
+        if(*path == '\0') break;
+
+        /* only an existing directory can be walked into */
+        if(has_last){
+            if(found == -1) return -1;
+            if(dir_entry_read(cur, found, &cur_dentry) == -1) return -1;
+            if(cur_dentry.file_type != DIR_FILE_TYPE) return -1;
+            cur = cur_dentry.inode_index;
+        }
+
+        for(len = 0; path[len] != '\0' && path[len] != '/'; len++);
+        if(len > MAX_FILE_NAME) return -1;      // suggested by checkpoint 2, fail if fname too large
+        memcpy(last, path, len);
+        last[len] = '\0';
+        path += len;
+        has_last = 1;
+
+        /* the root is its own parent */
+        if(cur == ROOT_DIR_INODE && strncmp((const int8_t*)last, "..", MAX_FILE_NAME) == 0) last[1] = '\0';
+        found = dir_lookup(cur, last);
+    }
+    if(!has_last) found = dir_lookup(cur, last);
+
+    *dir = cur;
+    *index = found;
+    return 0;
+}
+
 /* read_dentry_by_name
  *
- * find the file by name and load that file into input dentry
- * Inputs: fname - the given file name to be found
+ * find the file by path and load that file into input dentry
+ * Inputs: fname - the given path of the file to be found
  *         dentry - the dentry to be filled with the found file's fields
  * Outputs: -1 if file does not exist
  *          0 if file can be found
  * Side Effects: change the input dentry
  */
 int32_t read_dentry_by_name(const uint8_t* fname, dentry_t* dentry){
-    uint32_t i;
-    /* fail if fname invalid */
-    if(fname == NULL || strlen((int8_t*)fname) > MAX_FILE_NAME) return -1;      // suggested by checkpoint 2, fail if fname too large
+    uint32_t dir;
+    int32_t index;
+    uint8_t name[MAX_FILE_NAME + 1];
 
     /* fail if dentry is invalid */
     if(dentry == NULL) return -1;
 
-    /* search for the target dentry with the same name */
-    for(i = 0; i < boot_block->dir_entry_num; i++){
-        if(strncmp((const char*)fname, (const char*)dentries[i].file_name, MAX_FILE_NAME) == 0){
-            /* if found, call read_dentry_by_index to copy them */
-            read_dentry_by_index(i, dentry);
-            return 0;
-        }
-    }
-    return -1;      // if not found, return -1
+    /* fail if the path is invalid or the file is not there */
+    if(path_resolve(fname, &dir, name, &index) == -1 || index == -1) return -1;
+
+    /* copy the target dentry into the input dentry */
+    return dir_entry_read(dir, index, dentry);
 }
 
 /* read_dentry_by_index
@@ -83,46 +798,46 @@ int32_t read_dentry_by_name(const uint8_t* fname, dentry_t* dentry){
  * Side Effects: change the input dentry
  */
 int32_t read_dentry_by_index(uint32_t index, dentry_t* dentry){
-    /* fail if index out of boundary */
-    if(index >= boot_block->dir_entry_num) return -1;
+    buf_t* buf;
+    boot_block_t* boot;
 
     /* fail if dentry is invalid */
     if(dentry == NULL) return -1;
 
+    /* fail if index out of boundary */
+    boot = boot_get(&buf);
+    if(boot == NULL) return -1;
+    if(index >= boot->dir_entry_num){
+        brelse(buf);
+        return -1;
+    }
+
     /* copy the target dentry into the input dentry */
-    memcpy(dentry->file_name, dentries[index].file_name, MAX_FILE_NAME);
-    dentry->file_type = dentries[index].file_type;
-    dentry->inode_index = dentries[index].inode_index;
+    memcpy(dentry->file_name, boot->dentries[index].file_name, MAX_FILE_NAME);
+    dentry->file_type = boot->dentries[index].file_type;
+    dentry->inode_index = boot->dentries[index].inode_index;
+    brelse(buf);
     return 0;
 }
 
-/* read_dentry_by_index
+/* inode_read
  *
- * read up to length bytes starting from position offset in the file with inode number inode
- * Inputs: inode- the inode index in the inodes
- *         offset - the offset position in the file to be read
- *         buf - the buffer the load the read data
- *         length - the length of bytes to be read
- * Outputs: -1 if input inode number is invalid
- *          0 if the end of the file has been reached
- *          number of bytes read if read successfully without reaching the end of the file
+ * the body of read_data, on an inode held by the caller
+ * Inputs: cur_inode - the inode
+ *         offset, buf, length - as for read_data
+ * Outputs: as for read_data
  * Side Effects: change the input buf
  */
-int32_t read_data(uint32_t inode, uint32_t offset, uint8_t* buf, uint32_t length){
-    uint32_t i;
-    uint32_t j;
+static int32_t inode_read(const inode_t* cur_inode, uint32_t offset, uint8_t* buf, uint32_t length){
     uint32_t byte_read = 0;     // record the index to load
-    uint32_t start_datablock;
-    uint32_t end_datablock;     // closed interval
-    uint32_t startbyte_index;
-    uint32_t endbyte_index;     // closed interval
-    data_block_t* cur_datablock;
-    inode_t* cur_inode;
-    /* fail if inode out of boundary */
-    if(inode >= boot_block->inodes_num) return -1;
+    uint32_t cur_block;         // index of the block inside the file
+    uint32_t block_offset;      // offset inside the current block
+    uint32_t chunk;
+    uint32_t run;               // blocks of the extent starting at cur_block
+    buf_t* cur_buf;
 
     /* return 0 if reach the end */
-    if(offset >= inodes[inode].length) return 0;
+    if(offset >= inode_size(cur_inode)) return 0;
 
     /* fail if buf is invalid */
     if(buf == NULL) return -1;
@@ -131,130 +846,510 @@ int32_t read_data(uint32_t inode, uint32_t offset, uint8_t* buf, uint32_t length
     if(length == 0) return 0;
 
     /* check if read will touch the end of the file */
-    if(length + offset > inodes[inode].length){
-        length = inodes[inode].length - offset;
+    if(length + offset > inode_size(cur_inode)){
+        length = inode_size(cur_inode) - offset;
+    }
+
+    /* a small file is served straight from its inode */
+    if(cur_inode->length & INODE_INLINE){
+        memcpy(buf, &(cur_inode->inline_data[offset]), length);
+        return length;
     }
 
+    cur_block = offset / BLOCK_SIZE;
+    block_offset = offset % BLOCK_SIZE;
 
-    /* calculate the starting and ending datablock reading byte index */
-    start_datablock = offset / BLOCK_SIZE;
-    end_datablock = (offset + length - 1) / BLOCK_SIZE;
-    startbyte_index = offset % BLOCK_SIZE;
-    endbyte_index = (offset + length - 1) % BLOCK_SIZE;
-    cur_inode = &(inodes[inode]);
+    while(byte_read < length){
+        /* whole blocks lying next to each other on the device are copied as one extent */
+        if(block_offset == 0){
+            run = 0;
+            while((run + 1) * BLOCK_SIZE <= length - byte_read &&
+                  cur_inode->data_block_index[cur_block + run] == cur_inode->data_block_index[cur_block] + run){
+                run++;
+            }
+            if(run > 1 && bread_direct(&fs_dev, fs_block(cur_inode->data_block_index[cur_block]), run, buf + byte_read) == 0){
+                byte_read += run * BLOCK_SIZE;
+                cur_block += run;
+                continue;
+            }
+        }
+        chunk = BLOCK_SIZE - block_offset;
+        if(chunk > length - byte_read) chunk = length - byte_read;
+        cur_buf = bread(&fs_dev, fs_block(cur_inode->data_block_index[cur_block]));
+        /* report what was read before the failing block */
+        if(cur_buf == NULL) return (byte_read > 0) ? (int32_t)byte_read : -1;
+        memcpy(buf + byte_read, &(cur_buf->data[block_offset]), chunk);
+        brelse(cur_buf);
 
+        byte_read += chunk;
+        cur_block++;
+        block_offset = 0;
+    }
 
-    if(start_datablock == end_datablock){
-        /* if only involves single datablock, read it and return */
-        cur_datablock = &(datablocks[cur_inode->data_block_index[start_datablock]]);
-        for(i = 0; i < length; i++){
-            buf[i] = cur_datablock->data[startbyte_index + i];
+    return length;
+}
+
+/* read_data
+ *
+ * read up to length bytes starting from position offset in the file with inode number inode,
+ * the file is copied block by block through the buffer cache, except runs of whole
+ * blocks that lie next to each other on the device, which are copied straight from it,
+ * and small files held inline, which are copied from the inode
+ * Inputs: inode- the inode index in the inodes
+ *         offset - the offset position in the file to be read
+ *         buf - the buffer the load the read data
+ *         length - the length of bytes to be read
+ * Outputs: -1 if input inode number is invalid
+ *          0 if the end of the file has been reached
+ *          number of bytes read if read successfully without reaching the end of the file
+ * Side Effects: change the input buf
+ */
+int32_t read_data(uint32_t inode, uint32_t offset, uint8_t* buf, uint32_t length){
+    inode_t* cur_inode;
+    buf_t* inode_buf;
+    int32_t ret;
+    /* fail if inode out of boundary */
+    if(inode >= fs_inodes_num) return -1;
+
+    cur_inode = inode_get(inode, &inode_buf);
+    if(cur_inode == NULL) return -1;
+    ret = inode_read(cur_inode, offset, buf, length);
+    brelse(inode_buf);
+    return ret;
+}
+
+
+/* zero_data
+ *
+ * clear bytes [from, to) of a file whose blocks are already allocated
+ * Inputs: cur_inode - the inode
+ *         from - the first byte to clear
+ *         to - one past the last byte to clear
+ * Outputs: 0 if successful, -1 if a block cannot be read
+ * Side Effects: change the data blocks of the file
+ */
+static int32_t zero_data(inode_t* cur_inode, uint32_t from, uint32_t to){
+    uint32_t block_offset;
+    uint32_t chunk;
+    buf_t* cur_buf;
+    while(from < to){
+        block_offset = from % BLOCK_SIZE;
+        chunk = BLOCK_SIZE - block_offset;
+        if(chunk > to - from) chunk = to - from;
+        /* a whole block is cleared without reading it first */
+        if(chunk == BLOCK_SIZE){
+            cur_buf = bget(&fs_dev, fs_block(cur_inode->data_block_index[from / BLOCK_SIZE]));
+        } else {
+            cur_buf = bread(&fs_dev, fs_block(cur_inode->data_block_index[from / BLOCK_SIZE]));
         }
-        return length;
+        if(cur_buf == NULL) return -1;
+        memset(&(cur_buf->data[block_offset]), 0, chunk);
+        bdirty(cur_buf);
+        brelse(cur_buf);
+        from += chunk;
     }
+    return 0;
+}
 
-    /* if involves multiple datablocks, read the rest of start block */
-    cur_datablock = &(datablocks[cur_inode->data_block_index[start_datablock]]);
-    for(i = startbyte_index; i < BLOCK_SIZE; i++){
-        buf[byte_read] = cur_datablock->data[i];
-        byte_read++;
+/* inline_to_blocks
+ *
+ * move the data of a file held inline into a data block of its own, so it can grow past INLINE_MAX_SIZE
+ * Inputs: cur_inode - the inode, held inline
+ * Outputs: 0 if successful, -1 if the image is full
+ * Side Effects: change db_bitmap and the inode
+ */
+static int32_t inline_to_blocks(inode_t* cur_inode){
+    uint32_t size = inode_size(cur_inode);
+    int32_t index;
+    buf_t* cur_buf;
+    if(size == 0){
+        cur_inode->length = 0;
+        return 0;
+    }
+    index = db_alloc();
+    if(index == -1) return -1;
+    cur_buf = bget(&fs_dev, fs_block(index));
+    if(cur_buf == NULL){
+        db_mark(index, 0);
+        return -1;
     }
+    memcpy(cur_buf->data, cur_inode->inline_data, size);
+    memset(&(cur_buf->data[size]), 0, BLOCK_SIZE - size);
+    bdirty(cur_buf);
+    brelse(cur_buf);
+    memset(cur_inode->inline_data, 0, INLINE_MAX_SIZE);
+    cur_inode->data_block_index[0] = index;
+    cur_inode->length = size;
+    return 0;
+}
 
-    /* then read the middle blocks */
-    for(i = start_datablock + 1; i < end_datablock; i++){
-        cur_datablock = &(datablocks[cur_inode->data_block_index[i]]);
-        for(j = 0; j < BLOCK_SIZE; j++){
-            buf[byte_read] = cur_datablock->data[j];
-            byte_read++;
+/* extend_data
+ *
+ * grow a file to length bytes by allocating the missing tail blocks, a file held
+ * inline stays so while it fits and moves to data blocks otherwise
+ * Inputs: cur_inode - the inode
+ *         length - the new length, larger than the current one
+ *         zero_to - bytes from the old end up to zero_to are cleared, the rest is left for the caller to fill
+ * Outputs: 0 if successful, -1 if the file would be too large or the image is full
+ * Side Effects: change db_bitmap and the inode
+ */
+static int32_t extend_data(inode_t* cur_inode, uint32_t length, uint32_t zero_to){
+    uint32_t old_length;
+    uint32_t old_blocks;
+    uint32_t new_blocks = (length + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    if(new_blocks > MAX_FILE_BLOCKS) return -1;
+
+    if(cur_inode->length & INODE_INLINE){
+        if(length <= INLINE_MAX_SIZE){
+            memset(&(cur_inode->inline_data[inode_size(cur_inode)]), 0, zero_to - inode_size(cur_inode));
+            cur_inode->length = length | INODE_INLINE;
+            return 0;
         }
+        if(inline_to_blocks(cur_inode) == -1) return -1;
     }
+    old_blocks = (cur_inode->length + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    if(db_alloc_file_blocks(cur_inode, old_blocks, new_blocks) == -1) return -1;
 
-    /* finally read the end blocks */
-    cur_datablock = &(datablocks[cur_inode->data_block_index[end_datablock]]);
-    for(i = 0; i <= endbyte_index; i++){
-        buf[byte_read] = cur_datablock->data[i];
-        byte_read++;
+    /* the bytes after the old end may hold stale data of the last block */
+    if(zero_data(cur_inode, cur_inode->length, zero_to) == -1){
+        /* give the new blocks back, they are counted by the length */
+        old_length = cur_inode->length;
+        cur_inode->length = length;
+        db_free_file_blocks(cur_inode, old_blocks);
+        cur_inode->length = old_length;
+        return -1;
     }
-
-    return length;
+    cur_inode->length = length;
+    return 0;
 }
 
-
-int32_t write_data(uint32_t inode, const uint8_t* buf, uint32_t length){
-    uint32_t i;
-    uint32_t j;
+/* inode_write
+ *
+ * the body of write_data, on an inode held by the caller
+ * Inputs: cur_inode - the inode
+ *         offset, buf, length - as for write_data, length is not 0
+ * Outputs: as for write_data
+ * Side Effects: change the data blocks and the inode, the caller marks the inode dirty
+ */
+static int32_t inode_write(inode_t* cur_inode, uint32_t offset, const uint8_t* buf, uint32_t length){
     uint32_t byte_written = 0;
-    data_block_t* cur_datablock;
-    inode_t* cur_inode = &(inodes[inode]);
+    uint32_t cur_offset;
+    uint32_t block_offset;
+    uint32_t chunk;
+    buf_t* cur_buf;
+
+    /* make sure every block the write touches exists */
+    if(offset + length > inode_size(cur_inode)){
+        if(extend_data(cur_inode, offset + length, (offset > inode_size(cur_inode)) ? offset : inode_size(cur_inode)) == -1) return -1;
+    }
+
+    if(cur_inode->length & INODE_INLINE){
+        memcpy(&(cur_inode->inline_data[offset]), buf, length);
+        return length;
+    }
+
+    cur_offset = offset;
+    while(byte_written < length){
+        block_offset = cur_offset % BLOCK_SIZE;
+        chunk = BLOCK_SIZE - block_offset;
+        if(chunk > length - byte_written) chunk = length - byte_written;
+        /* a whole block is overwritten without reading it first */
+        if(chunk == BLOCK_SIZE){
+            cur_buf = bget(&fs_dev, fs_block(cur_inode->data_block_index[cur_offset / BLOCK_SIZE]));
+        } else {
+            cur_buf = bread(&fs_dev, fs_block(cur_inode->data_block_index[cur_offset / BLOCK_SIZE]));
+        }
+        if(cur_buf == NULL) return (byte_written > 0) ? (int32_t)byte_written : -1;
+        memcpy(&(cur_buf->data[block_offset]), buf + byte_written, chunk);
+        bdirty(cur_buf);
+        brelse(cur_buf);
+        byte_written += chunk;
+        cur_offset += chunk;
+    }
+
+    return byte_written;
+}
+
+/* write_data
+ *
+ * write length bytes of buf at position offset in the file with inode number inode,
+ * only the blocks covering [offset, offset + length) are touched and tail blocks are
+ * allocated when the write goes past the end of the file, a gap before offset reads as zeros
+ * Inputs: inode - the inode index in the inodes
+ *         offset - the offset position in the file to be written
+ *         buf - the buffer holding the new content
+ *         length - the length of bytes to write
+ * Outputs: -1 if input inode number is invalid, the file would be too large or the image is full
+ *          number of bytes written if successful
+ * Side Effects: change the data blocks and the length of the file, the blocks reach the image on write-back
+ */
+int32_t write_data(uint32_t inode, uint32_t offset, const uint8_t* buf, uint32_t length){
+    inode_t* cur_inode;
+    buf_t* inode_buf;
+    uint32_t old_length;
+    int32_t ret;
     /* fail if inode out of boundary */
-    if(inode >= boot_block->inodes_num) return -1;
+    if(inode >= fs_inodes_num) return -1;
     /* fail if buf is invalid */
     if(buf == NULL) return -1;
+    /* if write nothing return 0 directly */
+    if(length == 0) return 0;
+    /* fail if the end would overflow */
+    if(offset + length < offset) return -1;
 
-    /* free up all the current occupied data blocks */
-    int32_t num_datablock = (cur_inode->length % BLOCK_SIZE == 0) ? cur_inode->length / BLOCK_SIZE : (cur_inode->length / BLOCK_SIZE + 1);
-    for (i = 0; i < num_datablock; i++) {
-        occupy_db[cur_inode->data_block_index[i]] = 0;
-    }
-    memset(cur_inode->data_block_index, 0, sizeof(uint32_t) * num_datablock);
-    cur_inode->length = 0;
-
-    /* allocate new data blocks */
-    num_datablock = (length % BLOCK_SIZE == 0) ? length / BLOCK_SIZE : (length / BLOCK_SIZE + 1);
-    for (i = 0; i < num_datablock; i++) {
-        for (j = 0; j < 64; j++) {
-            if (occupy_db[j] == 0) {
-                occupy_db[j] = 1;
-                cur_inode->data_block_index[i] = j;
-                break;
-            }
-        }
-        if (j == 64) {
+    cur_inode = inode_get(inode, &inode_buf);
+    if(cur_inode == NULL) return -1;
+    old_length = cur_inode->length;
+    ret = inode_write(cur_inode, offset, buf, length);
+    /* the inode block changes with the length, or with the data of a file held inline */
+    if(cur_inode->length != old_length || (cur_inode->length & INODE_INLINE)) bdirty(inode_buf);
+    brelse(inode_buf);
+    return ret;
+}
+
+/* truncate_data
+ *
+ * set the length of the file with inode number inode, blocks past the new end are released
+ * and a grown file reads as zeros after its old end
+ * Inputs: inode - the inode index in the inodes
+ *         length - the new length of the file
+ * Outputs: 0 if successful, -1 if inode is invalid, the file would be too large or the image is full
+ * Side Effects: change db_bitmap and the inode
+ */
+int32_t truncate_data(uint32_t inode, uint32_t length){
+    inode_t* cur_inode;
+    buf_t* inode_buf;
+    int32_t ret = 0;
+    /* fail if inode out of boundary */
+    if(inode >= fs_inodes_num) return -1;
+    cur_inode = inode_get(inode, &inode_buf);
+    if(cur_inode == NULL) return -1;
+
+    if(length < inode_size(cur_inode)){
+        db_free_file_blocks(cur_inode, (length + BLOCK_SIZE - 1) / BLOCK_SIZE);
+        cur_inode->length = length | (cur_inode->length & INODE_INLINE);
+        bdirty(inode_buf);
+    } else if(length > inode_size(cur_inode)){
+        ret = extend_data(cur_inode, length, length);
+        bdirty(inode_buf);
+    }
+    brelse(inode_buf);
+    return ret;
+}
+
+/* dir_add
+ *
+ * append a dentry to a directory, a directory other than the root grows by one dentry
+ * and gets a new data block every DENTRIES_PER_BLOCK dentries
+ * Inputs: dir - the inode of the directory, ROOT_DIR_INODE for the root
+ *         name - the name of the dentry, 1 to MAX_FILE_NAME characters
+ *         type - the file type of the dentry
+ *         inode - the inode of the dentry
+ * Outputs: 0 if successful, -1 if the root is full or the image is full
+ * Side Effects: change the directory and rebuild the name index
+ */
+static int32_t dir_add(uint32_t dir, const uint8_t* name, uint32_t type, uint32_t inode){
+    dentry_t new_dentry;
+    boot_block_t* boot;
+    buf_t* buf;
+    memset(&new_dentry, 0, sizeof(dentry_t));
+    memcpy(new_dentry.file_name, name, strlen((const int8_t*)name));
+    new_dentry.file_type = type;
+    new_dentry.inode_index = inode;
+
+    if(dir == ROOT_DIR_INODE){
+        boot = boot_get(&buf);
+        if(boot == NULL) return -1;
+        if(boot->dir_entry_num >= MAX_FILE_NUM){
+            brelse(buf);
             return -1;
         }
+        memcpy(&(boot->dentries[boot->dir_entry_num]), &new_dentry, sizeof(dentry_t));
+        boot->dir_entry_num++;
+        bdirty(buf);
+        brelse(buf);
+    } else if(write_data(dir, inode_length(dir), (const uint8_t*)&new_dentry, sizeof(dentry_t)) == -1){
+        return -1;
     }
 
-    while (byte_written < length) {
-        cur_datablock = &(datablocks[cur_inode->data_block_index[byte_written / BLOCK_SIZE]]);
-        if (length - byte_written < BLOCK_SIZE) {
-            memcpy(cur_datablock->data, buf + byte_written, length - byte_written);
-            byte_written += length - byte_written;
-        } else {
-            memcpy(cur_datablock->data, buf + byte_written, BLOCK_SIZE);
-            byte_written += BLOCK_SIZE;
+    /* the index also drops the name from the negative cache */
+    dentry_index_build();
+    return 0;
+}
+
+/* dir_remove
+ *
+ * remove a dentry from a directory, later dentries move down by one to keep it packed and in order
+ * Inputs: dir - the inode of the directory, ROOT_DIR_INODE for the root
+ *         index - the index of the dentry
+ * Outputs: None
+ * Side Effects: change the directory and rebuild the name index
+ */
+static void dir_remove(uint32_t dir, uint32_t index){
+    uint32_t i;
+    uint32_t size = dir_size(dir);
+    dentry_t cur_dentry;
+    boot_block_t* boot;
+    buf_t* buf;
+    if(dir == ROOT_DIR_INODE){
+        boot = boot_get(&buf);
+        if(boot != NULL){
+            memmove(&(boot->dentries[index]), &(boot->dentries[index + 1]), (size - index - 1) * sizeof(dentry_t));
+            boot->dir_entry_num--;
+            bdirty(buf);
+            brelse(buf);
+        }
+    } else {
+        /* dentries never cross a block, but consecutive ones may be in different blocks */
+        for(i = index; i + 1 < size; i++){
+            if(dir_entry_read(dir, i + 1, &cur_dentry) == -1 || dir_entry_write(dir, i, &cur_dentry) == -1) break;
         }
+        truncate_data(dir, (size - 1) * DIR_ENTRY_SIZE);
     }
+    dentry_index_build();
+}
 
-    cur_inode->length = byte_written;
+/* node_create
+ *
+ * add an empty regular file or directory to a directory, a new directory holds "." and ".."
+ * Inputs: dir - the inode of the directory, ROOT_DIR_INODE for the root
+ *         name - the name of the new file, 1 to MAX_FILE_NAME characters
+ *         type - REGULAR_FILE_TYPE or DIR_FILE_TYPE
+ * Outputs: 0 if successful, -1 if the name is invalid or taken, or no dentry, inode or data block is free
+ * Side Effects: change the directory
+ */
+static int32_t node_create(uint32_t dir, const uint8_t* name, uint32_t type){
+    int32_t index;
+    uint32_t i;
+    uint32_t length = strlen((const int8_t*)name);
+    if(length == 0 || length > MAX_FILE_NAME || is_dot_name(name)) return -1;
+    for(i = 0; i < length; i++){
+        if(name[i] == '/') return -1;
+    }
+    /* fail if the name is taken */
+    if(dir_lookup(dir, name) != -1) return -1;
 
-    return byte_written;
+    index = inode_alloc();
+    if(index == -1) return -1;
+
+    if((type == DIR_FILE_TYPE && (dir_add(index, (const uint8_t*)".", DIR_FILE_TYPE, index) == -1 ||
+                                  dir_add(index, (const uint8_t*)"..", DIR_FILE_TYPE, dir) == -1)) ||
+       dir_add(dir, name, type, index) == -1){
+        /* give back whatever the new inode got */
+        truncate_data(index, 0);
+        inode_mark(index, 0);
+        return -1;
+    }
+    if(type == DIR_FILE_TYPE) dir_inode[index] = 1;
+    return 0;
+}
+
+/* file_create
+ *
+ * add an empty regular file at path
+ * Inputs: fname - the path of the new file, its directory must exist
+ * Outputs: 0 if successful, -1 if the path is invalid or taken, or no dentry or inode is free
+ * Side Effects: change the directory holding the file
+ */
+int32_t file_create(const uint8_t* fname){
+    uint32_t dir;
+    int32_t index;
+    uint8_t name[MAX_FILE_NAME + 1];
+    if(path_resolve(fname, &dir, name, &index) == -1 || index != -1) return -1;
+    return node_create(dir, name, REGULAR_FILE_TYPE);
+}
+
+/* dir_mkdir
+ *
+ * add an empty directory at path
+ * Inputs: path - the path of the new directory, its parent must exist
+ * Outputs: 0 if successful, -1 if the path is invalid or taken, or no dentry, inode or data block is free
+ * Side Effects: change the parent directory
+ */
+int32_t dir_mkdir(const uint8_t* path){
+    uint32_t dir;
+    int32_t index;
+    uint8_t name[MAX_FILE_NAME + 1];
+    if(path_resolve(path, &dir, name, &index) == -1 || index != -1) return -1;
+    return node_create(dir, name, DIR_FILE_TYPE);
+}
+
+/* dir_chdir
+ *
+ * change the working directory of the current process
+ * Inputs: path - the path of the directory
+ * Outputs: 0 if successful, -1 if there is no such directory
+ * Side Effects: change the cwd of the current pcb
+ */
+int32_t dir_chdir(const uint8_t* path){
+    dentry_t dentry;
+    if(read_dentry_by_name(path, &dentry) == -1) return -1;
+    if(dentry.file_type != DIR_FILE_TYPE) return -1;
+    get_current_pcb()->cwd = dentry.inode_index;
+    return 0;
+}
+
+/* file_unlink
+ *
+ * remove the regular file or empty directory at path, its inode and data blocks are released
+ * Inputs: fname - the path of the file
+ * Outputs: 0 if successful, -1 if there is no such file, the directory is not empty,
+ *          or some process has it open or as its working directory
+ * Side Effects: change the directory holding the file, later dentries move down by one
+ */
+int32_t file_unlink(const uint8_t* fname){
+    dentry_t cur_dentry;
+    uint32_t dir;
+    int32_t index;
+    uint32_t inode;
+    uint8_t name[MAX_FILE_NAME + 1];
+    uint32_t i, j;
+    pcb_t* cur_pcb;
+    file_descriptor_t* cur_fd;
+    if(path_resolve(fname, &dir, name, &index) == -1 || index == -1 || is_dot_name(name)) return -1;
+    if(dir_entry_read(dir, index, &cur_dentry) == -1) return -1;
+    if(!dentry_has_inode(&cur_dentry)) return -1;
+    inode = cur_dentry.inode_index;
+    /* a directory can only go once "." and ".." are all it holds */
+    if(cur_dentry.file_type == DIR_FILE_TYPE && dir_size(inode) > 2) return -1;
+
+    /* the inode may be reused right away, so a file in use cannot be removed */
+    for(i = 0; i < MAX_PID_NUM; i++){
+        if(!check_pid_occupied(i)) continue;
+        cur_pcb = get_pcb_by_pid(i);
+        if(cur_pcb->cwd == inode && cur_dentry.file_type == DIR_FILE_TYPE) return -1;
+        for(j = 0; j < cur_pcb->fd_max; j++){
+            cur_fd = fd_get_pcb(cur_pcb, j);
+            if(cur_fd != NULL && cur_fd->inode_index == inode &&
+               (cur_fd->operation_table == &file_operation_table || cur_fd->operation_table == &dir_operation_table)) return -1;
+        }
+    }
+
+    truncate_data(inode, 0);
+    inode_mark(inode, 0);
+    dir_inode[inode] = 0;
+    dir_remove(dir, index);
+    return 0;
 }
 
 
 /* dir_open
  *
  * open a directory if the fd_array has empty sapce and initialize it
- * Inputs: id - meaningless
+ * Inputs: id - the path of the directory
  * Outputs: none
  * Return: file descriptor if successfully, -1 if fail
  * Side Effects: None
  */
 int32_t dir_open(const uint8_t* id){
-    int32_t i;
-    pcb_t* cur_pcb = get_current_pcb();
-    file_descriptor_t* cur_fd;
-    for(i = 2; i < NUM_FILES; i++){     // 2 as stdin and stdout already been used
-        cur_fd = &(cur_pcb->fd_array[i]);
-        if(cur_fd->flags == READY_TO_BE_USED){
-            /* if there exists empty file descriptor, assign it */
-            cur_fd->operation_table = &dir_operation_table;
-            cur_fd->inode_index = 0;
-            cur_fd->file_position = 0;
-            cur_fd->flags = IN_USE;
-            return i;
-        }
-    }
-    return -1;  // if no empty, open fail
+    dentry_t dentry;
+
+    /* check if the directory exists first */
+    if(read_dentry_by_name(id, &dentry) == -1) return -1;
+    if(dentry.file_type != DIR_FILE_TYPE) return -1;
+
+    /* take the lowest free file descriptor, ROOT_DIR_INODE for the root */
+    return fd_alloc(&dir_operation_table, dentry.inode_index);
 }
 
 /* dir_close
@@ -266,18 +1361,12 @@ int32_t dir_open(const uint8_t* id){
  * Side Effects: None
  */
 int32_t dir_close(int32_t id){
-    pcb_t* cur_pcb = get_current_pcb();
-    file_descriptor_t* cur_fd;
-    /* if if out of boundary, close fail */
-    if(id < 2 || id >= NUM_FILES) return -1;
-
-    cur_fd = &(cur_pcb->fd_array[id]);
+    file_descriptor_t* cur_fd = fd_get(id);
     /* if that id is invalid, close fail */
-    if(cur_fd->flags != IN_USE || cur_fd->inode_index != 0) return -1;
+    if(cur_fd == NULL || cur_fd->operation_table != &dir_operation_table) return -1;
 
     /* free that file descriptor if every thing all right */
-    cur_fd->flags = READY_TO_BE_USED;
-    return 0;
+    return (fd_close(id) == -1) ? -1 : 0;
 }
 
 /* dir_read
@@ -292,32 +1381,35 @@ int32_t dir_close(int32_t id){
  */
 int32_t dir_read(int32_t fd, void* buf, int32_t nbytes){
     int32_t i,j;
-    dentry_t dentry;
+    dentry_t cur_dentry;
+    uint32_t size;
     int32_t length = nbytes;
     int32_t dentry_read_num = (nbytes % 32 == 0) ? nbytes / 32 : (nbytes / 32 + 1);     // this equal to the smallest integer that is larger or equal to bytes / 4
     int32_t bytes_read = 0;
-    pcb_t* cur_pcb = get_current_pcb();
-    file_descriptor_t* cur_fd;
+    file_descriptor_t* cur_fd = fd_get(fd);
     /* if buf is null or fd is invalid, read fails */
-    if(buf == NULL || fd < 2 || fd >= NUM_FILES || nbytes < 0) return -1;
+    if(buf == NULL || cur_fd == NULL || nbytes < 0) return -1;
 
     if(nbytes == 0) return 0;
 
-    cur_fd = &(cur_pcb->fd_array[fd]);
+    size = dir_size(cur_fd->inode_index);
     /* if read reach end, return 0 directly */
-    if(cur_fd->file_position == boot_block->dir_entry_num) return 0;
+    if(cur_fd->file_position >= size) return 0;
 
     for(i = 0; i < dentry_read_num; i++){
         /* check if reach the end */
-        if(cur_fd->file_position + i >= boot_block->dir_entry_num){
-            cur_fd->file_position = boot_block->dir_entry_num;
+        if(cur_fd->file_position + i >= size){
+            cur_fd->file_position = size;
             return bytes_read;
         }
-        /* read the dentry by index, index is recorded in file_position */
-        if(read_dentry_by_index(cur_fd->file_position + i, &dentry) == -1) return -1;
+        /* get the dentry by index, index is recorded in file_position */
+        if(dir_entry_read(cur_fd->inode_index, cur_fd->file_position + i, &cur_dentry) == -1){
+            cur_fd->file_position += i;
+            return (bytes_read > 0) ? bytes_read : -1;
+        }
         /* then copy the target dentry's file name into the buffer */
         for(j = 0; j < 32 && j < length; j++){               // 32 as max file name 32 bytes
-            ((char*)buf)[bytes_read + j] = dentry.file_name[j];
+            ((char*)buf)[bytes_read + j] = cur_dentry.file_name[j];
         }
         length -= 32;
         bytes_read += j;
@@ -329,18 +1421,61 @@ int32_t dir_read(int32_t fd, void* buf, int32_t nbytes){
     return bytes_read;
 }
 
+/* dir_getdents
+ *
+ * fill buf with records of the dentries of an opened directory starting at its position,
+ * so a whole directory is listed with one call instead of one read per name
+ * Inputs: fd - the file descriptor associated with the directory
+ *         buf - the records to fill
+ *         nbytes - the size of buf, only whole records are filled
+ * Outputs: None
+ * Return: number of bytes filled, 0 if reach the end, -1 if fails or buf holds no record
+ * Side Effects: advance the position of the directory by the number of records filled
+ */
+int32_t dir_getdents(int32_t fd, dirent_t* buf, int32_t nbytes){
+    uint32_t i;
+    uint32_t size;
+    uint32_t count;
+    dentry_t cur_dentry;
+    file_descriptor_t* cur_fd = fd_get(fd);
+    if(buf == NULL || nbytes < (int32_t)sizeof(dirent_t)) return -1;
+    if(cur_fd == NULL || cur_fd->operation_table != &dir_operation_table) return -1;
+    size = dir_size(cur_fd->inode_index);
+
+    count = nbytes / sizeof(dirent_t);
+    for(i = 0; i < count && cur_fd->file_position < size; i++){
+        if(dir_entry_read(cur_fd->inode_index, cur_fd->file_position, &cur_dentry) == -1) break;
+        memcpy(buf[i].file_name, cur_dentry.file_name, MAX_FILE_NAME);
+        buf[i].file_type = cur_dentry.file_type;
+        buf[i].inode_index = cur_dentry.inode_index;
+        buf[i].length = dentry_length(&cur_dentry);
+        cur_fd->file_position++;
+    }
+    /* a failing first dentry is an error, a later one a short listing */
+    if(i == 0 && cur_fd->file_position < size) return -1;
+    return i * sizeof(dirent_t);
+}
+
 /* dir_write
  *
- * not been implemented yet
+ * create an empty regular file in the opened directory, the name is the written bytes
  * Inputs: fd - directory associated with file descriptor to be wrote
- *         buf - the buffer holding the content to write
- *         nbytes - the length of bytes to write
+ *         buf - the name of the new file, not necessarily terminated
+ *         nbytes - the length of the name
  * Outputs: None
- * Return: -1 as not implemented
- * Side Effects: None
+ * Return: nbytes if the file is created, -1 if fails
+ * Side Effects: change the boot block
  */
 int32_t dir_write(int32_t fd, const void* buf, int32_t nbytes){
-    return -1;
+    uint8_t fname[MAX_FILE_NAME + 1];
+    file_descriptor_t* cur_fd = fd_get(fd);
+    /* if buf is null or fd is invalid or name length is invalid, write fails */
+    if(buf == NULL || cur_fd == NULL || nbytes <= 0 || nbytes > MAX_FILE_NAME) return -1;
+
+    memcpy(fname, buf, nbytes);
+    fname[nbytes] = '\0';
+    if(node_create(cur_fd->inode_index, fname, REGULAR_FILE_TYPE) == -1) return -1;
+    return nbytes;
 }
 
 
@@ -353,9 +1488,6 @@ int32_t dir_write(int32_t fd, const void* buf, int32_t nbytes){
  * Side Effects: None
  */
 int32_t fopen(const uint8_t* fname){
-    int32_t i;
-    pcb_t* cur_pcb = get_current_pcb();
-    file_descriptor_t* cur_fd;
     dentry_t dentry;
 
     /* check if the file exists first */
@@ -363,18 +1495,8 @@ int32_t fopen(const uint8_t* fname){
     /* if this is not a regular file, open fail */
     if(dentry.file_type != REGULAR_FILE_TYPE) return -1;
 
-    for(i = 2; i < NUM_FILES; i++){         // 2 as stdin and stdout already been used
-        cur_fd = &(cur_pcb->fd_array[i]);
-        if(cur_fd->flags == READY_TO_BE_USED){
-            /* if there exists empty file descriptor, assign it */
-            cur_fd->operation_table = &file_operation_table;
-            cur_fd->inode_index = dentry.inode_index;
-            cur_fd->file_position = 0;
-            cur_fd->flags = IN_USE;
-            return i;
-        }
-    }
-    return -1;  // if no empty, open fail
+    /* take the lowest free file descriptor, fail if there is none */
+    return fd_alloc(&file_operation_table, dentry.inode_index);
 }
 
 /* fclose
@@ -386,18 +1508,12 @@ int32_t fopen(const uint8_t* fname){
  * Side Effects: None
  */
 int32_t fclose(int32_t fd){
-    pcb_t* cur_pcb = get_current_pcb();
-    file_descriptor_t* cur_fd;
-    /* if if out of boundary, close fail */
-    if(fd < 2 || fd >= NUM_FILES) return -1;
-
-    cur_fd = &(cur_pcb->fd_array[fd]);
+    file_descriptor_t* cur_fd = fd_get(fd);
     /* if that id is invalid, close fail */
-    if(cur_fd->flags != IN_USE) return -1;
+    if(cur_fd == NULL || cur_fd->operation_table != &file_operation_table) return -1;
 
     /* free that file descriptor if every thing all right */
-    cur_fd->flags = READY_TO_BE_USED;
-    return 0;
+    return (fd_close(fd) == -1) ? -1 : 0;
 }
 
 /* fread
@@ -412,12 +1528,10 @@ int32_t fclose(int32_t fd){
  */
 int32_t fread(int32_t fd, void* buf, int32_t nbytes){
     uint32_t bytes_read;
-    pcb_t* cur_pcb = get_current_pcb();
-    file_descriptor_t* cur_fd;
+    file_descriptor_t* cur_fd = fd_get(fd);
     /* if buf is null or fd is invalid or nbytes is invalid, read fails */
-    if(buf == NULL || fd < 0 || fd >= NUM_FILES || nbytes < 0) return -1;
+    if(buf == NULL || cur_fd == NULL || nbytes < 0) return -1;
 
-    cur_fd = &(cur_pcb->fd_array[fd]);
     /* read the file starting at the file_position */
     bytes_read = read_data(cur_fd->inode_index, cur_fd->file_position, buf, nbytes);
 
@@ -426,7 +1540,7 @@ int32_t fread(int32_t fd, void* buf, int32_t nbytes){
     
     /* else, need to update file_position */
     if(bytes_read < nbytes){
-        cur_fd->file_position = inodes[cur_fd->inode_index].length;       // file end has been reached
+        cur_fd->file_position = inode_length(cur_fd->inode_index);       // file end has been reached
     } else {
         cur_fd->file_position += nbytes;
     }
@@ -436,25 +1550,147 @@ int32_t fread(int32_t fd, void* buf, int32_t nbytes){
 
 /* fwrite
  *
- * not been implemented yet
+ * write the file at its file_position and move the position past the written bytes
  * Inputs: fd - file associated with file descriptor to be wrote
  *         buf - the buffer holding the content to write
  *         nbytes - the length of bytes to write
  * Outputs: None
- * Return: -1 as not implemented
- * Side Effects: None
+ * Return: number of bytes written if successfully, -1 if fails
+ * Side Effects: the file grows if the write goes past its end
  */
 int32_t fwrite(int32_t fd, const void* buf, int32_t nbytes){
-    uint32_t bytes_written;
-    pcb_t* cur_pcb = get_current_pcb();
-    file_descriptor_t* cur_fd;
-    /* if buf is null or fd is invalid or nbytes is invalid, read fails */
-    if(buf == NULL || fd < 0 || fd >= NUM_FILES || nbytes < 0) return -1;    
-    cur_fd = &(cur_pcb->fd_array[fd]);
-    /* read the file starting at 0 
-       this is mandatory as text editor requires to overwrite the entire file */
-    bytes_written = write_data(cur_fd->inode_index, buf, nbytes);
-    if(bytes_written == nbytes)
-        return bytes_written;
-    return -1;
+    int32_t bytes_written;
+    file_descriptor_t* cur_fd = fd_get(fd);
+    /* if buf is null or fd is invalid or nbytes is invalid, write fails */
+    if(buf == NULL || cur_fd == NULL || nbytes < 0) return -1;
+    /* write the file starting at the file_position */
+    bytes_written = write_data(cur_fd->inode_index, cur_fd->file_position, buf, nbytes);
+    if(bytes_written == -1) return -1;
+
+    cur_fd->file_position += bytes_written;
+    return bytes_written;
+}
+
+/* file_lseek
+ *
+ * move the position of an opened regular file or directory, a file position may go past
+ * the end and the next write fills the gap with zeros, a directory position counts dentries
+ * Inputs: fd - the file descriptor
+ *         offset - the signed distance to move
+ *         whence - SEEK_SET, SEEK_CUR or SEEK_END
+ * Outputs: None
+ * Return: the new position, -1 if fd is not a file or directory or the position would be negative
+ * Side Effects: change the file_position
+ */
+int32_t file_lseek(int32_t fd, int32_t offset, int32_t whence){
+    file_descriptor_t* cur_fd = fd_get(fd);
+    int32_t base;
+    if(cur_fd == NULL) return -1;
+
+    switch(whence){
+        case SEEK_SET:
+            base = 0;
+            break;
+        case SEEK_CUR:
+            base = cur_fd->file_position;
+            break;
+        case SEEK_END:
+            if(cur_fd->operation_table == &file_operation_table){
+                base = inode_length(cur_fd->inode_index);
+            } else {
+                base = dir_size(cur_fd->inode_index);
+            }
+            break;
+        default:
+            return -1;
+    }
+    if(cur_fd->operation_table != &file_operation_table && cur_fd->operation_table != &dir_operation_table) return -1;
+
+    /* fail if the position would be negative or overflow */
+    if(base < 0 || (offset < 0 && base + offset < 0) || (offset > 0 && base + offset < base)) return -1;
+    cur_fd->file_position = base + offset;
+    return cur_fd->file_position;
+}
+
+/* file_pread
+ *
+ * read an opened regular file at offset, the file_position is not used nor changed
+ * Inputs: fd - the file descriptor
+ *         buf - the buffer to fill
+ *         nbytes - the number of bytes to read
+ *         offset - the position in the file to read from
+ * Outputs: None
+ * Return: number of bytes read, 0 if offset is at or past the end, -1 if fails
+ * Side Effects: change buf
+ */
+int32_t file_pread(int32_t fd, void* buf, int32_t nbytes, uint32_t offset){
+    file_descriptor_t* cur_fd = fd_get(fd);
+    if(cur_fd == NULL || cur_fd->operation_table != &file_operation_table || buf == NULL || nbytes < 0) return -1;
+    return read_data(cur_fd->inode_index, offset, buf, nbytes);
+}
+
+/* file_pwrite
+ *
+ * write an opened regular file at offset, the file_position is not used nor changed
+ * Inputs: fd - the file descriptor
+ *         buf - the buffer holding the content
+ *         nbytes - the number of bytes to write
+ *         offset - the position in the file to write at
+ * Outputs: None
+ * Return: number of bytes written, -1 if fails
+ * Side Effects: the file grows if the write goes past its end
+ */
+int32_t file_pwrite(int32_t fd, const void* buf, int32_t nbytes, uint32_t offset){
+    file_descriptor_t* cur_fd = fd_get(fd);
+    if(cur_fd == NULL || cur_fd->operation_table != &file_operation_table || buf == NULL || nbytes < 0) return -1;
+    return write_data(cur_fd->inode_index, offset, buf, nbytes);
+}
+
+/* file_fstat
+ *
+ * get the type, inode and length of an opened file, directory or RTC
+ * Inputs: fd - the file descriptor
+ *         st - filled with the information
+ * Outputs: None
+ * Return: 0 if successfully, -1 if fd is not opened or is a terminal
+ * Side Effects: None
+ */
+int32_t file_fstat(int32_t fd, stat_t* st){
+    file_descriptor_t* cur_fd = fd_get(fd);
+    if(cur_fd == NULL || st == NULL) return -1;
+
+    st->inode_index = cur_fd->inode_index;
+    st->flags = 0;
+    if(cur_fd->operation_table == &file_operation_table){
+        st->file_type = REGULAR_FILE_TYPE;
+        st->length = inode_length(cur_fd->inode_index);
+    } else if(cur_fd->operation_table == &dir_operation_table){
+        st->file_type = DIR_FILE_TYPE;
+        st->length = dir_size(cur_fd->inode_index) * DIR_ENTRY_SIZE;
+    } else if(cur_fd->operation_table == &RTC_operation_table){
+        st->file_type = RTC_FILE_TYPE;
+        st->length = 0;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+/* file_stat
+ *
+ * get the type, inode and length of the file at a path without opening it
+ * Inputs: fname - the path of the file
+ *         st - filled with the information
+ * Outputs: None
+ * Return: 0 if successfully, -1 if there is no such file
+ * Side Effects: None
+ */
+int32_t file_stat(const uint8_t* fname, stat_t* st){
+    dentry_t dentry;
+    if(st == NULL || read_dentry_by_name(fname, &dentry) == -1) return -1;
+    st->file_type = dentry.file_type;
+    st->inode_index = dentry.inode_index;
+    st->length = dentry_length(&dentry);
+    st->flags = 0;
+    return 0;
 }
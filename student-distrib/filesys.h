@@ -1,4 +1,4 @@
-/* filesys.h - Defines the read-only file system
+/* filesys.h - Defines the file system
  * vim:ts=4 noexpandtab
  */
 
@@ -9,6 +9,8 @@
 
 /* define basic constant for mp3 file system */
 #define BLOCK_SIZE 4096     // 4kB per block
+#define FS_BOOT_BLOCK 0     // the boot block is the first block of the image, the inodes follow it
+#define FS_IDE_DRIVE 0      // the drive whose image is used in place of the multiboot module, the master
 #define DIR_ENTRY_SIZE 64   // each directory entry takes 64 bytes
 #define MAX_FILE_NUM 63     // max number of files supported as (BLOCK_SIZE / DIR_ENTRY_SIZE) - 1(statistics) = 63
 
@@ -19,6 +21,32 @@
 #define DIR_FILE_TYPE 1     // unique number to represent directory file type
 #define REGULAR_FILE_TYPE 2 // unique number to represent regular file type, only this type has meaningful index node (inode)
 
+/* define basic constant for the file name index */
+#define DENTRY_HASH_SIZE 128        // buckets in the name hash table, power of 2 and at least twice MAX_FILE_NUM
+#define NEG_CACHE_SIZE 8            // number of recently missed names remembered
+#define FNV_OFFSET_BASIS 2166136261U
+#define FNV_PRIME 16777619U
+
+/* define basic constant for the data block allocator */
+#define MAX_DATA_BLOCK_NUM 8192     // max data blocks tracked by the free block bitmap (32 MB of data)
+#define BITMAP_WORD_BITS 32         // blocks tracked by one bitmap word
+#define BITMAP_WORD_FULL 0xFFFFFFFF // every block of the word in use
+#define MAX_FILE_BLOCKS ((BLOCK_SIZE - 4) / 4)  // data block indices held by one inode
+#define INODE_INLINE 0x80000000     // length flag, the data is held by the inode in place of the block indices
+#define INLINE_MAX_SIZE (BLOCK_SIZE - 4)        // bytes of data an inode can hold inline
+#define MAX_INODE_NUM 1024          // max inodes tracked by the free inode bitmap
+
+/* define basic constant for directories */
+#define ROOT_DIR_INODE 0            // a directory dentry with inode 0 is the root, whose dentries are in the boot block
+#define DENTRIES_PER_BLOCK (BLOCK_SIZE / DIR_ENTRY_SIZE)    // dentries held by one data block of a directory
+#define MAX_PATH_LEN 128            // max length of a path, components are separated by '/'
+#define DCACHE_SIZE 64              // entries in the per-component lookup cache, power of 2
+
+/* origins of lseek */
+#define SEEK_SET 0          // from the start of the file
+#define SEEK_CUR 1          // from the current position
+#define SEEK_END 2          // from the end of the file
+
 /* define basic constant for file descriptor */
 #define IN_USE 1            // mark the flag field in file descriptor as being used
 #define READY_TO_BE_USED 0  // mark the flag field in file descriptor as can be used
@@ -28,7 +56,7 @@
 typedef struct dentry {
     uint8_t file_name[MAX_FILE_NAME];
     uint32_t file_type;
-    uint32_t inode_index;   // only meaningful to regular file type
+    uint32_t inode_index;   // only meaningful to regular file and directory types, ROOT_DIR_INODE for the root
     uint8_t reserved[24];   // 24 reserved bytes, DIR_ENTRY_SIZE - MAX_FILE_NAME - 4(file_type) - 4(inode_index) = 24
 } dentry_t;
 
@@ -41,10 +69,36 @@ typedef struct boot_block {
 } boot_block_t;
 
 typedef struct inode {
-    uint32_t length;
-    uint32_t data_block_index[(BLOCK_SIZE - 4) / 4];    // the rest of block all store data block index
+    uint32_t length;        // INODE_INLINE is set for a file held inline
+    union {
+        uint32_t data_block_index[MAX_FILE_BLOCKS]; // the rest of block all store data block index
+        uint8_t inline_data[INLINE_MAX_SIZE];       // or the data itself for a small file
+    };
 } inode_t;
 
+typedef struct dcache_entry {
+    uint32_t dir;           // inode of the directory searched
+    uint32_t hash;          // filename_hash of the component
+    int32_t index;          // index of the dentry in the directory, -1 if the entry is empty
+} dcache_entry_t;
+
+/* one record filled by getdents */
+typedef struct dirent {
+    uint8_t file_name[MAX_FILE_NAME];   // not terminated when exactly MAX_FILE_NAME bytes long
+    uint32_t file_type;
+    uint32_t inode_index;
+    uint32_t length;                    // bytes of the file or directory, 0 for devices
+} dirent_t;
+
+/* file information filled by stat and fstat */
+#define STAT_PIPE_LOST 0x1              // a write to the pipe came back short, some of its data never got in
+typedef struct stat {
+    uint32_t file_type;
+    uint32_t inode_index;
+    uint32_t length;                    // bytes of the file or directory, 0 for devices
+    uint32_t flags;                     // STAT_PIPE_LOST or 0
+} stat_t;
+
 typedef struct data_block {
     uint8_t data[BLOCK_SIZE];
 } data_block_t;
@@ -54,6 +108,7 @@ typedef int32_t (*open_t)(const uint8_t* filename);
 typedef int32_t (*close_t)(int32_t fd);
 typedef int32_t (*read_t)(int32_t fd, void* buf, int32_t nbytes);
 typedef int32_t (*write_t)(int32_t fd, const void* buf, int32_t nbytes);
+typedef int32_t (*poll_t)(int32_t fd);
 
 /* define data structure used by file descriptor */
 typedef struct operation_table {
@@ -61,13 +116,15 @@ typedef struct operation_table {
     close_t close_operation;
     read_t read_operation;
     write_t write_operation;
+    poll_t poll_operation;              // POLLIN and POLLOUT if a read or write would not wait, NULL if they never wait
 } operation_table_t;
 
 typedef struct file_descriptor {
     operation_table_t* operation_table; // file type-specific operation table
-    uint32_t inode_index;               // only meaningful to regular file type, 0 for other types
+    uint32_t inode_index;               // only meaningful to regular file and directory types, 0 for other types
     uint32_t file_position;             // keep track of where the user is currently reading from the file, updated each time after system call read
     uint32_t flags;                     // set to indicate this file descriptor is "in use"
+    uint32_t refcnt;                    // fds pointing at this open file, across dup and inheritance
 } file_descriptor_t;
 
 
@@ -76,7 +133,19 @@ typedef struct file_descriptor {
 /* initialize the file system*/
 void filesys_init(boot_block_t* in_memory_boot_block);
 
-/* find the file by name and load that file into input dentry */
+/* hash a file name of at most MAX_FILE_NAME bytes */
+uint32_t filename_hash(const uint8_t* fname);
+
+/* rebuild the name index after dentries change */
+void dentry_index_build(void);
+
+/* rebuild the free data block bitmap from the inodes */
+void db_bitmap_build(void);
+
+/* rebuild the free inode bitmap from the dentries */
+void inode_bitmap_build(void);
+
+/* find the file by path and load that file into input dentry */
 int32_t read_dentry_by_name(const uint8_t* fname, dentry_t* dentry);
 
 /* find the file by index and load that file into input dentry */
@@ -85,6 +154,28 @@ int32_t read_dentry_by_index(uint32_t index, dentry_t* dentry);
 /* read up to length bytes starting from position offset in the file with inode number inode */
 int32_t read_data(uint32_t inode, uint32_t offset, uint8_t* buf, uint32_t length);
 
+/* replace the content of the file with inode number inode by length bytes of buf */
+int32_t write_data(uint32_t inode, uint32_t offset, const uint8_t* buf, uint32_t length);
+int32_t truncate_data(uint32_t inode, uint32_t length);
+
+/* add an empty regular file, or remove a regular file or empty directory with its inode and data blocks */
+int32_t file_create(const uint8_t* fname);
+int32_t file_unlink(const uint8_t* fname);
+
+/* add a directory, or change the working directory of the current process */
+int32_t dir_mkdir(const uint8_t* path);
+int32_t dir_chdir(const uint8_t* path);
+
+/* fill a buffer with as many dentries of an opened directory as fit */
+int32_t dir_getdents(int32_t fd, dirent_t* buf, int32_t nbytes);
+
+/* random access to an opened file and file information */
+int32_t file_lseek(int32_t fd, int32_t offset, int32_t whence);
+int32_t file_pread(int32_t fd, void* buf, int32_t nbytes, uint32_t offset);
+int32_t file_pwrite(int32_t fd, const void* buf, int32_t nbytes, uint32_t offset);
+int32_t file_fstat(int32_t fd, stat_t* st);
+int32_t file_stat(const uint8_t* fname, stat_t* st);
+
 
 /* type-specific operations used in jump table in file descriptor */
 
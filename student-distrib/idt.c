@@ -5,6 +5,14 @@
 #include "idt.h"
 #include "lib.h"
 
+/* only held until sysenter_handler loads the kernel stack of the process */
+static uint32_t sysenter_stack[SYSENTER_STACK_WORDS];
+
+/* write a model specific register, the high half is always 0 here */
+static inline void wrmsr(uint32_t msr, uint32_t value) {
+    asm volatile("wrmsr" : : "c"(msr), "a"(value), "d"(0));
+}
+
 void temp_syscall_handler() {
     printf("Syscall invoked\n");
 }
@@ -60,6 +68,24 @@ void inline interrupt_init() {
     SET_IDT_ENTRY(idt[PIT_VEC], intr_PIT_handler);
     SET_IDT_ENTRY(idt[KEYBOARD_VEC], intr_keyboard_handler);
     SET_IDT_ENTRY(idt[RTC_VEC], intr_RTC_handler);
+    SET_IDT_ENTRY(idt[IDE_VEC], intr_IDE_handler);
+}
+
+/* sysenter_init
+ *
+ * point SYSENTER at sysenter_handler if the CPU has it, int $0x80 works either way
+ * Inputs: None
+ * Outputs: None
+ * Side Effects: write the SYSENTER MSRs
+ */
+static void sysenter_init() {
+    uint32_t eax, ebx, ecx, edx;
+    asm volatile("cpuid" : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx) : "a"(CPUID_FEATURES));
+    if (!(edx & CPUID_SEP))
+        return;
+    wrmsr(MSR_SYSENTER_CS, KERNEL_CS);
+    wrmsr(MSR_SYSENTER_ESP, (uint32_t)&sysenter_stack[SYSENTER_STACK_WORDS]);
+    wrmsr(MSR_SYSENTER_EIP, (uint32_t)sysenter_handler);
 }
 
 void inline syscall_init() {
@@ -79,6 +105,7 @@ void idt_init() {
     exception_init();
     interrupt_init();
     syscall_init();
+    sysenter_init();
     lidt(idt_desc_ptr);
 }
 
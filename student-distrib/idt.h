@@ -10,6 +10,15 @@
 #define KEYBOARD_VEC 0x21
 #define RTC_VEC 0x28
 #define PIT_VEC 0x20
+#define IDE_VEC 0x2E
+
+/* fast system calls */
+#define MSR_SYSENTER_CS 0x174
+#define MSR_SYSENTER_ESP 0x175
+#define MSR_SYSENTER_EIP 0x176
+#define CPUID_FEATURES 1            // leaf with the feature flags in EDX
+#define CPUID_SEP 0x800             // SYSENTER and SYSEXIT are there
+#define SYSENTER_STACK_WORDS 64
 
 extern void idt_init();
 extern void temp_syscall_handler();
@@ -24,7 +24,9 @@ extern void exc_machine_check();
 extern void exc_SIMD_error();
 
 extern void syscall_handler();
+extern void sysenter_handler();
 
 extern void intr_RTC_handler();
 extern void intr_keyboard_handler();
 extern void intr_PIT_handler();
+extern void intr_IDE_handler();
@@ -0,0 +1,99 @@
+/* irqstat.c - How often each interrupt and exception runs and how long its handler takes,
+ * timed with the TSC by the wrappers in idtentry.S
+ * vim:ts=4 noexpandtab
+ */
+
+#include "irqstat.h"
+#include "lib.h"
+
+#define IRQSTAT_CYCLES_MAX 0xFFFFFFFF
+
+volatile uint32_t irqstat_active = 0;
+uint32_t irqstat_start[IRQSTAT_VECTORS][2];
+static irqstat_t irqstats[IRQSTAT_VECTORS];
+
+/* irqstat_init
+ *
+ * start with nothing counted and timing off, before interrupts are turned on
+ * Inputs: None
+ * Outputs: None
+ * Side Effects: None
+ */
+void irqstat_init(void){
+    memset(irqstat_start, 0, sizeof(irqstat_start));
+    memset(irqstats, 0, sizeof(irqstats));
+}
+
+/* irqstat_record
+ *
+ * count a run of the handler of a vector, from the TSC at its entry to the one given. The
+ * PIT handler may switch to another process and come back out of that one's earlier tick,
+ * which still pairs the newest entry with the next exit as interrupts do not nest. An exit
+ * with no entry, of a handler that was already running when timing was turned on, is skipped
+ * Inputs: vector - the vector, below IRQSTAT_VECTORS
+ *         end_low, end_high - the TSC once the handler returned
+ * Outputs: None
+ * Side Effects: clear the entry TSC of the vector
+ */
+void irqstat_record(uint32_t vector, uint32_t end_low, uint32_t end_high){
+    irqstat_t* stat = &(irqstats[vector]);
+    uint32_t start_low = irqstat_start[vector][0];
+    uint32_t start_high = irqstat_start[vector][1];
+    uint32_t cycles = end_low - start_low;
+
+    if(start_low == 0 && start_high == 0) return;
+    irqstat_start[vector][0] = 0;
+    irqstat_start[vector][1] = 0;
+    if(end_high - start_high > 1 || (end_high != start_high && end_low >= start_low)) cycles = IRQSTAT_CYCLES_MAX;
+    stat->count++;
+    stat->total_low += cycles;
+    if(stat->total_low < cycles) stat->total_high++;
+    if(cycles > stat->max) stat->max = cycles;
+    stat->hist[cycles ? bsr(cycles) : 0]++;
+}
+
+/* irqstat_read
+ *
+ * copy the table of every vector, taken with interrupts off so each entry is whole
+ * Inputs: buf - filled with IRQSTAT_VECTORS entries, or as many bytes as fit
+ *         nbytes - the size of buf
+ * Outputs: the number of bytes copied, -1 if buf is NULL or nbytes is negative
+ * Side Effects: None
+ */
+int32_t irqstat_read(void* buf, int32_t nbytes){
+    uint32_t flags;
+    if(buf == NULL || nbytes < 0) return -1;
+    if((uint32_t)nbytes > sizeof(irqstats)) nbytes = sizeof(irqstats);
+    cli_and_save(flags);
+    memcpy(buf, irqstats, nbytes);
+    restore_flags(flags);
+    return nbytes;
+}
+
+/* irqstat_ctl
+ *
+ * turn timing of the handlers on or off, or copy out what was counted
+ * Inputs: cmd - IRQSTAT_OFF, IRQSTAT_ON or IRQSTAT_READ
+ *         buf - filled by IRQSTAT_READ, unused otherwise
+ *         nbytes - the size of buf
+ * Outputs: the bytes copied for IRQSTAT_READ, 0 for the others, -1 if cmd or buf is invalid
+ * Side Effects: IRQSTAT_ON starts every count over
+ */
+int32_t irqstat_ctl(int32_t cmd, void* buf, int32_t nbytes){
+    uint32_t flags;
+    switch(cmd){
+        case IRQSTAT_OFF:
+            irqstat_active = 0;
+            return 0;
+        case IRQSTAT_ON:
+            cli_and_save(flags);
+            irqstat_init();
+            irqstat_active = 1;
+            restore_flags(flags);
+            return 0;
+        case IRQSTAT_READ:
+            return irqstat_read(buf, nbytes);
+        default:
+            return -1;
+    }
+}
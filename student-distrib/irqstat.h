@@ -0,0 +1,45 @@
+/* irqstat.h - Defines the per-vector counts and durations of interrupts and exceptions
+ * vim:ts=4 noexpandtab
+ */
+
+#ifndef _IRQSTAT_H
+#define _IRQSTAT_H
+
+#include "types.h"
+
+#define IRQSTAT_VECTORS 0x30            // the exceptions and the vectors of the two PICs
+#define IRQSTAT_BUCKETS 32              // bucket i counts handlers of 2^i up to 2^(i+1)-1 cycles
+
+/* commands of the irqstat system call */
+#define IRQSTAT_OFF 0                   // stop timing, the counts are kept
+#define IRQSTAT_ON 1                    // start timing with every count at 0
+#define IRQSTAT_READ 2                  // copy the table, IRQSTAT_VECTORS entries
+
+typedef struct irqstat {
+    uint32_t count;
+    uint32_t total_low;                 // TSC cycles of every run, 64 bits
+    uint32_t total_high;
+    uint32_t max;
+    uint32_t hist[IRQSTAT_BUCKETS];
+} irqstat_t;
+
+/* set while handlers are timed, the wrappers skip the TSC and irqstat_record while it is 0 */
+extern volatile uint32_t irqstat_active;
+
+/* TSC when the wrapper of each vector was entered, low word then high word, written by idtentry.S,
+ * 0 once irqstat_record used it */
+extern uint32_t irqstat_start[IRQSTAT_VECTORS][2];
+
+/* start with nothing counted */
+void irqstat_init(void);
+
+/* count a run of a handler, from idtentry.S once it returns */
+void irqstat_record(uint32_t vector, uint32_t end_low, uint32_t end_high);
+
+/* copy the table out */
+int32_t irqstat_read(void* buf, int32_t nbytes);
+
+/* the irqstat system call */
+int32_t irqstat_ctl(int32_t cmd, void* buf, int32_t nbytes);
+
+#endif /* _IRQSTAT_H */
@@ -14,6 +14,13 @@
 #include "devices/rtc.h"
 #include "devices/keyboard.h"
 #include "devices/pit.h"
+#include "devices/ide.h"
+#include "bcache.h"
+#include "kpage.h"
+#include "tmpfs.h"
+#include "pipe.h"
+#include "vdso.h"
+#include "irqstat.h"
 #include "devices/vt.h"
 #include "syscall_task.h"
 #include "dynamic_alloc.h"
@@ -159,14 +166,21 @@ void entry(unsigned long magic, unsigned long addr) {
     /* Initialize devices, memory, filesystem, enable device interrupts on the
      * PIC, any other initialization stuff... */
     idt_init();
+    irqstat_init();
     RTC_init();
     pit_init();
     keyboard_init();
+    ide_init();
+    bcache_init();
     filesys_init(in_memory_boot_block);
 
     /* Initialize paging */
     paging_init();
+    vdso_init();
     dynamic_allocation_init();
+    kpage_init();
+    tmpfs_init();
+    pipe_init();
 
 
     /* Enable interrupts */
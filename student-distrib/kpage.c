@@ -0,0 +1,78 @@
+/* kpage.c - Hands out the 4kB pages of the kernel page pool
+ * vim:ts=4 noexpandtab
+ */
+
+#include "kpage.h"
+#include "lib.h"
+
+static uint32_t kpage_bitmap[KPAGE_BITMAP_WORDS];  // a set bit is a page in use
+static uint32_t kpage_free_num;
+
+/* kpage_init
+ *
+ * set up the pool with every page free, the pool is mapped by paging_init
+ * Inputs: None
+ * Outputs: None
+ * Side Effects: None
+ */
+void kpage_init(void){
+    memset(kpage_bitmap, 0, sizeof(kpage_bitmap));
+    kpage_free_num = KPAGE_NUM;
+}
+
+/* kpage_alloc
+ *
+ * take the lowest free page of the pool
+ * Inputs: None
+ * Outputs: the zeroed page, NULL if every page is in use
+ * Side Effects: None
+ */
+void* kpage_alloc(void){
+    uint32_t flags;
+    uint32_t i;
+    uint32_t index;
+    uint8_t* page;
+    cli_and_save(flags);
+    for(i = 0; i < KPAGE_BITMAP_WORDS; i++){
+        if(kpage_bitmap[i] == KPAGE_WORD_FULL) continue;
+        index = i * KPAGE_WORD_BITS + bsf(~kpage_bitmap[i]);
+        kpage_bitmap[i] |= 1U << (index % KPAGE_WORD_BITS);
+        kpage_free_num--;
+        restore_flags(flags);
+        page = (uint8_t*)(KPAGE_POOL_ADDR + index * PAGE_SIZE);
+        memset(page, 0, PAGE_SIZE);
+        return page;
+    }
+    restore_flags(flags);
+    return NULL;
+}
+
+/* kpage_free
+ *
+ * give a page back to the pool
+ * Inputs: page - a page from kpage_alloc
+ * Outputs: None
+ * Side Effects: None
+ */
+void kpage_free(void* page){
+    uint32_t flags;
+    uint32_t index = ((uint32_t)page - KPAGE_POOL_ADDR) / PAGE_SIZE;
+    if((uint32_t)page < KPAGE_POOL_ADDR || index >= KPAGE_NUM) return;
+    cli_and_save(flags);
+    if(kpage_bitmap[index / KPAGE_WORD_BITS] & (1U << (index % KPAGE_WORD_BITS))){
+        kpage_bitmap[index / KPAGE_WORD_BITS] &= ~(1U << (index % KPAGE_WORD_BITS));
+        kpage_free_num++;
+    }
+    restore_flags(flags);
+}
+
+/* kpage_free_count
+ *
+ * get the number of free pages
+ * Inputs: None
+ * Outputs: the free pages of the pool
+ * Side Effects: None
+ */
+uint32_t kpage_free_count(void){
+    return kpage_free_num;
+}
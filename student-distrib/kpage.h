@@ -0,0 +1,26 @@
+/* kpage.h - Defines the allocator of kernel pages
+ * vim:ts=4 noexpandtab
+ */
+
+#ifndef _KPAGE_H
+#define _KPAGE_H
+
+#include "types.h"
+#include "paging.h"
+
+#define KPAGE_POOL_SIZE 0x400000                    // the 4MB page at KPAGE_POOL_ADDR
+#define KPAGE_NUM (KPAGE_POOL_SIZE / PAGE_SIZE)     // 4kB pages in the pool
+#define KPAGE_WORD_BITS 32                          // pages tracked by one bitmap word
+#define KPAGE_WORD_FULL 0xFFFFFFFF                  // every page of the word in use
+#define KPAGE_BITMAP_WORDS (KPAGE_NUM / KPAGE_WORD_BITS)
+
+/* set up the pool with every page free */
+void kpage_init(void);
+/* get a zeroed page, NULL if the pool is used up */
+void* kpage_alloc(void);
+/* give a page back */
+void kpage_free(void* page);
+/* number of free pages */
+uint32_t kpage_free_count(void);
+
+#endif /* _KPAGE_H */
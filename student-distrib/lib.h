@@ -77,6 +77,30 @@ static inline uint32_t inl(port) {
     return val;
 }
 
+/* Returns the index of the least significant set bit of "word",
+ * which must not be zero */
+static inline uint32_t bsf(uint32_t word) {
+    uint32_t idx;
+    asm volatile ("bsfl %1, %0"
+            : "=r"(idx)
+            : "rm"(word)
+            : "cc"
+    );
+    return idx;
+}
+
+/* Returns the index of the most significant set bit of "word",
+ * which must not be zero */
+static inline uint32_t bsr(uint32_t word) {
+    uint32_t idx;
+    asm volatile ("bsrl %1, %0"
+            : "=r"(idx)
+            : "rm"(word)
+            : "cc"
+    );
+    return idx;
+}
+
 /* Writes a byte to a port */
 #define outb(data, port)                \
 do {                                    \
@@ -100,7 +124,7 @@ do {                                    \
 /* Writes four bytes to four consecutive ports */
 #define outl(data, port)                \
 do {                                    \
-    asm volatile ("outl %l1, (%w0)"     \
+    asm volatile ("outl %k1, (%w0)"     \
             :                           \
             : "d"(port), "a"(data)      \
             : "memory", "cc"            \
@@ -158,4 +182,13 @@ do {                                    \
     );                                  \
 } while (0)
 
+/* Read the time-stamp counter
+ * Stores the low and high 32 bits of the cycle count in "low" and "high" */
+#define rdtsc(low, high)                \
+do {                                    \
+    asm volatile ("rdtsc"               \
+            : "=a"(low), "=d"(high)     \
+    );                                  \
+} while (0)
+
 #endif /* _LIB_H */
@@ -123,6 +123,10 @@ void paging_init(){
     page_directory[(NANI_STATIC_BUF_ADDR + 3 * FOUR_MB) >> 22].PS = 1;
     page_directory[(NANI_STATIC_BUF_ADDR + 3 * FOUR_MB) >> 22].ADDR = (NANI_STATIC_BUF_ADDR + 2 * FOUR_MB) >> 12;
 
+    // Kernel page pool, supervisor only
+    page_directory[KPAGE_POOL_ADDR >> 22].P = 1;
+    page_directory[KPAGE_POOL_ADDR >> 22].PS = 1;
+    page_directory[KPAGE_POOL_ADDR >> 22].ADDR = KPAGE_POOL_ADDR >> 12;
 
     // Set a page for GUI
     uint32_t vbe_index = QEMU_BASE_ADDR >> 22;
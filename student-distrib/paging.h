@@ -17,6 +17,9 @@
 #define VID_MEM_POS (VID_MEM_ADDR >> 12)
 #define GUI_VID_MEM_POS (GUI_VID_MEM_ADDR >> 12)
 #define NANI_STATIC_BUF_ADDR 0x7000000 // 112 MB
+#define KPAGE_POOL_ADDR 0x6000000 // 96 MB, the 4MB handed out by kpage_alloc
+#define VDSO_ADDR 0x8401000 // 132 MB + 4 kB, the read-only page after the vidmap page
+#define SIGTRAMP_ADDR 0x8402000 // 132 MB + 8 kB, the read-only page signal handlers return to
 
 
 /*
@@ -3,8 +3,12 @@
 #include "types.h"
 #include "filesys.h"
 #include "signal.h"
+#include "uring.h"
+#include "trace.h"
 
-#define NUM_FILES 8
+#define NUM_FILES 8         // fds held in the pcb itself, the table grows past them
+#define MAX_FILES 64        // fds of one process once its table has grown
+#define FD_BITMAP_WORDS (MAX_FILES / 32)
 #define MAX_PID_NUM 6
 #define FOUR_MB 0x400000
 #define EIGHT_MB 0x800000
@@ -19,13 +23,23 @@
 typedef struct pcb_s pcb_t;
 struct pcb_s {
     uint32_t pid;
-    file_descriptor_t fd_array[NUM_FILES];
+    uint32_t sig_pending;                       // SIG_BIT of the signals sent and not handled yet
+    uint32_t sig_blocked;                       // SIG_BIT of the signals held back, both read by idtentry.S
+    file_descriptor_t** fd_array;               // fd_inline until more than NUM_FILES fds are needed
+    file_descriptor_t* fd_inline[NUM_FILES];
+    uint32_t fd_max;                            // slots in fd_array
+    uint32_t fd_bitmap[FD_BITMAP_WORDS];        // set for the fds in use
     uint8_t args[ARG_LEN + 1];
     pcb_t* parent_pcb;
     signal_t signals[SIG_NUM];
     uint32_t esp;
     uint32_t ebp;
     uint32_t vt; // which terminal is executing this process
+    uint32_t cwd; // inode of the working directory, ROOT_DIR_INODE for the root
+    uring_t* uring; // rings of batched system calls in user memory, NULL until uring_setup
+    uint32_t trace_children; // the programs it starts are traced
+    trace_ring_t* trace; // its own traced calls, NULL if it is not traced
+    trace_ring_t* trace_done; // the calls of the last traced child that halted
 };
 
 extern pcb_t* get_pcb_by_pid(uint32_t pid);
@@ -0,0 +1,318 @@
+/* pipe.c - Kernel pipes, a ring buffer of kernel pages between a read end and a write end
+ * vim:ts=4 noexpandtab
+ */
+
+#include "pipe.h"
+#include "kpage.h"
+#include "fdtable.h"
+#include "lib.h"
+#include "poll.h"
+#include "devices/vt.h"
+
+operation_table_t pipe_read_operation_table = {
+    .open_operation = pipe_open,
+    .close_operation = pipe_read_close,
+    .read_operation = pipe_read,
+    .write_operation = pipe_write,
+    .poll_operation = pipe_poll
+};
+
+operation_table_t pipe_write_operation_table = {
+    .open_operation = pipe_open,
+    .close_operation = pipe_write_close,
+    .read_operation = pipe_read,
+    .write_operation = pipe_write,
+    .poll_operation = pipe_poll
+};
+
+static pipe_t pipes[MAX_PIPES];
+
+/* pipe_init
+ *
+ * set up with no pipe in use
+ * Inputs: None
+ * Outputs: None
+ * Side Effects: None
+ */
+void pipe_init(void){
+    memset(pipes, 0, sizeof(pipes));
+}
+
+/* pipe_peer_runs
+ *
+ * check if a process other than the current one holds an end of a pipe and can run,
+ * a process waiting in execute for its child never runs before the child halts
+ * Inputs: index - the pipe
+ *         operation_table - the end to look for
+ * Outputs: 1 if such a process exists, 0 if not
+ * Side Effects: None
+ */
+static int32_t pipe_peer_runs(uint32_t index, operation_table_t* operation_table){
+    uint32_t i, fd, pid;
+    pcb_t* pcb;
+    file_descriptor_t* file;
+    for(i = 0; i < NUM_TERMS; i++){
+        pid = vt_state[i].active_pid;
+        if(pid >= MAX_PID_NUM || pid == (uint32_t)get_current_pid()) continue;
+        pcb = get_pcb_by_pid(pid);
+        for(fd = 0; fd < pcb->fd_max; fd++){
+            file = pcb->fd_array[fd];
+            if(file != NULL && file->operation_table == operation_table && file->inode_index == index) return 1;
+        }
+    }
+    return 0;
+}
+
+/* pipe_put
+ *
+ * free a pipe once neither end is open
+ * Inputs: p - the pipe
+ * Outputs: None
+ * Side Effects: None
+ */
+static void pipe_put(pipe_t* p){
+    uint32_t i;
+    if(p->readers != 0 || p->writers != 0) return;
+    for(i = 0; i < PIPE_PAGES; i++){
+        if(p->pages[i] != NULL) kpage_free(p->pages[i]);
+        p->pages[i] = NULL;
+    }
+    p->in_use = 0;
+}
+
+/* pipe_create
+ *
+ * make a pipe at the two lowest free fds
+ * Inputs: fds - filled with the read end and the write end
+ * Outputs: 0 if successful, -1 if fds is NULL or there are too many pipes or files open
+ * Side Effects: None
+ */
+int32_t pipe_create(int32_t* fds){
+    uint32_t i;
+    int32_t rfd, wfd;
+    pipe_t* p = NULL;
+    if(fds == NULL) return -1;
+    for(i = 0; i < MAX_PIPES; i++){
+        if(!pipes[i].in_use){
+            p = &(pipes[i]);
+            break;
+        }
+    }
+    if(p == NULL) return -1;
+
+    memset(p, 0, sizeof(pipe_t));
+    p->in_use = 1;
+    rfd = fd_alloc(&pipe_read_operation_table, i);
+    if(rfd == -1){
+        p->in_use = 0;
+        return -1;
+    }
+    wfd = fd_alloc(&pipe_write_operation_table, i);
+    if(wfd == -1){
+        fd_close(rfd);
+        p->in_use = 0;
+        return -1;
+    }
+    p->readers = 1;
+    p->writers = 1;
+    fds[0] = rfd;
+    fds[1] = wfd;
+    return 0;
+}
+
+/* pipe_owns
+ *
+ * check if an fd is either end of a pipe
+ * Inputs: fd - the fd
+ * Outputs: 1 if it is, 0 if not
+ * Side Effects: None
+ */
+int32_t pipe_owns(int32_t fd){
+    file_descriptor_t* cur_fd = fd_get(fd);
+    if(cur_fd == NULL) return 0;
+    return cur_fd->operation_table == &pipe_read_operation_table || cur_fd->operation_table == &pipe_write_operation_table;
+}
+
+/* pipe_fstat
+ *
+ * fill the information of a pipe end, its length is the number of unread bytes and
+ * STAT_PIPE_LOST is set if some write to it came back short
+ * Inputs: fd - the fd
+ *         st - filled with the information
+ * Outputs: 0 if successful, -1 if fd is not a pipe
+ * Side Effects: None
+ */
+int32_t pipe_fstat(int32_t fd, stat_t* st){
+    file_descriptor_t* cur_fd = fd_get(fd);
+    if(st == NULL || !pipe_owns(fd)) return -1;
+    st->file_type = PIPE_FILE_TYPE;
+    st->inode_index = cur_fd->inode_index;
+    st->length = pipes[cur_fd->inode_index].count;
+    st->flags = pipes[cur_fd->inode_index].lost ? STAT_PIPE_LOST : 0;
+    return 0;
+}
+
+/* pipe_open
+ *
+ * pipes have no name, they are only made by pipe_create
+ * Inputs: filename - ignored
+ * Outputs: -1
+ * Side Effects: None
+ */
+int32_t pipe_open(const uint8_t* filename){
+    return -1;
+}
+
+/* pipe_read_close
+ *
+ * close an fd of the read end, the writers see no reader once its last open file is gone
+ * Inputs: fd - the fd
+ * Outputs: 0 if successful, -1 if fd is not a read end
+ * Side Effects: the pipe is freed with its last end
+ */
+int32_t pipe_read_close(int32_t fd){
+    file_descriptor_t* cur_fd = fd_get(fd);
+    pipe_t* p;
+    int32_t left;
+    if(cur_fd == NULL || cur_fd->operation_table != &pipe_read_operation_table) return -1;
+    p = &(pipes[cur_fd->inode_index]);
+    left = fd_close(fd);
+    if(left == -1) return -1;
+    if(left == 0){
+        p->readers--;
+        pipe_put(p);
+    }
+    return 0;
+}
+
+/* pipe_write_close
+ *
+ * close an fd of the write end, the readers see the end of the data once its last open file is gone
+ * Inputs: fd - the fd
+ * Outputs: 0 if successful, -1 if fd is not a write end
+ * Side Effects: the pipe is freed with its last end
+ */
+int32_t pipe_write_close(int32_t fd){
+    file_descriptor_t* cur_fd = fd_get(fd);
+    pipe_t* p;
+    int32_t left;
+    if(cur_fd == NULL || cur_fd->operation_table != &pipe_write_operation_table) return -1;
+    p = &(pipes[cur_fd->inode_index]);
+    left = fd_close(fd);
+    if(left == -1) return -1;
+    if(left == 0){
+        p->writers--;
+        pipe_put(p);
+    }
+    return 0;
+}
+
+/* pipe_read
+ *
+ * read unread bytes of a pipe, waiting while it is empty and a writer that can run is left
+ * Inputs: fd - the fd of the read end
+ *         buf - the buffer to fill
+ *         nbytes - the number of bytes wanted
+ * Outputs: the number of bytes read, 0 once nothing more can be written, -1 if fails
+ * Side Effects: the pages that were read up are freed
+ */
+int32_t pipe_read(int32_t fd, void* buf, int32_t nbytes){
+    file_descriptor_t* cur_fd = fd_get(fd);
+    uint32_t index, flags, offset, len;
+    int32_t done = 0;
+    pipe_t* p;
+    if(cur_fd == NULL || cur_fd->operation_table != &pipe_read_operation_table || buf == NULL || nbytes < 0) return -1;
+    index = cur_fd->inode_index;
+    p = &(pipes[index]);
+
+    /* interrupts stay on so the writer gets scheduled */
+    while(p->count == 0 && p->writers > 0 && pipe_peer_runs(index, &pipe_write_operation_table));
+
+    cli_and_save(flags);
+    while((uint32_t)done < (uint32_t)nbytes && p->count > 0){
+        offset = p->head % PAGE_SIZE;
+        len = PAGE_SIZE - offset;
+        if(len > p->count) len = p->count;
+        if(len > (uint32_t)(nbytes - done)) len = nbytes - done;
+        memcpy((uint8_t*)buf + done, p->pages[p->head / PAGE_SIZE] + offset, len);
+        done += len;
+        p->count -= len;
+        p->head = (p->head + len) % PIPE_SIZE;
+        /* give the page back once it is read up, unless the writer already came around into it,
+         * which is when the unread bytes reach past the other PIPE_PAGES - 1 pages */
+        if(p->count == 0 || (p->head % PAGE_SIZE == 0 && p->count <= PIPE_SIZE - PAGE_SIZE)){
+            kpage_free(p->pages[(p->head + PIPE_SIZE - 1) / PAGE_SIZE % PIPE_PAGES]);
+            p->pages[(p->head + PIPE_SIZE - 1) / PAGE_SIZE % PIPE_PAGES] = NULL;
+        }
+    }
+    if(p->count == 0) p->head = 0;
+    restore_flags(flags);
+    return done;
+}
+
+/* pipe_write
+ *
+ * append bytes to a pipe, waiting while it is full and a reader that can run is left
+ * Inputs: fd - the fd of the write end
+ *         buf - the bytes to write
+ *         nbytes - the number of bytes
+ * Outputs: the number of bytes written, less than nbytes if the pipe filled up with no reader
+ *          that can run, -1 if fails or nothing could be written
+ * Side Effects: pages are allocated as the data needs them, a short write marks the pipe lost
+ */
+int32_t pipe_write(int32_t fd, const void* buf, int32_t nbytes){
+    file_descriptor_t* cur_fd = fd_get(fd);
+    uint32_t index, flags, tail, offset, len;
+    int32_t done = 0;
+    pipe_t* p;
+    uint8_t** page;
+    if(cur_fd == NULL || cur_fd->operation_table != &pipe_write_operation_table || buf == NULL || nbytes < 0) return -1;
+    index = cur_fd->inode_index;
+    p = &(pipes[index]);
+
+    while((uint32_t)done < (uint32_t)nbytes){
+        if(p->readers == 0) break;
+        /* interrupts stay on so the reader gets scheduled */
+        while(p->count == PIPE_SIZE && p->readers > 0 && pipe_peer_runs(index, &pipe_read_operation_table));
+        if(p->count == PIPE_SIZE) break;
+
+        cli_and_save(flags);
+        while((uint32_t)done < (uint32_t)nbytes && p->count < PIPE_SIZE){
+            tail = (p->head + p->count) % PIPE_SIZE;
+            offset = tail % PAGE_SIZE;
+            page = &(p->pages[tail / PAGE_SIZE]);
+            if(*page == NULL && (*page = kpage_alloc()) == NULL) break;
+            len = PAGE_SIZE - offset;
+            if(len > PIPE_SIZE - p->count) len = PIPE_SIZE - p->count;
+            if(len > (uint32_t)(nbytes - done)) len = nbytes - done;
+            memcpy(*page + offset, (const uint8_t*)buf + done, len);
+            done += len;
+            p->count += len;
+        }
+        restore_flags(flags);
+        /* out of kernel pages, keep what fit */
+        if((uint32_t)done < (uint32_t)nbytes && p->count < PIPE_SIZE) break;
+    }
+    if((uint32_t)done < (uint32_t)nbytes) p->lost = 1;
+    return (done == 0 && nbytes > 0) ? -1 : done;
+}
+
+/* pipe_poll
+ *
+ * check if a read of the read end or a write of the write end would return at once
+ * Inputs: fd - the fd
+ * Outputs: POLLIN for a read end and POLLOUT for a write end that would not wait, 0 if it would
+ * Side Effects: None
+ */
+int32_t pipe_poll(int32_t fd){
+    file_descriptor_t* cur_fd = fd_get(fd);
+    pipe_t* p;
+    if(cur_fd == NULL) return 0;
+    p = &(pipes[cur_fd->inode_index]);
+    if(cur_fd->operation_table == &pipe_read_operation_table){
+        if(p->count > 0 || p->writers == 0 || !pipe_peer_runs(cur_fd->inode_index, &pipe_write_operation_table)) return POLLIN;
+        return 0;
+    }
+    if(p->count < PIPE_SIZE || p->readers == 0 || !pipe_peer_runs(cur_fd->inode_index, &pipe_read_operation_table)) return POLLOUT;
+    return 0;
+}
@@ -0,0 +1,47 @@
+/* pipe.h - Defines the kernel pipes, a ring buffer with a read end and a write end
+ * vim:ts=4 noexpandtab
+ */
+
+#ifndef _PIPE_H
+#define _PIPE_H
+
+#include "types.h"
+#include "filesys.h"
+#include "paging.h"
+
+#define PIPE_FILE_TYPE 3            // file_type reported by fstat for either end of a pipe
+#define MAX_PIPES 16                // pipes that can exist at once
+#define PIPE_PAGES 64               // pages of one ring buffer, 256 kB
+#define PIPE_SIZE (PIPE_PAGES * PAGE_SIZE)
+
+typedef struct pipe {
+    uint32_t in_use;
+    uint32_t readers;               // open files of the read end, each may be shared by several fds
+    uint32_t writers;               // open files of the write end
+    uint32_t head;                  // ring offset of the first unread byte
+    uint32_t count;                 // unread bytes
+    uint32_t lost;                  // set once a write came back short, reported by fstat
+    uint8_t* pages[PIPE_PAGES];     // kernel pages, only the ones holding unread bytes are kept
+} pipe_t;
+
+/* set up with no pipe in use */
+void pipe_init(void);
+
+/* make a pipe, fds[0] reads what fds[1] writes */
+int32_t pipe_create(int32_t* fds);
+/* check if an fd is either end of a pipe */
+int32_t pipe_owns(int32_t fd);
+int32_t pipe_fstat(int32_t fd, stat_t* st);
+
+/* operations of the jump tables */
+int32_t pipe_open(const uint8_t* filename);
+int32_t pipe_read_close(int32_t fd);
+int32_t pipe_write_close(int32_t fd);
+int32_t pipe_read(int32_t fd, void* buf, int32_t nbytes);
+int32_t pipe_write(int32_t fd, const void* buf, int32_t nbytes);
+int32_t pipe_poll(int32_t fd);
+
+extern operation_table_t pipe_read_operation_table;
+extern operation_table_t pipe_write_operation_table;
+
+#endif /* _PIPE_H */
@@ -0,0 +1,57 @@
+/* poll.c - Waiting on several fds at once through the poll operation of each file type
+ * vim:ts=4 noexpandtab
+ */
+
+#include "poll.h"
+#include "fdtable.h"
+#include "devices/pit.h"
+
+/* poll_scan
+ *
+ * fill the revents of every entry once
+ * Inputs: fds - the entries
+ *         nfds - the number of entries
+ * Outputs: the number of entries with revents set
+ * Side Effects: None
+ */
+static int32_t poll_scan(pollfd_t* fds, uint32_t nfds){
+    uint32_t i;
+    int32_t ready = 0;
+    file_descriptor_t* file;
+    for(i = 0; i < nfds; i++){
+        fds[i].revents = 0;
+        if(fds[i].fd < 0) continue;
+        file = fd_get(fds[i].fd);
+        if(file == NULL){
+            fds[i].revents = POLLNVAL;
+        } else if(file->operation_table->poll_operation == NULL){
+            fds[i].revents = fds[i].events & (POLLIN | POLLOUT);
+        } else {
+            fds[i].revents = fds[i].events & file->operation_table->poll_operation(fds[i].fd);
+        }
+        if(fds[i].revents != 0) ready++;
+    }
+    return ready;
+}
+
+/* poll_wait
+ *
+ * wait until one of the fds is ready for what is asked of it, interrupts stay on
+ * so the processes of the other terminals and the devices carry on meanwhile
+ * Inputs: fds - the entries
+ *         nfds - the number of entries, at most MAX_FILES
+ *         timeout - ms to wait at most, 0 to only check, negative to wait forever
+ * Outputs: the number of ready entries, 0 on timeout, -1 if the arguments are invalid
+ * Side Effects: None
+ */
+int32_t poll_wait(pollfd_t* fds, uint32_t nfds, int32_t timeout){
+    uint32_t deadline;
+    int32_t ready;
+    if(fds == NULL || nfds > MAX_FILES) return -1;
+    deadline = pit_ticks + ((uint32_t)timeout + POLL_MS_PER_TICK - 1) / POLL_MS_PER_TICK;
+    while(1){
+        ready = poll_scan(fds, nfds);
+        if(ready != 0 || timeout == 0) return ready;
+        if(timeout > 0 && (int32_t)(pit_ticks - deadline) >= 0) return 0;
+    }
+}
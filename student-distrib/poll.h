@@ -0,0 +1,24 @@
+/* poll.h - Defines waiting on several fds at once
+ * vim:ts=4 noexpandtab
+ */
+
+#ifndef _POLL_H
+#define _POLL_H
+
+#include "types.h"
+
+#define POLLIN 0x0001               // a read would not wait
+#define POLLOUT 0x0004              // a write would not wait
+#define POLLNVAL 0x0020             // the fd is not open, reported whatever was asked
+#define POLL_MS_PER_TICK 10         // the PIT runs at 100 Hz
+
+typedef struct pollfd {
+    int32_t fd;                     // ignored if negative
+    int16_t events;                 // what the caller waits for
+    int16_t revents;                // what is ready, filled by poll
+} pollfd_t;
+
+/* wait until an fd is ready or timeout ms pass, forever if timeout is negative */
+int32_t poll_wait(pollfd_t* fds, uint32_t nfds, int32_t timeout);
+
+#endif /* _POLL_H */
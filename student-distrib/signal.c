@@ -7,6 +7,10 @@
 #include "devices/vt.h"
 #include "signal.h"
 #include "lib.h"
+#include "x86_desc.h"
+#include "paging.h"
+
+#define RPL_MASK 3                  // privilege level of a selector
 
 /* __signal_ignore - do nothing, ignore the signal
  * Inputs: None
@@ -31,6 +35,15 @@ void __signal_kill_task(void){
     return;
 }
 
+/* signal_default_handler - get the handler of the default action of a signal
+ * Inputs: signum - the signal number
+ * Outputs: None
+ * Return:  __signal_kill_task for DIV_ZERO, SEGFAULT and INTERRUPT, __signal_ignore for the others
+ */
+void* signal_default_handler(int32_t signum){
+    return (signum <= SIGNUM_INTERRUPT) ? (void*)__signal_kill_task : (void*)__signal_ignore;
+}
+
 /* send_signal - send the signal to the task when certain event occurs
  * Inputs: signum - the signal number of that type of signal
  * Outputs: None
@@ -43,7 +56,7 @@ void send_signal(int32_t signum){
     if(signum < 0 || signum > 4 || cur_pcb == NULL) return;
 
     cli();
-    cur_pcb->signals[signum].sa_activate = SIG_ACTIVATED;
+    cur_pcb->sig_pending |= SIG_BIT(signum);
     sti();
     return;
 }
@@ -54,76 +67,62 @@ void send_signal_by_pid(int32_t signum, int32_t pid){
     if(signum < 0 || signum > 4 || cur_pcb == NULL) return;
 
     cli();
-    cur_pcb->signals[signum].sa_activate = SIG_ACTIVATED;
+    cur_pcb->sig_pending |= SIG_BIT(signum);
     sti();
     return;
 }
 
 /* handle_signal - handle the signal, called everytime when returning to user space, should be called in return-to-user space linkage
+ *                 the linkage only calls it when sig_pending has a bit that sig_blocked does not
  * Inputs: None
  * Outputs: None
  * Return:  None
  */
 void handle_signal(void){
-    int32_t i, signum = -1;
+    int32_t signum;
     pcb_t* cur_pcb = get_current_pcb();
     void* signal_handler;
     uint32_t ebp0;
-    uint32_t user_esp;
     HW_Context_t* context;
-    uint32_t execute_sigreturn_size = EXECUTE_SIGRETURN_END - EXECUTE_SIGRETURN;
-    uint32_t ret_addr;
+    signal_frame_t* frame;
+    uint32_t pending, flags;
     asm ("movl %%ebp, %0" : "=r" (ebp0));
-    /* checking pending signals */
-    for(i = 0; i < SIG_NUM; i++){
-        if(cur_pcb->signals[i].sa_activate == SIG_ACTIVATED && cur_pcb->signals[i].sa_masked == SIG_UNMASK){
-            cur_pcb->signals[i].sa_activate = SIG_UNACTIVATED;
-            signum = i;
-            signal_handler = cur_pcb->signals[i].sa_handler;
-            break;
-        }
-    }
-    /* if no pending signals, return directly */
-    if(signum == -1) return;
+    context = (HW_Context_t*)(ebp0 + 8);
 
-    /* if exists pending signals, handle it by firstly mask all other signals */
-    for(i = 0; i < SIG_NUM; i++){
-        if(i != signum) cur_pcb->signals[i].sa_masked = SIG_MASK;
+    /* take the lowest pending signal that is not blocked */
+    cli_and_save(flags);
+    pending = cur_pcb->sig_pending & ~cur_pcb->sig_blocked;
+    if(pending == 0){
+        restore_flags(flags);
+        return;
     }
-
-    /* if handler is in kernel, directly call it and return */
-    if(signal_handler == __signal_ignore || signal_handler == __signal_kill_task){
-        ((void(*)())signal_handler)();
-        for(i = 0; i < SIG_NUM; i++){
-            cur_pcb->signals[i].sa_masked = SIG_UNMASK;
-        }
+    signum = bsf(pending);
+    signal_handler = cur_pcb->signals[signum].sa_handler;
+    /* a user handler waits for a return to user space, the only place its frame can go */
+    if(signal_handler != __signal_ignore && signal_handler != __signal_kill_task && (context->cs & RPL_MASK) != (USER_CS & RPL_MASK)){
+        restore_flags(flags);
         return;
     }
+    cur_pcb->sig_pending &= ~SIG_BIT(signum);
+    restore_flags(flags);
 
-    if (signum == SIGNUM_ALARM) {
+    /* if handler is in kernel, directly call it and return */
+    if(signal_handler == __signal_ignore || signal_handler == __signal_kill_task){
         ((void(*)())signal_handler)();
-        for(i = 0; i < SIG_NUM; i++){
-            cur_pcb->signals[i].sa_masked = SIG_UNMASK;
-        }
         return;
     }
 
-    /* then set up the signal handler's stack frame */
-    /* first push the execute sigreturn */
-    context = (HW_Context_t*)(ebp0 + 8);
-    user_esp = context->esp;
-    if(user_esp < _128_MB) return;
-    ret_addr = user_esp - execute_sigreturn_size;               // return to the execute sigreturn
-    memcpy((void*)(ret_addr), EXECUTE_SIGRETURN, execute_sigreturn_size);
-    /* then push the hardware context */
-    memcpy((void*)(ret_addr - sizeof(HW_Context_t)), context, sizeof(HW_Context_t));
-    /* then push the signal number and return address */
-    memcpy((void*)(ret_addr - sizeof(HW_Context_t) - 4), &signum, 4);
-    memcpy((void*)(ret_addr - sizeof(HW_Context_t) - 8), &ret_addr, 4);
+    /* set up the signal handler's stack frame, it returns into the shared trampoline */
+    frame = (signal_frame_t*)(context->esp - sizeof(signal_frame_t));
+    if((uint32_t)frame < _128_MB) return;
+    frame->ret_addr = SIGTRAMP_ADDR;
+    frame->signum = signum;
+    memcpy(&(frame->context), context, sizeof(HW_Context_t));
+    frame->blocked = cur_pcb->sig_blocked;
+    cur_pcb->sig_blocked |= cur_pcb->signals[signum].sa_mask | SIG_BIT(signum);
 
     /* update the hardware context for iret */
-    user_esp = ret_addr - sizeof(HW_Context_t) - 8;
-    context->esp = user_esp;
+    context->esp = (uint32_t)frame;
     context->ret_addr = (uint32_t)signal_handler;
 
     return;
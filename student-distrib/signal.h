@@ -29,16 +29,15 @@
 #define SIGNUM_INTERRUPT 2
 #define SIGNUM_ALARM 3
 #define SIGNUM_USER1 4
-#define SIG_ACTIVATED 1
-#define SIG_UNACTIVATED 0
-#define SIG_MASK 1
-#define SIG_UNMASK 0
+#define SIG_BIT(signum) (1 << (signum))    // bit of a signal in sig_pending and sig_blocked of the pcb
+#define SIG_ALL (SIG_BIT(SIG_NUM) - 1)
+#define SIG_DFL ((void*)0)                  // handlers given to sigaction for the default action
+#define SIG_IGN ((void*)1)                  // and for ignoring the signal
 
 /* define signal structure */
 typedef struct signal{
-    int32_t sa_activate;            // 0 as unactivated, 1 as activated
-    int32_t sa_masked;              // 0 as unmasked, 1 as masked
     void* sa_handler;
+    uint32_t sa_mask;               // SIG_BIT of the signals blocked while the handler runs, besides itself
 } signal_t;
 
 /* define Hardware context structure */
@@ -66,9 +65,18 @@ typedef struct HW_Context{
     uint16_t padding5;
 } HW_Context_t;
 
+/* pushed on the user stack below the interrupted one to call a user handler */
+typedef struct signal_frame{
+    uint32_t ret_addr;              // SIGTRAMP_ADDR, the handler returns into sigreturn
+    int32_t signum;                 // the argument of the handler
+    HW_Context_t context;           // restored by sigreturn
+    uint32_t blocked;               // sig_blocked before the handler, restored by sigreturn
+} signal_frame_t;
+
 /* functions used by signals system */
 void __signal_ignore(void);
 void __signal_kill_task(void);
+void* signal_default_handler(int32_t signum);
 void send_signal(int32_t signum);
 void send_signal_by_pid(int32_t signum, int32_t pid);
 void handle_signal(void);
@@ -4,6 +4,13 @@
 #include "x86_desc.h"
 #include "signal.h"
 #include "dynamic_alloc.h"
+#include "bcache.h"
+#include "fdtable.h"
+#include "tmpfs.h"
+#include "pipe.h"
+#include "uring.h"
+#include "trace.h"
+#include "irqstat.h"
 
 static void set_user_PDE(uint32_t pid)
 {
@@ -107,18 +114,33 @@ static int32_t parse_args(const uint8_t* command, uint8_t* filename, uint8_t* ar
 }
 
 
-static int32_t executable_check(const uint8_t* name)
+/**
+ * executable_check
+ * check that a file exists and is an ELF executable
+ *
+ * Inputs:
+ * - name: the file name
+ * - cur_dentry: filled with the file's dentry so the caller does not look it up again
+ *
+ * Output:
+ * - Returns 0 if the file is executable, INVALID_CMD otherwise
+ */
+static int32_t executable_check(const uint8_t* name, dentry_t* cur_dentry)
 {
-     // set a new dentry for the file
-    dentry_t cur_dentry;
-    
+    uint8_t root_name[FILE_NAME_LEN + 2];
+
     // find the dentry for the file according to its name
-    if (-1 == read_dentry_by_name(name, &cur_dentry)) {
-        return INVALID_CMD; // the filename is invalid
+    if (-1 == read_dentry_by_name(name, cur_dentry)) {
+        // programs are also found in the root from any working directory
+        root_name[0] = '/';
+        strncpy((int8_t*)root_name + 1, (const int8_t*)name, FILE_NAME_LEN + 1);
+        if (-1 == read_dentry_by_name(root_name, cur_dentry)) {
+            return INVALID_CMD; // the filename is invalid
+        }
     }
 
     uint8_t magic_num_buf[MAGIC_NUMBERS_NUM];
-    if (-1 == read_data(cur_dentry.inode_index, 0, magic_num_buf, MAGIC_NUMBERS_NUM)) {
+    if (-1 == read_data(cur_dentry->inode_index, 0, magic_num_buf, MAGIC_NUMBERS_NUM)) {
         return INVALID_CMD; // read data fail
     }
 
@@ -145,21 +167,15 @@ static pcb_t* create_pcb(uint32_t pid, pcb_t *parent_pcb)
     pcb->pid = pid;
     pcb->parent_pcb = parent_pcb;
 
-    /* Set up FDs */
-    // stdin
-    pcb->fd_array[0] = (file_descriptor_t) {
-        .operation_table = &stdin_operation_table,
-        .inode_index = 0,
-        .file_position = 0,
-        .flags = 1
-    };
-    // stdout
-    pcb->fd_array[1] = (file_descriptor_t) {
-        .operation_table = &stdout_operation_table,
-        .inode_index = 0,
-        .file_position = 0,
-        .flags = 1
-    };
+    /* Set up FDs, a program gets its parent's so the shell can hand it pipes */
+    if(pid >= NUM_TERMS){
+        fd_table_inherit(pcb, parent_pcb);
+        return pcb;
+    }
+    // the base shells start with stdin and stdout at fds 0 and 1
+    fd_table_init(pcb);
+    fd_alloc_pcb(pcb, &stdin_operation_table, 0);
+    fd_alloc_pcb(pcb, &stdout_operation_table, 0);
 
     return pcb;
 }
@@ -180,13 +196,14 @@ int32_t __syscall_execute(const uint8_t* command) {
 
     uint8_t filename[FILE_NAME_LEN + 1];  // store  the file name
     uint8_t args[ARG_LEN + 1];  // store args
+    dentry_t cur_dentry;
 
     if (parse_args(command, filename, args)) {  // return value should be 0 upon success
         return INVALID_CMD;
     }
 
     // Executable check
-    if (executable_check(filename)) {
+    if (executable_check(filename, &cur_dentry)) {
         return INVALID_CMD;
     }
 
@@ -200,8 +217,6 @@ int32_t __syscall_execute(const uint8_t* command) {
     set_user_PDE(pid);
 
     // User-level Program Loader
-    dentry_t cur_dentry;
-    read_dentry_by_name(filename, &cur_dentry);
     uint32_t program_entry_point;
     if (-1 == program_loader(cur_dentry.inode_index, &program_entry_point)) {
         return INVALID_CMD; // program loader fail
@@ -212,14 +227,15 @@ int32_t __syscall_execute(const uint8_t* command) {
     pcb_t* cur_pcb = create_pcb(pid, parent_pcb);
     /* Write arguments in pcb */
     memcpy(cur_pcb->args, args, ARG_LEN + 1);
+    // the base shells start in the root, everything else in its parent's directory
+    cur_pcb->cwd = (pid < NUM_TERMS) ? ROOT_DIR_INODE : parent_pcb->cwd;
     vt_set_active_pid(pid); // cp5, record the active process of a vt
+    trace_exec(pid);
 
     // initialize pcb's signal structure
     for(i = 0; i < SIG_NUM; i++){
-        if(i <= 2) cur_pcb->signals[i].sa_handler = __signal_kill_task;
-        else    cur_pcb->signals[i].sa_handler = __signal_ignore;
-        cur_pcb->signals[i].sa_activate = SIG_UNACTIVATED;
-        cur_pcb->signals[i].sa_masked = SIG_UNMASK;
+        cur_pcb->signals[i].sa_handler = signal_default_handler(i);
+        cur_pcb->signals[i].sa_mask = SIG_ALL;
     }
 
     // set TSS
@@ -259,8 +275,10 @@ int32_t __syscall_execute(const uint8_t* command) {
 int32_t __syscall_halt(uint8_t status) {
     // Restore parent data
     pcb_t* cur_pcb = get_current_pcb();
+    trace_halt(cur_pcb->pid);
     if (cur_pcb->pid < NUM_TERMS) {
         // If the current process is the first shell, then restart the shell
+        fd_table_release(cur_pcb);
         cli(); // prevent other processes from stealing the pid
         free_pid(cur_pcb->pid);
         __syscall_execute((uint8_t*)"shell"); // this call never returns anyway
@@ -273,12 +291,7 @@ int32_t __syscall_halt(uint8_t status) {
     vt_set_active_pid(parent_pcb->pid);
 
     // Close all FDs
-    int i;
-    for (i = 0; i < NUM_FILES; i++) {
-        if (cur_pcb->fd_array[i].flags == 0) continue;
-        cur_pcb->fd_array[i].flags = 0;
-        cur_pcb->fd_array[i].operation_table->close_operation(i);
-    }
+    fd_table_release(cur_pcb);
 
     // Write Parent process's info back to TSS
     tss.ss0 = KERNEL_DS;
@@ -314,6 +327,8 @@ int32_t __syscall_halt(uint8_t status) {
  */
 int32_t __syscall_open(const uint8_t* filename){
     dentry_t cur_dentry;
+    // paths under the tmpfs mount point never reach the image
+    if(tmpfs_path(filename)) return tmpfs_open(filename);
     // find the dentry for the file according to its name
     // if the file does not exist, open fails
     if(0 != read_dentry_by_name(filename, &cur_dentry)) return -1;
@@ -336,12 +351,11 @@ int32_t __syscall_open(const uint8_t* filename){
  * Side Effects: This call should never return to the caller
  */
 int32_t __syscall_close(int32_t fd){
-    // if fd out of boundary or fd is stdin or stdout, close fails
-    if(fd >= NUM_FILES || fd < 2)
+    file_descriptor_t* cur_fd = fd_get(fd);
+    // if fd is not open or fd is stdin or stdout, close fails
+    if(cur_fd == NULL || fd < 2)
         return -1;
-    pcb_t* cur_pcb = get_current_pcb();
-    if(cur_pcb->fd_array[fd].flags != IN_USE) return -1;
-    return cur_pcb->fd_array[fd].operation_table->close_operation(fd);
+    return cur_fd->operation_table->close_operation(fd);
 }
 
 /* __syscall_read - read the file
@@ -355,10 +369,11 @@ int32_t __syscall_close(int32_t fd){
  * Side Effects: This call should never return to the caller
  */
 int32_t __syscall_read(int32_t fd, void* buf, int32_t nbytes){
+    file_descriptor_t* cur_fd = fd_get(fd);
     /* input being checked in read operation */
-    if(fd < 0 || fd >= NUM_FILES || get_current_pcb()->fd_array[fd].flags == 0) return -1;
+    if(cur_fd == NULL) return -1;
     /* increment of file_position is handled in read_operation */
-    return get_current_pcb()->fd_array[fd].operation_table->read_operation(fd, buf, nbytes);
+    return cur_fd->operation_table->read_operation(fd, buf, nbytes);
 }
 
 /* __syscall_read - write the file
@@ -372,12 +387,277 @@ int32_t __syscall_read(int32_t fd, void* buf, int32_t nbytes){
  * Side Effects: This call should never return to the caller
  */
 int32_t __syscall_write(int32_t fd, const void* buf, int32_t nbytes){
-    pcb_t* cur_pcb = get_current_pcb();
-    /* if fd out of boundary or buf or nbytes is incalid, read fails */
-    if(fd < 0 || fd >= NUM_FILES || cur_pcb->fd_array[fd].flags == 0) return -1;
+    file_descriptor_t* cur_fd = fd_get(fd);
+    /* if fd is not open, write fails, buf and nbytes are checked in write_operation */
+    if(cur_fd == NULL) return -1;
 
     /* increment of file_position is handled in write_operation */
-    return cur_pcb->fd_array[fd].operation_table->write_operation(fd, buf, nbytes);
+    return cur_fd->operation_table->write_operation(fd, buf, nbytes);
+}
+
+/* __syscall_readv - read the file into several buffers with one system call
+ * Inputs: fd - the file associated with file descriptor to be read
+           iov - array of buffers to fill in order
+           iovcnt - the number of buffers in iov
+ * Outputs: None
+ * Return:  total number of bytes read if successfully
+ *          0 if file reach the end
+ *          -1 if read fails
+ * Side Effects: stops at the first buffer that is not filled completely
+ */
+int32_t __syscall_readv(int32_t fd, const iovec_t* iov, int32_t iovcnt){
+    int32_t i;
+    int32_t ret;
+    int32_t bytes_read = 0;
+    file_descriptor_t* cur_fd = fd_get(fd);
+    if(cur_fd == NULL) return -1;
+    if(iov == NULL || iovcnt < 0 || iovcnt > MAX_IOV_NUM) return -1;
+
+    for(i = 0; i < iovcnt; i++){
+        if(iov[i].iov_len == 0) continue;
+        /* increment of file_position is handled in read_operation */
+        ret = cur_fd->operation_table->read_operation(fd, iov[i].iov_base, iov[i].iov_len);
+        if(ret == -1) return (bytes_read > 0) ? bytes_read : -1;
+        bytes_read += ret;
+        if(ret < iov[i].iov_len) break;     // short read, nothing more to fill
+    }
+    return bytes_read;
+}
+
+/* __syscall_truncate - set the length of an opened regular file
+ * Inputs: fd - the file associated with file descriptor to be resized
+           length - the new length of the file
+ * Outputs: None
+ * Return:  0 if successfully, -1 if fails
+ * Side Effects: blocks past the new end are released, the file_position is not changed
+ */
+int32_t __syscall_truncate(int32_t fd, uint32_t length){
+    file_descriptor_t* cur_fd = fd_get(fd);
+    if(tmpfs_owns(fd)) return tmpfs_truncate(fd, length);
+    /* only regular files have data blocks */
+    if(cur_fd == NULL || cur_fd->operation_table != &file_operation_table) return -1;
+    return truncate_data(cur_fd->inode_index, length);
+}
+
+/* __syscall_create - create an empty regular file
+ * Inputs: filename - the name of the new file
+ * Outputs: None
+ * Return:  0 if successfully, -1 if the name is invalid or taken, or the file system is full
+ * Side Effects: None
+ */
+int32_t __syscall_create(const uint8_t* filename){
+    if(tmpfs_path(filename)) return tmpfs_create(filename);
+    return file_create(filename);
+}
+
+/* __syscall_unlink - remove a regular file
+ * Inputs: filename - the name of the file to be removed
+ * Outputs: None
+ * Return:  0 if successfully, -1 if there is no such file or it is still open
+ * Side Effects: the data blocks of the file are released
+ */
+int32_t __syscall_unlink(const uint8_t* filename){
+    if(tmpfs_path(filename)) return tmpfs_unlink(filename);
+    return file_unlink(filename);
+}
+
+/* __syscall_mkdir - create an empty directory
+ * Inputs: path - the path of the new directory
+ * Outputs: None
+ * Return:  0 if successfully, -1 if the path is invalid or taken, or the file system is full
+ * Side Effects: None
+ */
+int32_t __syscall_mkdir(const uint8_t* path){
+    return dir_mkdir(path);
+}
+
+/* __syscall_chdir - change the working directory of the current process
+ * Inputs: path - the path of the directory
+ * Outputs: None
+ * Return:  0 if successfully, -1 if there is no such directory
+ * Side Effects: relative paths and programs started later use the new directory
+ */
+int32_t __syscall_chdir(const uint8_t* path){
+    return dir_chdir(path);
+}
+
+/* __syscall_sync - write every modified block of the buffer cache back
+ * Inputs: None
+ * Outputs: None
+ * Return:  0 if successfully, -1 if some block could not be written
+ * Side Effects: waits for the device
+ */
+int32_t __syscall_sync(void){
+    return bsync();
+}
+
+/* __syscall_getdents - list an opened directory with one system call
+ * Inputs: fd - the file descriptor of the directory
+ *         buf - records of name, type, inode and length to fill
+ *         nbytes - the size of buf in bytes
+ * Outputs: None
+ * Return:  number of bytes filled, a multiple of the record size
+ *          0 if the directory reach the end
+ *          -1 if fd is not a directory or buf holds no record
+ * Side Effects: advance the position of the directory
+ */
+int32_t __syscall_getdents(int32_t fd, dirent_t* buf, int32_t nbytes){
+    if(tmpfs_owns(fd)) return tmpfs_getdents(fd, buf, nbytes);
+    return dir_getdents(fd, buf, nbytes);
+}
+
+/* __syscall_lseek - move the position of an opened file or directory
+ * Inputs: fd - the file descriptor
+ *         offset - the signed distance to move
+ *         whence - SEEK_SET, SEEK_CUR or SEEK_END
+ * Outputs: None
+ * Return:  the new position, -1 if fails
+ * Side Effects: change the file_position
+ */
+int32_t __syscall_lseek(int32_t fd, int32_t offset, int32_t whence){
+    if(tmpfs_owns(fd)) return tmpfs_lseek(fd, offset, whence);
+    return file_lseek(fd, offset, whence);
+}
+
+/* __syscall_pread - read an opened file at a given offset
+ * Inputs: fd - the file descriptor
+ *         buf - the buffer to fill
+ *         nbytes - the number of bytes to read
+ *         offset - the position in the file, passed in esi
+ * Outputs: None
+ * Return:  number of bytes read, 0 at the end, -1 if fails
+ * Side Effects: the file_position is not changed
+ */
+int32_t __syscall_pread(int32_t fd, void* buf, int32_t nbytes, uint32_t offset){
+    if(tmpfs_owns(fd)) return tmpfs_pread(fd, buf, nbytes, offset);
+    return file_pread(fd, buf, nbytes, offset);
+}
+
+/* __syscall_pwrite - write an opened file at a given offset
+ * Inputs: fd - the file descriptor
+ *         buf - the buffer holding the content
+ *         nbytes - the number of bytes to write
+ *         offset - the position in the file, passed in esi
+ * Outputs: None
+ * Return:  number of bytes written, -1 if fails
+ * Side Effects: the file_position is not changed
+ */
+int32_t __syscall_pwrite(int32_t fd, const void* buf, int32_t nbytes, uint32_t offset){
+    if(tmpfs_owns(fd)) return tmpfs_pwrite(fd, buf, nbytes, offset);
+    return file_pwrite(fd, buf, nbytes, offset);
+}
+
+/* __syscall_fstat - get the type, inode and length of an opened file
+ * Inputs: fd - the file descriptor
+ *         st - filled with the information
+ * Outputs: None
+ * Return:  0 if successfully, -1 if fails
+ * Side Effects: None
+ */
+int32_t __syscall_fstat(int32_t fd, stat_t* st){
+    if(tmpfs_owns(fd)) return tmpfs_fstat(fd, st);
+    if(pipe_owns(fd)) return pipe_fstat(fd, st);
+    return file_fstat(fd, st);
+}
+
+/* __syscall_stat - get the type, inode and length of the file at a path
+ * Inputs: filename - the path of the file
+ *         st - filled with the information
+ * Outputs: None
+ * Return:  0 if successfully, -1 if there is no such file
+ * Side Effects: None
+ */
+int32_t __syscall_stat(const uint8_t* filename, stat_t* st){
+    if(tmpfs_path(filename)) return tmpfs_stat(filename, st);
+    return file_stat(filename, st);
+}
+
+/* __syscall_dup - make the lowest free fd share an open file
+ * Inputs: fd - the fd to copy
+ * Outputs: None
+ * Return:  the new fd, -1 if fd is not open or every fd is in use
+ * Side Effects: both fds share one file position
+ */
+int32_t __syscall_dup(int32_t fd){
+    return fd_dup(fd);
+}
+
+/* __syscall_dup2 - make newfd share the open file of oldfd
+ * Inputs: oldfd - the fd to copy
+ *         newfd - the fd to set, closed first if it is open
+ * Outputs: None
+ * Return:  newfd, -1 if oldfd is not open or newfd is out of range
+ * Side Effects: both fds share one file position
+ */
+int32_t __syscall_dup2(int32_t oldfd, int32_t newfd){
+    return fd_dup2(oldfd, newfd);
+}
+
+/* __syscall_pipe - make a pipe
+ * Inputs: fds - filled with the read end and the write end
+ * Outputs: None
+ * Return:  0 if successfully, -1 if fails
+ * Side Effects: programs started afterwards inherit both ends
+ */
+int32_t __syscall_pipe(int32_t* fds){
+    return pipe_create(fds);
+}
+
+/* __syscall_uring_setup - register the submission and completion rings of the process
+ * Inputs: ring - the rings, in user memory
+ * Outputs: None
+ * Return:  0 if successfully, -1 if ring is outside the user page
+ * Side Effects: the rings are emptied
+ */
+int32_t __syscall_uring_setup(uring_t* ring){
+    return uring_setup(ring);
+}
+
+/* __syscall_uring_enter - run the queued entries of the registered rings
+ * Inputs: to_submit - the most entries to run, 0 for all of them
+ * Outputs: None
+ * Return:  the number of entries run, -1 if no ring is registered
+ * Side Effects: a completion is posted for every entry run
+ */
+int32_t __syscall_uring_enter(uint32_t to_submit){
+    return uring_enter(to_submit);
+}
+
+/* __syscall_poll - wait until one of several fds can be read or written without waiting
+ * Inputs: fds - the fds with the events wanted, revents is filled
+ *         nfds - the number of entries
+ *         timeout - ms to wait at most, 0 to only check, negative to wait forever
+ * Outputs: None
+ * Return:  the number of ready entries, 0 on timeout, -1 if the arguments are invalid
+ * Side Effects: None
+ */
+int32_t __syscall_poll(pollfd_t* fds, uint32_t nfds, int32_t timeout){
+    return poll_wait(fds, nfds, timeout);
+}
+
+/* __syscall_trace - trace the system calls of the programs started afterwards, or read out the trace
+ * Inputs: cmd - TRACE_OFF, TRACE_ON, TRACE_READ or TRACE_HIST
+ *         buf - filled with the calls of the last traced program that halted by TRACE_READ,
+ *               with the log2 histograms of cycles per call number by TRACE_HIST
+ *         nbytes - the size of buf
+ * Outputs: None
+ * Return:  the bytes copied, 0 for TRACE_OFF and TRACE_ON, -1 if fails
+ * Side Effects: TRACE_ON starts the histograms over
+ */
+int32_t __syscall_trace(int32_t cmd, void* buf, int32_t nbytes){
+    return trace_ctl(cmd, buf, nbytes);
+}
+
+/* __syscall_irqstat - time the handlers of each vector, or read their counts and durations
+ * Inputs: cmd - IRQSTAT_OFF, IRQSTAT_ON or IRQSTAT_READ
+ *         buf - filled with one entry per vector up to the PIC vectors by IRQSTAT_READ
+ *         nbytes - the size of buf
+ * Outputs: None
+ * Return:  the bytes copied, 0 for IRQSTAT_OFF and IRQSTAT_ON, -1 if fails
+ * Side Effects: IRQSTAT_ON starts the counts over
+ */
+int32_t __syscall_irqstat(int32_t cmd, void* buf, int32_t nbytes){
+    return irqstat_ctl(cmd, buf, nbytes);
 }
 
 int32_t __syscall_getargs(uint8_t* buf, int32_t nbytes){
@@ -426,6 +706,44 @@ int32_t __syscall_set_handler(int32_t signum, void* handler_address){
 
     /* changes the default action taken for the current pcb with input signum signal */
     cur_pcb->signals[signum].sa_handler = handler_address;
+    cur_pcb->signals[signum].sa_mask = SIG_ALL;
+    return 0;
+}
+
+/* __syscall_sigaction - set the action of a signal and the signals blocked while its handler runs
+ * Inputs: signum - the signal
+ *         handler - SIG_DFL, SIG_IGN or a user-level function taking the signal number
+ *         mask - SIG_BIT of the signals blocked while the handler runs, the signal itself always is
+ * Outputs: None
+ * Return:  0 if the action is set, -1 if signum or handler is invalid
+ * Side Effects: None
+ */
+int32_t __syscall_sigaction(int32_t signum, void* handler, uint32_t mask){
+    pcb_t* cur_pcb = get_current_pcb();
+    if(signum < 0 || signum >= SIG_NUM) return -1;
+    if(handler == SIG_DFL){
+        handler = signal_default_handler(signum);
+    } else if(handler == SIG_IGN){
+        handler = __signal_ignore;
+    } else if((uint32_t)handler < _128_MB || (uint32_t)handler >= _128_MB + FOUR_MB){
+        return -1;
+    }
+    cur_pcb->signals[signum].sa_handler = handler;
+    cur_pcb->signals[signum].sa_mask = mask & SIG_ALL;
+    return 0;
+}
+
+/* __syscall_kill - send a signal to a process
+ * Inputs: pid - the process
+ *         signum - the signal
+ * Outputs: None
+ * Return:  0 if the signal is sent, -1 if there is no such process or signal
+ * Side Effects: the process handles it on its next return from an interrupt or a system call
+ */
+int32_t __syscall_kill(int32_t pid, int32_t signum){
+    if(pid < 0 || pid >= MAX_PID_NUM || !check_pid_occupied(pid)) return -1;
+    if(signum < 0 || signum >= SIG_NUM) return -1;
+    send_signal_by_pid(signum, pid);
     return 0;
 }
 
@@ -436,19 +754,15 @@ int32_t __syscall_set_handler(int32_t signum, void* handler_address){
  */
 int32_t __syscall_sigreturn(void){
     pcb_t* cur_pcb = get_current_pcb();
-    int32_t i;
     uint32_t ebp0;
     asm ("movl %%ebp, %0" : "=r" (ebp0));
     
-    /* copy the handware context */
-    HW_Context_t* newcontext = (HW_Context_t*)(ebp0 + 8);                      // OFFSET extremely uncertain!!! Need Fixed
-    uint32_t user_esp = newcontext->esp;
-    HW_Context_t* oldcontext = (HW_Context_t*)(user_esp + 4);                   // OFFSET extremely uncertain!!! Need Fixed
-    memcpy(newcontext, oldcontext, sizeof(HW_Context_t));
-    /* unmask all signals */
-    for(i = 0; i < SIG_NUM; i++){
-        cur_pcb->signals[i].sa_masked = SIG_UNMASK;
-    }
+    /* copy the handware context, the handler returned off ret_addr of its frame */
+    HW_Context_t* newcontext = (HW_Context_t*)(ebp0 + 8);
+    signal_frame_t* frame = (signal_frame_t*)(newcontext->esp - sizeof(uint32_t));
+    memcpy(newcontext, &(frame->context), sizeof(HW_Context_t));
+    /* unblock what the handler blocked */
+    cur_pcb->sig_blocked = frame->blocked & SIG_ALL;
     return newcontext->eax;
 }
 
@@ -6,6 +6,7 @@
 #include "devices/rtc.h"
 #include "devices/vt.h"
 #include "date.h"
+#include "poll.h"
 
 #define FILE_NAME_LEN 32  // 32B to store file name in FS
 #define MAX_ARG_NUM 24
@@ -18,6 +19,14 @@
 #define MAGIC_NUM_3 0x4c
 #define MAGIC_NUM_4 0x46
 
+// Vectored read
+#define MAX_IOV_NUM 16    // max number of buffers filled by one readv
+
+typedef struct iovec {
+    void* iov_base;
+    int32_t iov_len;
+} iovec_t;
+
 int32_t __syscall_execute(const uint8_t* command);
 int32_t __syscall_halt(uint8_t status);
 
@@ -25,11 +34,34 @@ int32_t __syscall_open(const uint8_t* filename);
 int32_t __syscall_close(int32_t fd);
 int32_t __syscall_read(int32_t fd, void* buf, int32_t nbytes);
 int32_t __syscall_write(int32_t fd, const void* buf, int32_t nbytes);
+int32_t __syscall_readv(int32_t fd, const iovec_t* iov, int32_t iovcnt);
+int32_t __syscall_truncate(int32_t fd, uint32_t length);
+int32_t __syscall_create(const uint8_t* filename);
+int32_t __syscall_unlink(const uint8_t* filename);
+int32_t __syscall_mkdir(const uint8_t* path);
+int32_t __syscall_chdir(const uint8_t* path);
+int32_t __syscall_sync(void);
+int32_t __syscall_getdents(int32_t fd, dirent_t* buf, int32_t nbytes);
+int32_t __syscall_lseek(int32_t fd, int32_t offset, int32_t whence);
+int32_t __syscall_pread(int32_t fd, void* buf, int32_t nbytes, uint32_t offset);
+int32_t __syscall_pwrite(int32_t fd, const void* buf, int32_t nbytes, uint32_t offset);
+int32_t __syscall_fstat(int32_t fd, stat_t* st);
+int32_t __syscall_stat(const uint8_t* filename, stat_t* st);
+int32_t __syscall_dup(int32_t fd);
+int32_t __syscall_dup2(int32_t oldfd, int32_t newfd);
+int32_t __syscall_pipe(int32_t* fds);
+int32_t __syscall_uring_setup(uring_t* ring);
+int32_t __syscall_uring_enter(uint32_t to_submit);
+int32_t __syscall_poll(pollfd_t* fds, uint32_t nfds, int32_t timeout);
+int32_t __syscall_trace(int32_t cmd, void* buf, int32_t nbytes);
+int32_t __syscall_irqstat(int32_t cmd, void* buf, int32_t nbytes);
 
 int32_t __syscall_getargs(uint8_t* buf, int32_t nbytes);
 int32_t __syscall_vidmap(uint8_t** screen_start);
 int32_t __syscall_set_handler(int32_t signum, void* handler_address);
 int32_t __syscall_sigreturn(void);
+int32_t __syscall_sigaction(int32_t signum, void* handler, uint32_t mask);
+int32_t __syscall_kill(int32_t pid, int32_t signum);
 int32_t __syscall_ioctl(int32_t fd, int32_t flag);
 int32_t __syscall_ps(void);
 int32_t __syscall_date(void);
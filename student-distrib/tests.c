@@ -2,13 +2,30 @@
 #include "x86_desc.h"
 #include "lib.h"
 #include "devices/rtc.h"
+#include "devices/ide.h"
 #include "filesys.h"
+#include "bcache.h"
+#include "fdtable.h"
+#include "tmpfs.h"
+#include "kpage.h"
+#include "pipe.h"
+#include "uring.h"
+#include "poll.h"
+#include "devices/pit.h"
+#include "idt.h"
+#include "vdso.h"
+#include "trace.h"
+#include "irqstat.h"
+#include "signal.h"
 #include "pcb.h"
 #include "syscall_task.h"
 
 #define PASS 1
 #define FAIL 0
 
+#define BENCH_BUF_SIZE 0x10000	// 64 kB per read_data call in benchmarks
+#define BENCH_PASSES 16
+
 /* global variable for tests */
 uint8_t buf1[4096] = {'f', 'i', 'l', 'e', ' ', 'r', 'e', 'a', 'c', 'h', ' ', 't', 'h', 'e', ' ', 'e', 'n', 'd', '\n', 0};
 uint8_t buf2[4096] = {'f', 'i', 'l', 'e', ' ', 'r', 'e', 'a', 'c', 'h', ' ', 't', 'h', 'e', ' ', 'e', 'n', 'd', '\n', 0};
@@ -16,6 +33,7 @@ uint8_t buf3[4096] = {'f', 'i', 'l', 'e', ' ', 'r', 'e', 'a', 'c', 'h', ' ', 't'
 uint8_t buf4[4096] = {'f', 'i', 'l', 'e', ' ', 'r', 'e', 'a', 'c', 'h', ' ', 't', 'h', 'e', ' ', 'e', 'n', 'd', '\n', 0};
 uint8_t buf5[4096] = {'f', 'i', 'l', 'e', ' ', 'r', 'e', 'a', 'c', 'h', ' ', 't', 'h', 'e', ' ', 'e', 'n', 'd', '\n', 0};
 uint8_t buf6[4096] = {'f', 'i', 'l', 'e', ' ', 'r', 'e', 'a', 'c', 'h', ' ', 't', 'h', 'e', ' ', 'e', 'n', 'd', '\n', 0};
+uint8_t bench_buf[BENCH_BUF_SIZE];
 
 /* format these macros as you see fit */
 #define TEST_HEADER 	\
@@ -612,12 +630,1048 @@ int syscall_edge_test(){
 	return PASS;
 }
 
+int readv_syscall_test(){
+	TEST_HEADER;
+
+	int32_t fd;
+	int32_t i;
+	int32_t ret;
+	dentry_t dentry;
+	iovec_t iov[3];
+
+	if(read_dentry_by_name((const uint8_t*)"frame0.txt", &dentry) == -1) return FAIL;
+	fd = __syscall_open((const uint8_t*)"frame0.txt");
+	if(fd == -1) return FAIL;
+
+	/* scatter the first 2068 bytes over two buffers, skipping an empty one */
+	iov[0].iov_base = buf1;
+	iov[0].iov_len = 20;
+	iov[1].iov_base = buf2;
+	iov[1].iov_len = 0;
+	iov[2].iov_base = buf3;
+	iov[2].iov_len = 2048;
+	ret = read_data(dentry.inode_index, 0, buf4, 20 + 2048);
+	if(__syscall_readv(fd, iov, 3) != ret) return FAIL;
+	for(i = 0; i < ret; i++){
+		if(((i < 20) ? buf1[i] : buf3[i - 20]) != buf4[i]) return FAIL;
+	}
+	if(__syscall_readv(fd, NULL, 1) != -1) return FAIL;
+	if(__syscall_close(fd) == -1) return FAIL;
+	return PASS;
+}
+
+/* write_data_test
+ *
+ * Rewrite created.txt with three blocks of data and check that it reads back
+ * and that the blocks it got were not taken from another file
+ * Inputs: None
+ * Outputs: PASS or FAIL
+ * Side Effects: overwrite created.txt
+ */
+int write_data_test(){
+	TEST_HEADER;
+
+	dentry_t scratch, other;
+	int32_t i, ret;
+	int32_t length = 3 * BLOCK_SIZE;
+
+	if(read_dentry_by_name((const uint8_t*)"created.txt", &scratch) == -1) return FAIL;
+	if(read_dentry_by_name((const uint8_t*)"hello", &other) == -1) return FAIL;
+	ret = read_data(other.inode_index, 0, buf1, BLOCK_SIZE);
+	if(ret <= 0) return FAIL;
+
+	for(i = 0; i < length; i++){
+		bench_buf[i] = (uint8_t)(i * 7);
+	}
+	if(write_data(scratch.inode_index, 0, bench_buf, length) != length) return FAIL;
+	memset(bench_buf, 0, length);
+	if(read_data(scratch.inode_index, 0, bench_buf, length) != length) return FAIL;
+	for(i = 0; i < length; i++){
+		if(bench_buf[i] != (uint8_t)(i * 7)) return FAIL;
+	}
+
+	/* the other file must be untouched */
+	if(read_data(other.inode_index, 0, buf2, BLOCK_SIZE) != ret) return FAIL;
+	for(i = 0; i < ret; i++){
+		if(buf1[i] != buf2[i]) return FAIL;
+	}
+	return PASS;
+}
+
+/* write_offset_test
+ *
+ * Overwrite the middle of created.txt across a block boundary, append past its end
+ * leaving a gap, then truncate it back, checking the content after each step
+ * Inputs: None
+ * Outputs: PASS or FAIL
+ * Side Effects: overwrite created.txt
+ */
+int write_offset_test(){
+	TEST_HEADER;
+
+	dentry_t scratch;
+	int32_t i;
+	int32_t length = 2 * BLOCK_SIZE;
+	uint8_t mark[] = "0123456789";
+
+	if(read_dentry_by_name((const uint8_t*)"created.txt", &scratch) == -1) return FAIL;
+	for(i = 0; i < length; i++){
+		bench_buf[i] = 'a';
+	}
+	if(truncate_data(scratch.inode_index, 0) == -1) return FAIL;
+	if(write_data(scratch.inode_index, 0, bench_buf, length) != length) return FAIL;
+
+	/* overwrite in place across the first block boundary */
+	if(write_data(scratch.inode_index, BLOCK_SIZE - 5, mark, 10) != 10) return FAIL;
+	if(read_data(scratch.inode_index, length, buf1, 1) != 0) return FAIL;
+	if(read_data(scratch.inode_index, BLOCK_SIZE - 6, buf1, 12) != 12) return FAIL;
+	if(buf1[0] != 'a' || buf1[11] != 'a' || strncmp((int8_t*)buf1 + 1, (int8_t*)mark, 10) != 0) return FAIL;
+
+	/* append one block after the end, the gap must read as zeros */
+	if(write_data(scratch.inode_index, length + BLOCK_SIZE, mark, 10) != 10) return FAIL;
+	if(read_data(scratch.inode_index, length + BLOCK_SIZE + 10, buf1, 1) != 0) return FAIL;
+	if(read_data(scratch.inode_index, length, bench_buf, BLOCK_SIZE + 10) != BLOCK_SIZE + 10) return FAIL;
+	for(i = 0; i < BLOCK_SIZE; i++){
+		if(bench_buf[i] != 0) return FAIL;
+	}
+	if(strncmp((int8_t*)bench_buf + BLOCK_SIZE, (int8_t*)mark, 10) != 0) return FAIL;
+
+	/* shrink and grow again, the old tail must not come back */
+	if(truncate_data(scratch.inode_index, BLOCK_SIZE) == -1) return FAIL;
+	if(read_data(scratch.inode_index, BLOCK_SIZE, buf1, 1) != 0) return FAIL;
+	if(truncate_data(scratch.inode_index, BLOCK_SIZE + 10) == -1) return FAIL;
+	if(read_data(scratch.inode_index, BLOCK_SIZE, buf1, 10) != 10) return FAIL;
+	for(i = 0; i < 10; i++){
+		if(buf1[i] != 0) return FAIL;
+	}
+	return PASS;
+}
+
+/* file_create_unlink_test
+ *
+ * Create a file, write it, remove it and check that its name, inode and
+ * data blocks are given back
+ * Inputs: None
+ * Outputs: PASS or FAIL
+ * Side Effects: None if it passes
+ */
+int file_create_unlink_test(){
+	TEST_HEADER;
+
+	dentry_t dentry, again;
+	uint8_t name[] = "scratch.log";
+
+	if(read_dentry_by_name(name, &dentry) != -1) return FAIL;
+	if(file_create(name) == -1) return FAIL;
+	if(file_create(name) != -1) return FAIL;		// the name is taken now
+	if(read_dentry_by_name(name, &dentry) == -1) return FAIL;
+	if(dentry.file_type != REGULAR_FILE_TYPE) return FAIL;
+	if(read_data(dentry.inode_index, 0, buf1, 1) != 0) return FAIL;
+
+	if(write_data(dentry.inode_index, 0, name, sizeof(name)) != sizeof(name)) return FAIL;
+	if(file_unlink(name) == -1) return FAIL;
+	if(read_dentry_by_name(name, &again) != -1) return FAIL;
+	if(file_unlink(name) != -1) return FAIL;
+	if(file_unlink((const uint8_t*)".") != -1) return FAIL;	// only regular files
+
+	/* the freed inode is handed out again, and starts empty */
+	if(file_create(name) == -1) return FAIL;
+	if(read_dentry_by_name(name, &again) == -1) return FAIL;
+	if(again.inode_index != dentry.inode_index) return FAIL;
+	if(read_data(again.inode_index, 0, buf1, 1) != 0) return FAIL;
+	if(file_unlink(name) == -1) return FAIL;
+	return PASS;
+}
+
+/* inline_file_check
+ *
+ * Grow a file inside its inode, with a hole that must read as zeros, then past
+ * INLINE_MAX_SIZE so it moves to a data block, and check the content survives each step
+ * Inputs: inode - an empty file
+ *         name - the bytes written
+ *         len - the number of bytes written
+ * Outputs: PASS or FAIL
+ * Side Effects: change the file
+ */
+static int inline_file_check(uint32_t inode, const uint8_t* name, uint32_t len){
+	uint8_t data = 0;
+
+	if(write_data(inode, 0, name, len) != len || write_data(inode, 100, name, len) != len) return FAIL;
+	if(read_data(inode, 0, buf1, 200) != 100 + len) return FAIL;
+	if(strncmp((int8_t*)buf1, (int8_t*)name, len) != 0 || buf1[99] != 0 ||
+	   strncmp((int8_t*)&buf1[100], (int8_t*)name, len) != 0) return FAIL;
+
+	/* the last byte that fits inline, then more */
+	if(write_data(inode, INLINE_MAX_SIZE - 1, name, 1) != 1) return FAIL;
+	if(read_data(inode, INLINE_MAX_SIZE - 2, buf1, 2) != 2 || buf1[0] != 0 || buf1[1] != name[0]) return FAIL;
+	if(write_data(inode, INLINE_MAX_SIZE, name, len) != len) return FAIL;
+	if(read_data(inode, 0, bench_buf, BLOCK_SIZE) != INLINE_MAX_SIZE + len) return FAIL;
+	if(strncmp((int8_t*)bench_buf, (int8_t*)name, len) != 0 || bench_buf[INLINE_MAX_SIZE - 1] != name[0] ||
+	   strncmp((int8_t*)&bench_buf[INLINE_MAX_SIZE], (int8_t*)name, len) != 0) return FAIL;
+
+	if(truncate_data(inode, 0) == -1 || read_data(inode, 0, &data, 1) != 0) return FAIL;
+	return PASS;
+}
+
+/* inline_file_test
+ *
+ * Run inline_file_check on a new file, which starts out held by its inode
+ * Inputs: None
+ * Outputs: PASS or FAIL
+ * Side Effects: None if it passes
+ */
+int inline_file_test(){
+	TEST_HEADER;
+
+	dentry_t dentry;
+	uint8_t name[] = "inline.tmp";
+	int result = FAIL;
+
+	if(file_create(name) == -1) return FAIL;
+	if(read_dentry_by_name(name, &dentry) != -1) result = inline_file_check(dentry.inode_index, name, sizeof(name));
+	if(file_unlink(name) == -1) result = FAIL;
+	return result;
+}
+
+/* directory_tree_test
+ *
+ * Make a directory with a file and a subdirectory in it, look them up through
+ * absolute paths with "." and "..", then remove everything again
+ * Inputs: None
+ * Outputs: PASS or FAIL
+ * Side Effects: None if it passes
+ */
+int directory_tree_test(){
+	TEST_HEADER;
+
+	dentry_t dentry, sub;
+
+	if(dir_mkdir((const uint8_t*)"/logs") == -1) return FAIL;
+	if(dir_mkdir((const uint8_t*)"/logs") != -1) return FAIL;
+	if(dir_mkdir((const uint8_t*)"/logs/old") == -1) return FAIL;
+	if(file_create((const uint8_t*)"/logs/old/run.txt") == -1) return FAIL;
+	if(file_create((const uint8_t*)"/nowhere/run.txt") != -1) return FAIL;	// parent must exist
+	if(file_create((const uint8_t*)"/hello/run.txt") != -1) return FAIL;	// parent must be a directory
+
+	if(read_dentry_by_name((const uint8_t*)"/logs/old", &sub) == -1) return FAIL;
+	if(sub.file_type != DIR_FILE_TYPE || sub.inode_index == ROOT_DIR_INODE) return FAIL;
+	if(read_dentry_by_name((const uint8_t*)"//logs/./old/", &dentry) == -1) return FAIL;
+	if(dentry.inode_index != sub.inode_index) return FAIL;
+	if(read_dentry_by_name((const uint8_t*)"/logs/old/run.txt", &dentry) == -1) return FAIL;
+	if(dentry.file_type != REGULAR_FILE_TYPE) return FAIL;
+	if(read_dentry_by_name((const uint8_t*)"/logs/old/../../hello", &dentry) == -1) return FAIL;
+	if(read_dentry_by_name((const uint8_t*)"/../logs/old/./run.txt", &dentry) == -1) return FAIL;
+	if(read_dentry_by_name((const uint8_t*)"/logs/run.txt", &dentry) != -1) return FAIL;
+	if(read_dentry_by_name((const uint8_t*)"/logs/old/run.txt/x", &dentry) != -1) return FAIL;
+
+	/* a directory goes only when it is empty */
+	if(file_unlink((const uint8_t*)"/logs/old") != -1) return FAIL;
+	if(file_unlink((const uint8_t*)"/logs/old/run.txt") == -1) return FAIL;
+	if(file_unlink((const uint8_t*)"/logs/old") == -1) return FAIL;
+	if(file_unlink((const uint8_t*)"/logs") == -1) return FAIL;
+	if(read_dentry_by_name((const uint8_t*)"/logs", &dentry) != -1) return FAIL;
+	return PASS;
+}
+
+/* ide_rw_test
+ *
+ * Write sectors to the slave drive with two requests queued back to back so they
+ * are merged into one command, read them back and restore the old content
+ * Inputs: None
+ * Outputs: PASS or FAIL, PASS if there is no slave drive
+ * Side Effects: None if it passes
+ */
+int ide_rw_test(){
+	TEST_HEADER;
+
+	ide_request_t first, second;
+	int32_t i;
+	int32_t count = 8;
+	int32_t bytes = count * IDE_SECTOR_SIZE;
+	uint8_t* saved = bench_buf + 2 * bytes;
+
+	/* the master is the boot disk, only the slave is scratch */
+	if(ide_sectors(1) == 0) return PASS;
+	if(ide_read(1, 0, saved, 2 * count) == -1) return FAIL;
+
+	for(i = 0; i < 2 * bytes; i++){
+		bench_buf[i] = (uint8_t)(i * 13);
+	}
+	first = (ide_request_t){ .drive = 1, .lba = 0, .count = count, .buf = bench_buf, .write = 1 };
+	second = (ide_request_t){ .drive = 1, .lba = count, .count = count, .buf = bench_buf + bytes, .write = 1 };
+	if(ide_submit(&second) == -1 || ide_submit(&first) == -1) return FAIL;
+	if(ide_wait(&first) != IDE_DONE || ide_wait(&second) != IDE_DONE) return FAIL;
+
+	memset(bench_buf, 0, 2 * bytes);
+	if(ide_read(1, 0, bench_buf, 2 * count) == -1) return FAIL;
+	for(i = 0; i < 2 * bytes; i++){
+		if(bench_buf[i] != (uint8_t)(i * 13)) return FAIL;
+	}
+	if(ide_write(1, 0, saved, 2 * count) == -1) return FAIL;
+	return PASS;
+}
+
+/* ide_polled_test
+ *
+ * Read the first sectors of the master drive with interrupts on and again with them
+ * off, as filesys_init does while booting, and check that both reads complete and agree
+ * Inputs: None
+ * Outputs: PASS or FAIL, PASS if there is no master drive
+ * Side Effects: None
+ */
+int ide_polled_test(){
+	TEST_HEADER;
+
+	uint32_t flags;
+	int32_t i, result;
+	int32_t count = 8;
+	int32_t bytes = count * IDE_SECTOR_SIZE;
+
+	/* only reads, so the boot disk is fine */
+	if(ide_sectors(0) == 0) return PASS;
+	if(ide_read(0, 0, bench_buf, count) == -1) return FAIL;
+	memset(bench_buf + bytes, 0, bytes);
+	cli_and_save(flags);
+	result = ide_read(0, 0, bench_buf + bytes, count);
+	restore_flags(flags);
+	if(result == -1) return FAIL;
+	for(i = 0; i < bytes; i++){
+		if(bench_buf[i] != bench_buf[bytes + i]) return FAIL;
+	}
+	return PASS;
+}
+
+/* getdents_test
+ *
+ * List the root with one dir_getdents call into a buffer larger than the directory and
+ * compare every record with the dentry of the same index, then check the end and a short buffer
+ * Inputs: None
+ * Outputs: PASS or FAIL
+ * Side Effects: None
+ */
+int getdents_test(){
+	TEST_HEADER;
+
+	dirent_t* ents = (dirent_t*)bench_buf;
+	dentry_t dentry;
+	int32_t fd, result;
+	uint32_t i, num;
+	uint8_t data;
+
+	fd = dir_open((const uint8_t*)"/");
+	if(fd == -1) return FAIL;
+	result = dir_getdents(fd, ents, BENCH_BUF_SIZE);
+	if(result <= 0 || result % sizeof(dirent_t) != 0){
+		dir_close(fd);
+		return FAIL;
+	}
+	num = result / sizeof(dirent_t);
+	for(i = 0; i < num; i++){
+		if(read_dentry_by_index(i, &dentry) == -1 ||
+		   strncmp((int8_t*)ents[i].file_name, (int8_t*)dentry.file_name, MAX_FILE_NAME) != 0 ||
+		   ents[i].file_type != dentry.file_type || ents[i].inode_index != dentry.inode_index) break;
+		/* the length of a regular file ends where read_data stops */
+		if(dentry.file_type == REGULAR_FILE_TYPE &&
+		   (read_data(dentry.inode_index, ents[i].length, &data, 1) != 0 ||
+		    (ents[i].length > 0 && read_data(dentry.inode_index, ents[i].length - 1, &data, 1) != 1))) break;
+	}
+	if(i != num || read_dentry_by_index(num, &dentry) != -1 || dir_getdents(fd, ents, BENCH_BUF_SIZE) != 0){
+		dir_close(fd);
+		return FAIL;
+	}
+	dir_close(fd);
+
+	/* a buffer smaller than one record holds nothing */
+	fd = dir_open((const uint8_t*)"/");
+	if(fd == -1) return FAIL;
+	result = dir_getdents(fd, ents, sizeof(dirent_t) - 1);
+	dir_close(fd);
+	return (result == -1) ? PASS : FAIL;
+}
+
+/* random_access_test
+ *
+ * Check fstat and stat against the file content, pread against read_data, and that
+ * lseek moves the position while pread leaves it alone
+ * Inputs: None
+ * Outputs: PASS or FAIL
+ * Side Effects: None
+ */
+int random_access_test(){
+	TEST_HEADER;
+
+	stat_t st, path_st;
+	dentry_t dentry;
+	int32_t fd, result = PASS;
+
+	if(read_dentry_by_name((const uint8_t*)"frame0.txt", &dentry) == -1) return FAIL;
+	fd = fopen((const uint8_t*)"frame0.txt");
+	if(fd == -1) return FAIL;
+
+	if(file_fstat(fd, &st) == -1 || file_stat((const uint8_t*)"frame0.txt", &path_st) == -1 ||
+	   st.file_type != REGULAR_FILE_TYPE || st.inode_index != dentry.inode_index ||
+	   path_st.length != st.length || st.length < 20 ||
+	   read_data(dentry.inode_index, st.length, buf1, 1) != 0) result = FAIL;
+
+	/* pread reads at its offset only */
+	if(result == PASS && (file_pread(fd, buf1, 10, 10) != 10 || read_data(dentry.inode_index, 10, buf2, 10) != 10 ||
+	   strncmp((int8_t*)buf1, (int8_t*)buf2, 10) != 0 || fread(fd, buf1, 10) != 10 ||
+	   read_data(dentry.inode_index, 0, buf2, 10) != 10 || strncmp((int8_t*)buf1, (int8_t*)buf2, 10) != 0)) result = FAIL;
+
+	/* lseek from each origin, never before the start */
+	if(result == PASS && (file_lseek(fd, 5, SEEK_SET) != 5 || file_lseek(fd, -2, SEEK_CUR) != 3 ||
+	   file_lseek(fd, 0, SEEK_END) != (int32_t)st.length || file_lseek(fd, -1, SEEK_SET) != -1 ||
+	   file_lseek(fd, 0, 3) != -1 || fread(fd, buf1, 1) != 0)) result = FAIL;
+	fclose(fd);
+
+	if(file_stat((const uint8_t*)"/", &path_st) == -1 || path_st.file_type != DIR_FILE_TYPE) return FAIL;
+	if(file_stat((const uint8_t*)"nonexistent.txt", &path_st) != -1) return FAIL;
+	return result;
+}
+
+/* fd_table_test
+ *
+ * Open more files than the pcb holds so the table grows, check that freed fds are
+ * reused lowest first, and that dup and dup2 share one position and outlive the original fd
+ * Inputs: None
+ * Outputs: PASS or FAIL
+ * Side Effects: None
+ */
+int fd_table_test(){
+	TEST_HEADER;
+
+	int32_t fds[NUM_FILES + 2];
+	int32_t i, copy, result = PASS;
+	uint8_t expected[2];
+	dentry_t dentry;
+
+	if(read_dentry_by_name((const uint8_t*)"frame0.txt", &dentry) == -1 || read_data(dentry.inode_index, 0, expected, 2) != 2) return FAIL;
+	for(i = 0; i < NUM_FILES + 2; i++){
+		fds[i] = fopen((const uint8_t*)"frame0.txt");
+		if(fds[i] == -1 || (i > 0 && fds[i] != fds[i - 1] + 1)) result = FAIL;
+	}
+	if(result == PASS && get_current_pcb()->fd_max != MAX_FILES) result = FAIL;
+
+	/* the lowest free fd comes back first */
+	if(result == PASS){
+		fclose(fds[1]);
+		if(fopen((const uint8_t*)"frame0.txt") != fds[1]) result = FAIL;
+	}
+
+	/* a copy shares the position and stays usable once the original is closed */
+	copy = fd_dup(fds[0]);
+	if(result == PASS && (copy == -1 || fread(fds[0], buf1, 1) != 1 || fread(copy, buf2, 1) != 1 ||
+	   buf1[0] != expected[0] || buf2[0] != expected[1])) result = FAIL;
+	if(result == PASS && (fd_dup2(copy, MAX_FILES - 1) != MAX_FILES - 1 || fclose(fds[0]) == -1 || fclose(copy) == -1 ||
+	   fd_get(MAX_FILES - 1) == NULL || fd_get(MAX_FILES - 1)->file_position != 2 || fd_dup2(copy, MAX_FILES) != -1)) result = FAIL;
+	fclose(MAX_FILES - 1);
+
+	for(i = 1; i < NUM_FILES + 2; i++){
+		if(fds[i] != -1) fclose(fds[i]);
+	}
+	return result;
+}
+
+/* tmpfs_test
+ *
+ * Write a tmpfs file across a page boundary, read it back and list it, then unlink it
+ * while it is open and check its pages only return to the pool on the last close
+ * Inputs: None
+ * Outputs: PASS or FAIL
+ * Side Effects: None if it passes
+ */
+int tmpfs_test(){
+	TEST_HEADER;
+
+	uint8_t path[] = "/tmp/scratch";
+	uint32_t free_pages = kpage_free_count();
+	int32_t fd, dir, result = PASS;
+	stat_t st;
+	dirent_t ent;
+
+	if(tmpfs_create(path) == -1 || tmpfs_create(path) != -1) return FAIL;
+	if(tmpfs_create((const uint8_t*)"/tmp/a/b") != -1 || tmpfs_path((const uint8_t*)"/tmpfile")) return FAIL;
+	fd = tmpfs_open(path);
+	if(fd == -1) return FAIL;
+
+	memset(bench_buf, 'x', PAGE_SIZE + 10);
+	if(tmpfs_pwrite(fd, bench_buf, PAGE_SIZE + 10, 100) != PAGE_SIZE + 10 || kpage_free_count() != free_pages - 2) result = FAIL;
+	if(result == PASS && (tmpfs_read(fd, buf1, 200) != 200 || buf1[99] != 0 || buf1[100] != 'x')) result = FAIL;
+	if(result == PASS && (tmpfs_stat(path, &st) == -1 || st.file_type != REGULAR_FILE_TYPE || st.length != PAGE_SIZE + 110)) result = FAIL;
+
+	dir = tmpfs_open((const uint8_t*)"/tmp/");
+	if(result == PASS && (dir == -1 || tmpfs_getdents(dir, &ent, sizeof(ent)) != sizeof(ent) ||
+	   strncmp((int8_t*)ent.file_name, (int8_t*)"scratch", MAX_FILE_NAME) != 0 || ent.length != PAGE_SIZE + 110)) result = FAIL;
+	if(dir != -1) tmpfs_close(dir);
+
+	/* the name goes at once, the pages with the last fd */
+	if(tmpfs_unlink(path) == -1 || tmpfs_open(path) != -1) result = FAIL;
+	if(result == PASS && (tmpfs_pread(fd, buf1, 1, PAGE_SIZE) != 1 || buf1[0] != 'x' || kpage_free_count() != free_pages - 2)) result = FAIL;
+	tmpfs_close(fd);
+	if(kpage_free_count() != free_pages) result = FAIL;
+	return result;
+}
+
+/* pipe_test
+ *
+ * Write a pipe across a page boundary, read part of it back, then close the write end
+ * and check the rest reads out before the end of the data, with every page given back.
+ * Then fill a pipe whose head is partway into its first page, so the writer wraps into
+ * that page, check the short write is reported and that it drains with the wrapped bytes intact
+ * Inputs: None
+ * Outputs: PASS or FAIL
+ * Side Effects: None if it passes
+ */
+int pipe_test(){
+	TEST_HEADER;
+
+	uint32_t free_pages = kpage_free_count();
+	int32_t fds[2], len, total, result = PASS;
+	stat_t st;
+
+	if(pipe_create(fds) == -1) return FAIL;
+	memset(bench_buf, 'p', PAGE_SIZE + 10);
+	if(pipe_write(fds[1], bench_buf, PAGE_SIZE + 10) != PAGE_SIZE + 10 || kpage_free_count() != free_pages - 2) result = FAIL;
+	if(result == PASS && (pipe_read(fds[0], buf1, 200) != 200 || buf1[0] != 'p' || buf1[199] != 'p')) result = FAIL;
+	if(result == PASS && (pipe_fstat(fds[0], &st) == -1 || st.file_type != PIPE_FILE_TYPE || st.length != PAGE_SIZE - 190 || st.flags != 0)) result = FAIL;
+	/* each end only goes one way */
+	if(result == PASS && (pipe_read(fds[1], buf1, 1) != -1 || pipe_write(fds[0], bench_buf, 1) != -1)) result = FAIL;
+
+	/* nothing else holds the write end, so the reader gets the rest and then the end of the data */
+	pipe_write_close(fds[1]);
+	if(result == PASS && (pipe_read(fds[0], bench_buf, PAGE_SIZE) != PAGE_SIZE - 190 || kpage_free_count() != free_pages)) result = FAIL;
+	if(result == PASS && pipe_read(fds[0], buf1, 1) != 0) result = FAIL;
+	pipe_read_close(fds[0]);
+	if(result == FAIL) return FAIL;
+
+	/* nothing reads while it fills, so the writes come back short once it is full */
+	if(pipe_create(fds) == -1) return FAIL;
+	if(pipe_write(fds[1], bench_buf, 200) != 200 || pipe_read(fds[0], buf1, 100) != 100) result = FAIL;
+	memset(bench_buf, 'w', PAGE_SIZE);
+	for(total = 0; result == PASS && (len = pipe_write(fds[1], bench_buf, PAGE_SIZE)) > 0; total += len);
+	if(result == PASS && total != PIPE_SIZE - 100) result = FAIL;
+	/* the write that came back short is reported */
+	if(result == PASS && (pipe_fstat(fds[0], &st) == -1 || st.length != PIPE_SIZE || st.flags != STAT_PIPE_LOST)) result = FAIL;
+	for(total = 0; result == PASS && (len = pipe_read(fds[0], buf1, PAGE_SIZE)) > 0; total += len);
+	if(result == PASS && (total != PIPE_SIZE || buf1[(total - 1) % PAGE_SIZE] != 'w')) result = FAIL;
+	pipe_write_close(fds[1]);
+	pipe_read_close(fds[0]);
+	if(kpage_free_count() != free_pages) result = FAIL;
+	return result;
+}
+
+/* uring_test
+ *
+ * Queue writes into a pipe, a read back and an entry with a bad opcode, run them in one
+ * batch and check the completions come back in order with the results of the calls
+ * Inputs: None
+ * Outputs: PASS or FAIL
+ * Side Effects: None if it passes
+ */
+int uring_test(){
+	TEST_HEADER;
+
+	static uring_t ring;
+	uint32_t i, opcodes[4] = {URING_OP_WRITE, URING_OP_WRITE, URING_OP_READ, URING_OP_READ + 100};
+	int32_t fds[2], expected[4] = {3, 3, 6, -1}, result = PASS;
+
+	if(pipe_create(fds) == -1) return FAIL;
+	memset(&ring, 0, sizeof(ring));
+	for(i = 0; i < 4; i++){
+		ring.sq[i].opcode = opcodes[i];
+		ring.sq[i].fd = (opcodes[i] == URING_OP_WRITE) ? fds[1] : fds[0];
+		ring.sq[i].buf = (opcodes[i] == URING_OP_WRITE) ? (void*)"abc" : (void*)buf2;
+		ring.sq[i].len = (opcodes[i] == URING_OP_WRITE) ? 3 : 10;
+		ring.sq[i].user_data = i;
+	}
+	ring.sq_tail = 4;
+
+	/* only two run when asked for two */
+	if(uring_run(&ring, 2) != 2 || ring.sq_head != 2 || ring.cq_tail != 2) result = FAIL;
+	if(result == PASS && (uring_run(&ring, 0) != 2 || ring.cq_tail != 4)) result = FAIL;
+	for(i = 0; result == PASS && i < 4; i++){
+		if(ring.cq[i].user_data != i || ring.cq[i].res != expected[i]) result = FAIL;
+	}
+	if(result == PASS && strncmp((int8_t*)buf2, (int8_t*)"abcabc", 6) != 0) result = FAIL;
+
+	/* a full completion ring holds the rest back */
+	ring.sq_tail = ring.sq_head + 1;
+	ring.cq_head = ring.cq_tail - URING_ENTRIES;
+	if(result == PASS && uring_run(&ring, 0) != 0) result = FAIL;
+
+	pipe_write_close(fds[1]);
+	pipe_read_close(fds[0]);
+	return result;
+}
+
+/* poll_test
+ *
+ * Poll both ends of a pipe no other process holds, which never wait, with an fd that
+ * is not open and one to skip, then check an empty poll times out no earlier than asked
+ * Inputs: None
+ * Outputs: PASS or FAIL
+ * Side Effects: None if it passes
+ */
+int poll_test(){
+	TEST_HEADER;
+
+	pollfd_t fds[4];
+	int32_t ends[2], result = PASS;
+	uint32_t start;
+
+	if(pipe_create(ends) == -1) return FAIL;
+	fds[0].fd = ends[0];
+	fds[0].events = POLLIN | POLLOUT;
+	fds[1].fd = ends[1];
+	fds[1].events = POLLIN | POLLOUT;
+	fds[2].fd = MAX_FILES - 1;
+	fds[2].events = POLLIN;
+	fds[3].fd = -1;
+	fds[3].events = POLLIN;
+	if(poll_wait(fds, 4, 0) != 3 || fds[0].revents != POLLIN || fds[1].revents != POLLOUT ||
+	   fds[2].revents != POLLNVAL || fds[3].revents != 0) result = FAIL;
+
+	start = pit_ticks;
+	if(result == PASS && (poll_wait(&(fds[3]), 1, 3 * POLL_MS_PER_TICK) != 0 || pit_ticks - start < 3)) result = FAIL;
+
+	pipe_write_close(ends[1]);
+	pipe_read_close(ends[0]);
+	return result;
+}
+
+/* vdso_test
+ *
+ * Publish a date and a tick count and read them back through the user mapping of the page
+ * Inputs: None
+ * Outputs: PASS or FAIL
+ * Side Effects: the published date stays until the RTC handler reads the CMOS again
+ */
+int vdso_test(){
+	TEST_HEADER;
+
+	vdso_data_t* vdso = (vdso_data_t*)VDSO_ADDR;
+	uint32_t seq = vdso->seq;
+
+	vdso_set_date(1, 2, 3, 4, 5, 6);
+	if(vdso->seq != seq + 2 || (vdso->seq & 1) || vdso->hz != VDSO_HZ) return FAIL;
+	if(vdso->sec != 1 || vdso->min != 2 || vdso->hour != 3 || vdso->day != 4 || vdso->month != 5 || vdso->year != 6) return FAIL;
+	vdso_tick(pit_ticks);
+	if(vdso->ticks != pit_ticks) return FAIL;
+	return PASS;
+}
+
+/* trace_test
+ *
+ * Trace more fstat calls on fds that are not open than the ring holds, then check the
+ * newest ones read back oldest first and every call landed in the histogram
+ * Inputs: None
+ * Outputs: PASS or FAIL
+ * Side Effects: None if it passes
+ */
+int trace_test(){
+	TEST_HEADER;
+
+	static trace_entry_t entries[TRACE_ENTRIES];
+	static uint32_t hist[TRACE_SYSCALLS][TRACE_BUCKETS];
+	pcb_t* pcb = get_current_pcb();
+	uint32_t i, calls = 0, num = 27;	// 27 is fstat
+	int32_t result = PASS;
+
+	pcb->trace = kpage_alloc();
+	pcb->trace_done = NULL;
+	if(pcb->trace == NULL) return FAIL;
+	trace_ctl(TRACE_ON, NULL, 0);
+	for(i = 0; i < TRACE_ENTRIES + 2; i++){
+		if(trace_dispatch(num, MAX_FILES + i, 0, 0, 0) != -1) result = FAIL;
+	}
+
+	/* what halt hands to the parent */
+	pcb->trace_done = pcb->trace;
+	pcb->trace = NULL;
+	if(result == PASS && trace_ctl(TRACE_READ, entries, sizeof(entries)) != sizeof(entries)) result = FAIL;
+	for(i = 0; result == PASS && i < TRACE_ENTRIES; i++){
+		if(entries[i].num != num || entries[i].args[0] != MAX_FILES + i + 2 || entries[i].ret != -1) result = FAIL;
+	}
+	if(result == PASS && trace_ctl(TRACE_HIST, hist, sizeof(hist)) != sizeof(hist)) result = FAIL;
+	for(i = 0; i < TRACE_BUCKETS; i++) calls += hist[num][i];
+	if(calls != TRACE_ENTRIES + 2) result = FAIL;
+
+	trace_ctl(TRACE_OFF, NULL, 0);
+	kpage_free(pcb->trace_done);
+	pcb->trace_done = NULL;
+	return result;
+}
+
+/* signal_mask_test
+ *
+ * Send two signals to the current process and check each sets only its own pending bit,
+ * then clear them so nothing is delivered
+ * Inputs: None
+ * Outputs: PASS or FAIL
+ * Side Effects: None
+ */
+int signal_mask_test(){
+	TEST_HEADER;
+
+	pcb_t* pcb = get_current_pcb();
+	uint32_t pending = pcb->sig_pending, blocked = pcb->sig_blocked;
+	int32_t result = PASS;
+
+	/* blocked, so no interrupt return delivers them */
+	pcb->sig_blocked = SIG_ALL;
+	pcb->sig_pending = 0;
+	send_signal(SIGNUM_USER1);
+	if(pcb->sig_pending != SIG_BIT(SIGNUM_USER1)) result = FAIL;
+	send_signal_by_pid(SIGNUM_ALARM, get_current_pid());
+	if(pcb->sig_pending != (SIG_BIT(SIGNUM_USER1) | SIG_BIT(SIGNUM_ALARM))) result = FAIL;
+	send_signal(SIG_NUM);
+	if(pcb->sig_pending & ~SIG_ALL) result = FAIL;
+	pcb->sig_pending = pending;
+	pcb->sig_blocked = blocked;
+	return result;
+}
+
+/* sigaction_test
+ *
+ * Set actions of the current process through sigaction, refuse a handler outside the user
+ * page and a kill of a pid not in use, and check the trampoline page holds sigreturn
+ * Inputs: None
+ * Outputs: PASS or FAIL
+ * Side Effects: None
+ */
+int sigaction_test(){
+	TEST_HEADER;
+
+	pcb_t* pcb = get_current_pcb();
+	signal_t saved[SIG_NUM];
+	void* handler = (void*)(_128_MB + 0x100);
+	uint32_t i;
+	int32_t result = PASS;
+
+	memcpy(saved, pcb->signals, sizeof(saved));
+	if(__syscall_sigaction(SIGNUM_USER1, handler, SIG_BIT(SIGNUM_ALARM) | SIG_BIT(SIG_NUM)) != 0) result = FAIL;
+	if(pcb->signals[SIGNUM_USER1].sa_handler != handler || pcb->signals[SIGNUM_USER1].sa_mask != SIG_BIT(SIGNUM_ALARM)) result = FAIL;
+	if(__syscall_sigaction(SIGNUM_INTERRUPT, SIG_IGN, 0) != 0 || pcb->signals[SIGNUM_INTERRUPT].sa_handler != __signal_ignore) result = FAIL;
+	if(__syscall_sigaction(SIGNUM_INTERRUPT, SIG_DFL, 0) != 0 || pcb->signals[SIGNUM_INTERRUPT].sa_handler != __signal_kill_task) result = FAIL;
+	if(__syscall_sigaction(SIGNUM_USER1, (void*)KERNEL_ADDR, 0) != -1 || __syscall_sigaction(SIG_NUM, SIG_IGN, 0) != -1) result = FAIL;
+	memcpy(pcb->signals, saved, sizeof(saved));
+
+	if(__syscall_kill(MAX_PID_NUM, SIGNUM_USER1) != -1) result = FAIL;
+	for(i = 0; i < (uint32_t)(EXECUTE_SIGRETURN_END - EXECUTE_SIGRETURN); i++){
+		if(((uint8_t*)SIGTRAMP_ADDR)[i] != ((uint8_t*)EXECUTE_SIGRETURN)[i]) result = FAIL;
+	}
+	return result;
+}
+
+/* key_ring_test
+ *
+ * Feed a raw terminal more key events than its ring holds, check the extra ones are counted
+ * as dropped and the rest read back in order, releases with the high bit set
+ * Inputs: None
+ * Outputs: PASS or FAIL
+ * Side Effects: keys waiting on the terminal are dropped
+ */
+int key_ring_test(){
+	TEST_HEADER;
+
+	key_ring_t* ring = &vt_state[foreground_vt].key_ring;
+	int32_t raw = vt_state[foreground_vt].raw;
+	uint32_t i, dropped, flags;
+	int32_t result = PASS;
+
+	if(cur_vt != foreground_vt) return FAIL;
+	vt_ioctl(1);
+	cli_and_save(flags);
+	dropped = ring->dropped;
+	for(i = 0; i < KEY_RING_SIZE + 2; i++){
+		vt_keyboard(KEY_A + i % 2, i % 2);
+	}
+	restore_flags(flags);
+	if(ring->dropped != dropped + 2 || vt_poll(0) != POLLIN) result = FAIL;
+
+	if(vt_read(0, buf2, KEY_RING_SIZE) != KEY_RING_SIZE) result = FAIL;
+	for(i = 0; result == PASS && i < KEY_RING_SIZE; i++){
+		if(buf2[i] != ((i % 2) ? ((KEY_A + 1) | 0x80) : KEY_A)) result = FAIL;
+	}
+	if(vt_poll(0) != 0) result = FAIL;
+	vt_state[foreground_vt].raw = raw;
+	return result;
+}
+
+/* irqstat_test
+ *
+ * Time two runs of a vector no handler uses, one of them longer than 2^32 cycles, and check
+ * the count, the 64-bit total, the maximum and the histogram, and that an exit with no entry
+ * is skipped. Then check the PIT is only counted while timing is on
+ * Inputs: None
+ * Outputs: PASS or FAIL
+ * Side Effects: timing is left off
+ */
+int irqstat_test(){
+	TEST_HEADER;
+
+	static irqstat_t stats[IRQSTAT_VECTORS];
+	uint32_t vector = 15;	// reserved by Intel, never raised
+	uint32_t start, pit_count;
+	irqstat_t* stat = &(stats[vector]);
+	int32_t result = PASS;
+
+	if(irqstat_ctl(IRQSTAT_ON, NULL, 0) != 0) return FAIL;
+	if(irqstat_ctl(IRQSTAT_READ, stats, sizeof(stats)) != sizeof(stats) || stat->count != 0) result = FAIL;
+	irqstat_start[vector][0] = 0xFFFFFF00;
+	irqstat_start[vector][1] = 1;
+	irqstat_record(vector, 0x100, 2);
+	irqstat_start[vector][0] = 0xFFFFFF00;
+	irqstat_start[vector][1] = 1;
+	irqstat_record(vector, 0, 4);
+	irqstat_record(vector, 0, 5);
+	if(result == PASS && irqstat_read(stats, sizeof(stats)) != sizeof(stats)) result = FAIL;
+	if(result == PASS && (stat->count != 2 || stat->max != 0xFFFFFFFF || stat->hist[9] != 1 || stat->hist[31] != 1)) result = FAIL;
+	if(result == PASS && (stat->total_low != 0x1FF || stat->total_high != 1)) result = FAIL;
+
+	/* two ticks with timing on, then two with it off */
+	for(start = pit_ticks; pit_ticks - start < 2;);
+	if(irqstat_ctl(IRQSTAT_OFF, NULL, 0) != 0) result = FAIL;
+	irqstat_read(stats, sizeof(stats));
+	pit_count = stats[PIT_VEC].count;
+	for(start = pit_ticks; pit_ticks - start < 2;);
+	irqstat_read(stats, sizeof(stats));
+	if(result == PASS && (pit_count < 2 || stats[PIT_VEC].count != pit_count)) result = FAIL;
+	if(result == PASS && irqstat_ctl(IRQSTAT_READ + 1, stats, sizeof(stats)) != -1) result = FAIL;
+	return result;
+}
+
+/* bcache_test
+ *
+ * Modify a block of a RAM disk over bench_buf through the cache, check that the disk only
+ * changes on sync, then dirty it again and read enough blocks of a second RAM disk over
+ * the kernel image to evict it, which must write it back
+ * Inputs: None
+ * Outputs: PASS or FAIL
+ * Side Effects: None
+ */
+int bcache_test(){
+	TEST_HEADER;
+
+	blkdev_t scratch, kernel_image;
+	buf_t* buf;
+	buf_t* again;
+	uint32_t i;
+
+	ramdisk_init(&scratch, bench_buf, BENCH_BUF_SIZE / BLKDEV_BLOCK_SIZE);
+	ramdisk_init(&kernel_image, (uint8_t*)0x400000, BCACHE_SIZE + 1);	// 0x400000 the kernel page, only read
+	memset(bench_buf, 'a', 2 * BLKDEV_BLOCK_SIZE);
+
+	/* a hit returns the same buffer with the content of the disk */
+	buf = bread(&scratch, 1);
+	if(buf == NULL) return FAIL;
+	again = bread(&scratch, 1);
+	brelse(again);
+	if(again != buf || buf->data[0] != 'a' || buf->data[BLKDEV_BLOCK_SIZE - 1] != 'a'){
+		brelse(buf);
+		return FAIL;
+	}
+	buf->data[0] = 'b';
+	bdirty(buf);
+
+	/* the disk changes on sync only, the flusher skips the block while it is held */
+	if(bench_buf[BLKDEV_BLOCK_SIZE] != 'a' || bsync() == -1 || bench_buf[BLKDEV_BLOCK_SIZE] != 'b'){
+		brelse(buf);
+		return FAIL;
+	}
+	brelse(buf);
+	if(bread(&scratch, BENCH_BUF_SIZE / BLKDEV_BLOCK_SIZE) != NULL) return FAIL;
+
+	/* a whole block from bget, written back when evicted */
+	buf = bget(&scratch, 0);
+	if(buf == NULL) return FAIL;
+	memset(buf->data, 'c', BLKDEV_BLOCK_SIZE);
+	bdirty(buf);
+	brelse(buf);
+	for(i = 0; i <= BCACHE_SIZE; i++){
+		buf = bread(&kernel_image, i);
+		if(buf == NULL) return FAIL;
+		brelse(buf);
+	}
+	if(bench_buf[0] != 'c' || bench_buf[BLKDEV_BLOCK_SIZE - 1] != 'c') return FAIL;
+	return PASS;
+}
+
+/* bread_direct_test
+ *
+ * Copy a run of blocks of a RAM disk over the first half of bench_buf into its second
+ * half, check that the copy is refused while a block of the run is dirty in the cache
+ * and allowed again once it has been written back
+ * Inputs: None
+ * Outputs: PASS or FAIL
+ * Side Effects: None
+ */
+int bread_direct_test(){
+	TEST_HEADER;
+
+	blkdev_t scratch;
+	buf_t* buf;
+	uint8_t* out = bench_buf + BENCH_BUF_SIZE / 2;
+	uint32_t num_blocks = BENCH_BUF_SIZE / 2 / BLKDEV_BLOCK_SIZE;
+
+	ramdisk_init(&scratch, bench_buf, num_blocks);
+	memset(bench_buf, 'a', BENCH_BUF_SIZE / 2);
+	memset(out, 0, BENCH_BUF_SIZE / 2);
+
+	if(bread_direct(&scratch, 1, 2, out) == -1) return FAIL;
+	if(out[0] != 'a' || out[2 * BLKDEV_BLOCK_SIZE - 1] != 'a' || out[2 * BLKDEV_BLOCK_SIZE] != 0) return FAIL;
+	if(bread_direct(&scratch, num_blocks - 1, 2, out) != -1) return FAIL;
+
+	/* the device is stale while the cache holds a newer block */
+	buf = bread(&scratch, 2);
+	if(buf == NULL) return FAIL;
+	buf->data[0] = 'b';
+	bdirty(buf);
+	brelse(buf);
+	if(bread_direct(&scratch, 1, 2, out) != -1) return FAIL;
+	if(bsync() == -1) return FAIL;
+	if(bread_direct(&scratch, 1, 2, out) == -1 || out[BLKDEV_BLOCK_SIZE] != 'b') return FAIL;
+	return PASS;
+}
+
 /* Checkpoint 4 tests */
 /* Checkpoint 5 tests */
 
+/* Performance tests */
+
+/* ide_bcache_test
+ *
+ * Dirty a block of a device over the slave drive through the cache, let the flusher
+ * start its write-back without waiting, then check that bread waits for it and reaps
+ * it and that the drive holds the new content, and restore the old one
+ * Inputs: None
+ * Outputs: PASS or FAIL, PASS if there is no slave drive
+ * Side Effects: None if it passes
+ */
+int ide_bcache_test(){
+	TEST_HEADER;
+
+	blkdev_t disk;
+	buf_t* buf;
+	buf_t* again;
+	uint32_t i, flags;
+	int32_t result = PASS;
+	uint8_t* saved = bench_buf + BLKDEV_BLOCK_SIZE;
+
+	/* the master is the boot disk, only the slave is scratch */
+	if(ide_sectors(1) == 0) return PASS;
+	if(ide_blkdev_init(&disk, 1, 0) == -1 || ide_read(1, 0, saved, IDE_SECTORS_PER_BLOCK) == -1) return FAIL;
+
+	buf = bget(&disk, 0);
+	if(buf == NULL) return FAIL;
+	for(i = 0; i < BLKDEV_BLOCK_SIZE; i++){
+		buf->data[i] = (uint8_t)(i * 11);
+	}
+	bdirty(buf);
+	brelse(buf);
+
+	/* a full flush period, the write is started and the flusher returns at once */
+	cli_and_save(flags);
+	for(i = 0; i < BCACHE_FLUSH_TICKS && !(buf->flags & B_WRITING); i++){
+		bcache_flush_tick();
+	}
+	restore_flags(flags);
+	if(!(buf->flags & B_WRITING) || (buf->flags & B_DIRTY)) result = FAIL;
+
+	/* the next holder waits for the write-back and finds the block clean */
+	again = bread(&disk, 0);
+	if(again == NULL) return FAIL;
+	if(again != buf || (buf->flags & (B_WRITING | B_DIRTY)) || buf->io.status != IDE_DONE) result = FAIL;
+	brelse(again);
+
+	memset(bench_buf, 0, BLKDEV_BLOCK_SIZE);
+	if(ide_read(1, 0, bench_buf, IDE_SECTORS_PER_BLOCK) == -1) result = FAIL;
+	for(i = 0; result == PASS && i < BLKDEV_BLOCK_SIZE; i++){
+		if(bench_buf[i] != (uint8_t)(i * 11)) result = FAIL;
+	}
+
+	/* put the old content back through the cache as well, so the buffer matches the drive */
+	buf = bread(&disk, 0);
+	if(buf == NULL) return FAIL;
+	memcpy(buf->data, saved, BLKDEV_BLOCK_SIZE);
+	bdirty(buf);
+	brelse(buf);
+	if(bsync() == -1) return FAIL;
+	return result;
+}
+
+/* read_data_throughput_test
+ *
+ * Read the largest regular file of the image BENCH_PASSES times through read_data
+ * and report how many cycles the copy costs per kB
+ * Inputs: None
+ * Outputs: PASS or FAIL
+ * Side Effects: None
+ */
+int read_data_throughput_test(){
+	TEST_HEADER;
+
+	dentry_t dentry;
+	dentry_t largest;
+	uint32_t i, pass, len;
+	uint32_t offset, bytes = 0, max_len = 0;
+	uint32_t start_low, start_high, end_low, end_high;
+	uint32_t cycles_low, cycles_high, kb, per_kb, rem;
+	int32_t ret;
+
+	/* find the largest regular file by reading every file once, which also warms the caches */
+	for(i = 0; read_dentry_by_index(i, &dentry) == 0; i++){
+		if(dentry.file_type != REGULAR_FILE_TYPE) continue;
+		offset = 0;
+		while((ret = read_data(dentry.inode_index, offset, bench_buf, BENCH_BUF_SIZE)) > 0) offset += ret;
+		if(ret == -1) return FAIL;
+		if(offset > max_len){
+			max_len = offset;
+			largest = dentry;
+		}
+	}
+	if(max_len == 0) return FAIL;
+
+	rdtsc(start_low, start_high);
+	for(pass = 0; pass < BENCH_PASSES; pass++){
+		offset = 0;
+		while((ret = read_data(largest.inode_index, offset, bench_buf, BENCH_BUF_SIZE)) > 0) offset += ret;
+		bytes += offset;
+	}
+	rdtsc(end_low, end_high);
+
+	/* the passes can take more than 2^32 cycles, so the count is 64 bits with the borrow
+	 * carried, and divided a word at a time, the remainder of the high word leads the low */
+	cycles_low = end_low - start_low;
+	cycles_high = end_high - start_high - (end_low < start_low);
+	kb = (bytes >> 10) + 1;
+	rem = cycles_high % kb;
+	asm ("divl %3" : "=a"(per_kb), "=d"(rem) : "a"(cycles_low), "r"(kb), "d"(rem) : "cc");
+
+	for(len = 0; len < MAX_FILE_NAME && largest.file_name[len] != '\0'; len++);
+	printf("Read ");
+	vt_write(1, largest.file_name, len);
+	if(cycles_high == 0){
+		printf(" %u times: %u bytes in %u cycles", BENCH_PASSES, bytes, cycles_low);
+	} else {
+		printf(" %u times: %u bytes in %u * 2^32 + %u cycles", BENCH_PASSES, bytes, cycles_high, cycles_low);
+	}
+	/* the quotient of the high word is 0 unless a kB took 2^32 cycles */
+	if(cycles_high / kb == 0){
+		printf(", %u cycles per kB\n", per_kb);
+	} else {
+		printf(", over 2^32 cycles per kB\n");
+	}
+	return PASS;
+}
+
 
 /* Test suite entry point */
 void launch_tests(){
+	/* the tests run on the boot stack, which is inside the pcb of pid 0, give it an empty fd table */
+	get_current_pcb()->pid = 0;
+	fd_table_init(get_current_pcb());
+
 	/* Checkpoint 1 Tests*/
 	// TEST_OUTPUT("idt_test", idt_test());
 	// TEST_OUTPUT("div_by_zero", div_by_zero());
@@ -657,4 +1711,31 @@ void launch_tests(){
 	// TEST_OUTPUT("keyboard_write_syscall_test", keyboard_write_syscall_test());
 	// TEST_OUTPUT("heavy_load_syscall_test", heavy_load_syscall_test());
 	// TEST_OUTPUT("syscall_edge_test", syscall_edge_test());
+	// TEST_OUTPUT("readv_syscall_test", readv_syscall_test());
+	// TEST_OUTPUT("write_data_test", write_data_test());
+	// TEST_OUTPUT("write_offset_test", write_offset_test());
+	// TEST_OUTPUT("file_create_unlink_test", file_create_unlink_test());
+	// TEST_OUTPUT("inline_file_test", inline_file_test());
+	// TEST_OUTPUT("directory_tree_test", directory_tree_test());
+	// TEST_OUTPUT("ide_rw_test", ide_rw_test());
+	// TEST_OUTPUT("ide_polled_test", ide_polled_test());
+	// TEST_OUTPUT("bcache_test", bcache_test());
+	// TEST_OUTPUT("bread_direct_test", bread_direct_test());
+	// TEST_OUTPUT("ide_bcache_test", ide_bcache_test());
+	// TEST_OUTPUT("getdents_test", getdents_test());
+	// TEST_OUTPUT("random_access_test", random_access_test());
+	// TEST_OUTPUT("fd_table_test", fd_table_test());
+	// TEST_OUTPUT("tmpfs_test", tmpfs_test());
+	// TEST_OUTPUT("pipe_test", pipe_test());
+	// TEST_OUTPUT("uring_test", uring_test());
+	// TEST_OUTPUT("poll_test", poll_test());
+	// TEST_OUTPUT("vdso_test", vdso_test());
+	// TEST_OUTPUT("trace_test", trace_test());
+	// TEST_OUTPUT("signal_mask_test", signal_mask_test());
+	// TEST_OUTPUT("sigaction_test", sigaction_test());
+	// TEST_OUTPUT("key_ring_test", key_ring_test());
+	// TEST_OUTPUT("irqstat_test", irqstat_test());
+
+	/* Performance Tests*/
+	// TEST_OUTPUT("read_data_throughput_test", read_data_throughput_test());
 }
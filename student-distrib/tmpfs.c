@@ -0,0 +1,539 @@
+/* tmpfs.c - RAM-backed file system for scratch files, mounted at /tmp
+ * vim:ts=4 noexpandtab
+ */
+
+#include "tmpfs.h"
+#include "kpage.h"
+#include "fdtable.h"
+#include "lib.h"
+
+operation_table_t tmpfs_operation_table = {
+    .open_operation = tmpfs_open,
+    .close_operation = tmpfs_close,
+    .read_operation = tmpfs_read,
+    .write_operation = tmpfs_write
+};
+
+operation_table_t tmpfs_dir_operation_table = {
+    .open_operation = tmpfs_open,
+    .close_operation = tmpfs_close,
+    .read_operation = tmpfs_dir_read,
+    .write_operation = tmpfs_dir_write
+};
+
+static tmpfs_file_t tmpfs_files[TMPFS_MAX_FILES];
+
+/* tmpfs_init
+ *
+ * set up the empty file system
+ * Inputs: None
+ * Outputs: None
+ * Side Effects: None
+ */
+void tmpfs_init(void){
+    memset(tmpfs_files, 0, sizeof(tmpfs_files));
+}
+
+/* tmpfs_path
+ *
+ * check if a path is the mount point or below it
+ * Inputs: path - the path
+ * Outputs: 1 if tmpfs holds the path, 0 if not
+ * Side Effects: None
+ */
+int32_t tmpfs_path(const uint8_t* path){
+    if(path == NULL || strncmp((const int8_t*)path, (const int8_t*)TMPFS_MOUNT, TMPFS_MOUNT_LEN) != 0) return 0;
+    return path[TMPFS_MOUNT_LEN] == '\0' || path[TMPFS_MOUNT_LEN] == '/';
+}
+
+/* tmpfs_name
+ *
+ * get the file name of a tmpfs path, slashes around it are ignored
+ * Inputs: path - a path tmpfs_path accepts
+ *         name - filled with the name, MAX_FILE_NAME + 1 bytes, empty for the mount point
+ * Outputs: 0 if successful, -1 if the name is too long or names a deeper path
+ * Side Effects: None
+ */
+static int32_t tmpfs_name(const uint8_t* path, uint8_t* name){
+    uint32_t len = 0;
+    path += TMPFS_MOUNT_LEN;
+    while(*path == '/') path++;
+    while(path[len] != '\0' && path[len] != '/'){
+        if(len >= MAX_FILE_NAME) return -1;
+        name[len] = path[len];
+        len++;
+    }
+    name[len] = '\0';
+    path += len;
+    while(*path == '/') path++;
+    return (*path == '\0') ? 0 : -1;
+}
+
+/* tmpfs_lookup
+ *
+ * find a file by name
+ * Inputs: name - the name, not empty
+ * Outputs: the index of the file, -1 if there is no such file
+ * Side Effects: None
+ */
+static int32_t tmpfs_lookup(const uint8_t* name){
+    int32_t i;
+    for(i = 0; i < TMPFS_MAX_FILES; i++){
+        if(tmpfs_files[i].in_use && !tmpfs_files[i].unlinked &&
+           strncmp((const int8_t*)name, (const int8_t*)tmpfs_files[i].file_name, MAX_FILE_NAME) == 0) return i;
+    }
+    return -1;
+}
+
+/* tmpfs_resize
+ *
+ * set the length of a file, pages past the new end go back to the pool and the
+ * rest of the last page is cleared so every byte past the end is zero
+ * Inputs: file - the file
+ *         length - the new length
+ * Outputs: 0 if successful, -1 if the file would be too large
+ * Side Effects: None
+ */
+static int32_t tmpfs_resize(tmpfs_file_t* file, uint32_t length){
+    uint32_t i;
+    if(length > TMPFS_FILE_SIZE) return -1;
+    if(length < file->length){
+        for(i = (length + PAGE_SIZE - 1) / PAGE_SIZE; i < TMPFS_FILE_PAGES; i++){
+            if(file->pages[i] == NULL) continue;
+            kpage_free(file->pages[i]);
+            file->pages[i] = NULL;
+        }
+        if(length % PAGE_SIZE != 0 && file->pages[length / PAGE_SIZE] != NULL){
+            memset(file->pages[length / PAGE_SIZE] + length % PAGE_SIZE, 0, PAGE_SIZE - length % PAGE_SIZE);
+        }
+    }
+    file->length = length;
+    return 0;
+}
+
+/* tmpfs_put
+ *
+ * drop an open file, a file without a name goes away with its last one
+ * Inputs: file - the file
+ * Outputs: None
+ * Side Effects: the pages of a file that goes away return to the pool
+ */
+static void tmpfs_put(tmpfs_file_t* file){
+    if(file->opens > 0) file->opens--;
+    if(file->opens == 0 && file->unlinked){
+        tmpfs_resize(file, 0);
+        file->in_use = 0;
+    }
+}
+
+/* tmpfs_read_at
+ *
+ * copy up to nbytes of a file from offset, holes read as zeros
+ * Inputs: file - the file
+ *         offset - the position to read from
+ *         buf - the buffer to fill
+ *         nbytes - the number of bytes wanted
+ * Outputs: the number of bytes read, 0 at or past the end
+ * Side Effects: change buf
+ */
+static int32_t tmpfs_read_at(tmpfs_file_t* file, uint32_t offset, uint8_t* buf, uint32_t nbytes){
+    uint32_t done = 0;
+    uint32_t chunk;
+    uint8_t* page;
+    if(offset >= file->length) return 0;
+    if(nbytes > file->length - offset) nbytes = file->length - offset;
+    while(done < nbytes){
+        chunk = PAGE_SIZE - offset % PAGE_SIZE;
+        if(chunk > nbytes - done) chunk = nbytes - done;
+        page = file->pages[offset / PAGE_SIZE];
+        if(page == NULL){
+            memset(buf + done, 0, chunk);
+        } else {
+            memcpy(buf + done, page + offset % PAGE_SIZE, chunk);
+        }
+        done += chunk;
+        offset += chunk;
+    }
+    return done;
+}
+
+/* tmpfs_write_at
+ *
+ * copy nbytes into a file at offset, taking the missing pages from the pool
+ * Inputs: file - the file
+ *         offset - the position to write at
+ *         buf - the bytes to write
+ *         nbytes - the number of bytes
+ * Outputs: the number of bytes written, short if the pool runs out, -1 if nothing could be written
+ * Side Effects: the file grows if the write goes past its end
+ */
+static int32_t tmpfs_write_at(tmpfs_file_t* file, uint32_t offset, const uint8_t* buf, uint32_t nbytes){
+    uint32_t done = 0;
+    uint32_t chunk;
+    uint8_t** page;
+    if(nbytes == 0) return 0;
+    if(offset >= TMPFS_FILE_SIZE || nbytes > TMPFS_FILE_SIZE - offset) return -1;
+    while(done < nbytes){
+        chunk = PAGE_SIZE - offset % PAGE_SIZE;
+        if(chunk > nbytes - done) chunk = nbytes - done;
+        page = &(file->pages[offset / PAGE_SIZE]);
+        if(*page == NULL){
+            *page = kpage_alloc();
+            if(*page == NULL) break;
+        }
+        memcpy(*page + offset % PAGE_SIZE, buf + done, chunk);
+        done += chunk;
+        offset += chunk;
+    }
+    if(offset > file->length) file->length = offset;
+    return (done > 0) ? (int32_t)done : -1;
+}
+
+/* tmpfs_fill_stat
+ *
+ * fill the information of a file or of the mount point
+ * Inputs: index - the file, -1 for the mount point
+ *         st - filled with the information
+ * Outputs: None
+ * Side Effects: None
+ */
+static void tmpfs_fill_stat(int32_t index, stat_t* st){
+    int32_t i;
+    st->flags = 0;
+    if(index == -1){
+        st->file_type = DIR_FILE_TYPE;
+        st->inode_index = 0;
+        st->length = 0;
+        for(i = 0; i < TMPFS_MAX_FILES; i++){
+            if(tmpfs_files[i].in_use && !tmpfs_files[i].unlinked) st->length += DIR_ENTRY_SIZE;
+        }
+        return;
+    }
+    st->file_type = REGULAR_FILE_TYPE;
+    st->inode_index = index;
+    st->length = tmpfs_files[index].length;
+}
+
+/* tmpfs_file
+ *
+ * get the file behind an fd
+ * Inputs: fd - the fd
+ * Outputs: the file, NULL if fd is not an open tmpfs file
+ * Side Effects: None
+ */
+static tmpfs_file_t* tmpfs_file(int32_t fd){
+    file_descriptor_t* cur_fd = fd_get(fd);
+    if(cur_fd == NULL || cur_fd->operation_table != &tmpfs_operation_table) return NULL;
+    return &(tmpfs_files[cur_fd->inode_index]);
+}
+
+/* tmpfs_owns
+ *
+ * check if an fd is an open tmpfs file or the open mount point
+ * Inputs: fd - the fd
+ * Outputs: 1 if it is, 0 if not
+ * Side Effects: None
+ */
+int32_t tmpfs_owns(int32_t fd){
+    file_descriptor_t* cur_fd = fd_get(fd);
+    if(cur_fd == NULL) return 0;
+    return cur_fd->operation_table == &tmpfs_operation_table || cur_fd->operation_table == &tmpfs_dir_operation_table;
+}
+
+/* tmpfs_create
+ *
+ * add an empty file
+ * Inputs: path - the path of the new file
+ * Outputs: 0 if successful, -1 if the name is invalid or taken, or every file is in use
+ * Side Effects: None
+ */
+int32_t tmpfs_create(const uint8_t* path){
+    uint8_t name[MAX_FILE_NAME + 1];
+    int32_t i;
+    if(!tmpfs_path(path) || tmpfs_name(path, name) == -1 || name[0] == '\0') return -1;
+    if(tmpfs_lookup(name) != -1) return -1;
+    for(i = 0; i < TMPFS_MAX_FILES; i++){
+        if(tmpfs_files[i].in_use) continue;
+        memset(&(tmpfs_files[i]), 0, sizeof(tmpfs_file_t));
+        strncpy((int8_t*)tmpfs_files[i].file_name, (const int8_t*)name, MAX_FILE_NAME);
+        tmpfs_files[i].in_use = 1;
+        return 0;
+    }
+    return -1;
+}
+
+/* tmpfs_unlink
+ *
+ * remove the name of a file, its pages go back to the pool once it is no longer open
+ * Inputs: path - the path of the file
+ * Outputs: 0 if successful, -1 if there is no such file
+ * Side Effects: None
+ */
+int32_t tmpfs_unlink(const uint8_t* path){
+    uint8_t name[MAX_FILE_NAME + 1];
+    int32_t index;
+    if(!tmpfs_path(path) || tmpfs_name(path, name) == -1 || name[0] == '\0') return -1;
+    index = tmpfs_lookup(name);
+    if(index == -1) return -1;
+    tmpfs_files[index].unlinked = 1;
+    if(tmpfs_files[index].opens == 0){
+        tmpfs_resize(&(tmpfs_files[index]), 0);
+        tmpfs_files[index].in_use = 0;
+    }
+    return 0;
+}
+
+/* tmpfs_stat
+ *
+ * get the information of a file or the mount point by path
+ * Inputs: path - the path
+ *         st - filled with the information
+ * Outputs: 0 if successful, -1 if there is no such file
+ * Side Effects: None
+ */
+int32_t tmpfs_stat(const uint8_t* path, stat_t* st){
+    uint8_t name[MAX_FILE_NAME + 1];
+    int32_t index = -1;
+    if(st == NULL || !tmpfs_path(path) || tmpfs_name(path, name) == -1) return -1;
+    if(name[0] != '\0'){
+        index = tmpfs_lookup(name);
+        if(index == -1) return -1;
+    }
+    tmpfs_fill_stat(index, st);
+    return 0;
+}
+
+/* tmpfs_open
+ *
+ * open a file, or the mount point as a directory
+ * Inputs: path - the path
+ * Outputs: the fd, -1 if there is no such file or every fd is in use
+ * Side Effects: None
+ */
+int32_t tmpfs_open(const uint8_t* path){
+    uint8_t name[MAX_FILE_NAME + 1];
+    int32_t index;
+    int32_t fd;
+    if(!tmpfs_path(path) || tmpfs_name(path, name) == -1) return -1;
+    if(name[0] == '\0') return fd_alloc(&tmpfs_dir_operation_table, 0);
+
+    index = tmpfs_lookup(name);
+    if(index == -1) return -1;
+    fd = fd_alloc(&tmpfs_operation_table, index);
+    if(fd != -1) tmpfs_files[index].opens++;
+    return fd;
+}
+
+/* tmpfs_close
+ *
+ * close a file or the mount point
+ * Inputs: fd - the fd
+ * Outputs: 0 if successful, -1 if fd is not tmpfs
+ * Side Effects: the file is dropped with its last fd
+ */
+int32_t tmpfs_close(int32_t fd){
+    file_descriptor_t* cur_fd = fd_get(fd);
+    uint32_t index;
+    int32_t left;
+    if(!tmpfs_owns(fd)) return -1;
+    index = cur_fd->inode_index;
+    if(cur_fd->operation_table == &tmpfs_dir_operation_table) return (fd_close(fd) == -1) ? -1 : 0;
+
+    left = fd_close(fd);
+    if(left == -1) return -1;
+    if(left == 0) tmpfs_put(&(tmpfs_files[index]));
+    return 0;
+}
+
+/* tmpfs_read
+ *
+ * read a file at its file_position
+ * Inputs: fd - the fd
+ *         buf - the buffer to fill
+ *         nbytes - the number of bytes wanted
+ * Outputs: the number of bytes read, 0 at the end, -1 if fails
+ * Side Effects: advance the file_position
+ */
+int32_t tmpfs_read(int32_t fd, void* buf, int32_t nbytes){
+    tmpfs_file_t* file = tmpfs_file(fd);
+    int32_t bytes_read;
+    if(file == NULL || buf == NULL || nbytes < 0) return -1;
+    bytes_read = tmpfs_read_at(file, fd_get(fd)->file_position, buf, nbytes);
+    fd_get(fd)->file_position += bytes_read;
+    return bytes_read;
+}
+
+/* tmpfs_write
+ *
+ * write a file at its file_position
+ * Inputs: fd - the fd
+ *         buf - the bytes to write
+ *         nbytes - the number of bytes
+ * Outputs: the number of bytes written, -1 if fails
+ * Side Effects: advance the file_position, the file grows if the write goes past its end
+ */
+int32_t tmpfs_write(int32_t fd, const void* buf, int32_t nbytes){
+    tmpfs_file_t* file = tmpfs_file(fd);
+    int32_t bytes_written;
+    if(file == NULL || buf == NULL || nbytes < 0) return -1;
+    bytes_written = tmpfs_write_at(file, fd_get(fd)->file_position, buf, nbytes);
+    if(bytes_written == -1) return -1;
+    fd_get(fd)->file_position += bytes_written;
+    return bytes_written;
+}
+
+/* tmpfs_dir_read
+ *
+ * read the name of the next file of the mount point
+ * Inputs: fd - the fd of the mount point
+ *         buf - filled with the name, not terminated when MAX_FILE_NAME bytes long
+ *         nbytes - the size of buf
+ * Outputs: the number of bytes filled, 0 after the last file, -1 if fails
+ * Side Effects: advance the file_position, which counts file slots
+ */
+int32_t tmpfs_dir_read(int32_t fd, void* buf, int32_t nbytes){
+    file_descriptor_t* cur_fd = fd_get(fd);
+    tmpfs_file_t* file;
+    int32_t len;
+    if(cur_fd == NULL || cur_fd->operation_table != &tmpfs_dir_operation_table || buf == NULL || nbytes < 0) return -1;
+    while(cur_fd->file_position < TMPFS_MAX_FILES){
+        file = &(tmpfs_files[cur_fd->file_position++]);
+        if(!file->in_use || file->unlinked) continue;
+        for(len = 0; len < MAX_FILE_NAME && len < nbytes && file->file_name[len] != '\0'; len++);
+        memcpy(buf, file->file_name, len);
+        return len;
+    }
+    return 0;
+}
+
+/* tmpfs_dir_write
+ *
+ * the mount point cannot be written
+ * Inputs: fd - the fd, buf - ignored, nbytes - ignored
+ * Outputs: -1
+ * Side Effects: None
+ */
+int32_t tmpfs_dir_write(int32_t fd, const void* buf, int32_t nbytes){
+    return -1;
+}
+
+/* tmpfs_getdents
+ *
+ * fill a buffer with as many files of the mount point as fit
+ * Inputs: fd - the fd of the mount point
+ *         buf - the records to fill
+ *         nbytes - the size of buf in bytes
+ * Outputs: the number of bytes filled, 0 after the last file, -1 if fails
+ * Side Effects: advance the file_position
+ */
+int32_t tmpfs_getdents(int32_t fd, dirent_t* buf, int32_t nbytes){
+    file_descriptor_t* cur_fd = fd_get(fd);
+    tmpfs_file_t* file;
+    int32_t i = 0;
+    if(cur_fd == NULL || cur_fd->operation_table != &tmpfs_dir_operation_table || buf == NULL) return -1;
+    if(nbytes < (int32_t)sizeof(dirent_t)) return -1;
+    while(cur_fd->file_position < TMPFS_MAX_FILES && (i + 1) * (int32_t)sizeof(dirent_t) <= nbytes){
+        file = &(tmpfs_files[cur_fd->file_position]);
+        if(file->in_use && !file->unlinked){
+            memcpy(buf[i].file_name, file->file_name, MAX_FILE_NAME);
+            buf[i].file_type = REGULAR_FILE_TYPE;
+            buf[i].inode_index = cur_fd->file_position;
+            buf[i].length = file->length;
+            i++;
+        }
+        cur_fd->file_position++;
+    }
+    return i * sizeof(dirent_t);
+}
+
+/* tmpfs_lseek
+ *
+ * move the position of an open file, or of the mount point counted in file slots
+ * Inputs: fd - the fd
+ *         offset - the signed distance to move
+ *         whence - SEEK_SET, SEEK_CUR or SEEK_END
+ * Outputs: the new position, -1 if fails
+ * Side Effects: change the file_position
+ */
+int32_t tmpfs_lseek(int32_t fd, int32_t offset, int32_t whence){
+    file_descriptor_t* cur_fd = fd_get(fd);
+    int32_t base;
+    if(!tmpfs_owns(fd)) return -1;
+    switch(whence){
+        case SEEK_SET:
+            base = 0;
+            break;
+        case SEEK_CUR:
+            base = cur_fd->file_position;
+            break;
+        case SEEK_END:
+            base = (cur_fd->operation_table == &tmpfs_operation_table) ? tmpfs_files[cur_fd->inode_index].length : TMPFS_MAX_FILES;
+            break;
+        default:
+            return -1;
+    }
+    if((offset < 0 && base + offset < 0) || (offset > 0 && base + offset < base)) return -1;
+    cur_fd->file_position = base + offset;
+    return cur_fd->file_position;
+}
+
+/* tmpfs_pread
+ *
+ * read an open file at offset, the file_position is not used nor changed
+ * Inputs: fd - the fd
+ *         buf - the buffer to fill
+ *         nbytes - the number of bytes wanted
+ *         offset - the position to read from
+ * Outputs: the number of bytes read, 0 at or past the end, -1 if fails
+ * Side Effects: change buf
+ */
+int32_t tmpfs_pread(int32_t fd, void* buf, int32_t nbytes, uint32_t offset){
+    tmpfs_file_t* file = tmpfs_file(fd);
+    if(file == NULL || buf == NULL || nbytes < 0) return -1;
+    return tmpfs_read_at(file, offset, buf, nbytes);
+}
+
+/* tmpfs_pwrite
+ *
+ * write an open file at offset, the file_position is not used nor changed
+ * Inputs: fd - the fd
+ *         buf - the bytes to write
+ *         nbytes - the number of bytes
+ *         offset - the position to write at
+ * Outputs: the number of bytes written, -1 if fails
+ * Side Effects: the file grows if the write goes past its end
+ */
+int32_t tmpfs_pwrite(int32_t fd, const void* buf, int32_t nbytes, uint32_t offset){
+    tmpfs_file_t* file = tmpfs_file(fd);
+    if(file == NULL || buf == NULL || nbytes < 0) return -1;
+    return tmpfs_write_at(file, offset, buf, nbytes);
+}
+
+/* tmpfs_truncate
+ *
+ * set the length of an open file
+ * Inputs: fd - the fd
+ *         length - the new length
+ * Outputs: 0 if successful, -1 if fd is not a tmpfs file or the file would be too large
+ * Side Effects: pages past the new end go back to the pool
+ */
+int32_t tmpfs_truncate(int32_t fd, uint32_t length){
+    tmpfs_file_t* file = tmpfs_file(fd);
+    if(file == NULL) return -1;
+    return tmpfs_resize(file, length);
+}
+
+/* tmpfs_fstat
+ *
+ * get the information of an open file or the mount point
+ * Inputs: fd - the fd
+ *         st - filled with the information
+ * Outputs: 0 if successful, -1 if fd is not tmpfs
+ * Side Effects: None
+ */
+int32_t tmpfs_fstat(int32_t fd, stat_t* st){
+    file_descriptor_t* cur_fd = fd_get(fd);
+    if(st == NULL || !tmpfs_owns(fd)) return -1;
+    tmpfs_fill_stat((cur_fd->operation_table == &tmpfs_operation_table) ? (int32_t)cur_fd->inode_index : -1, st);
+    return 0;
+}
@@ -0,0 +1,58 @@
+/* tmpfs.h - Defines the RAM-backed file system mounted at /tmp
+ * vim:ts=4 noexpandtab
+ */
+
+#ifndef _TMPFS_H
+#define _TMPFS_H
+
+#include "types.h"
+#include "filesys.h"
+#include "paging.h"
+
+#define TMPFS_MOUNT "/tmp"          // absolute paths under it are tmpfs files, it holds no directories
+#define TMPFS_MOUNT_LEN 4
+#define TMPFS_MAX_FILES 32          // files that can exist at once
+#define TMPFS_FILE_PAGES 256        // pages one file can own, 1 MB
+#define TMPFS_FILE_SIZE (TMPFS_FILE_PAGES * PAGE_SIZE)
+
+typedef struct tmpfs_file {
+    uint8_t file_name[MAX_FILE_NAME];
+    uint32_t in_use;
+    uint32_t unlinked;              // no longer has a name, goes away with its last open file
+    uint32_t opens;                 // open files, each may be shared by several fds
+    uint32_t length;
+    uint8_t* pages[TMPFS_FILE_PAGES];   // kernel pages, NULL for a hole that reads as zeros
+} tmpfs_file_t;
+
+/* set up the empty file system */
+void tmpfs_init(void);
+
+/* check if a path or an fd belongs to tmpfs */
+int32_t tmpfs_path(const uint8_t* path);
+int32_t tmpfs_owns(int32_t fd);
+
+/* path operations */
+int32_t tmpfs_create(const uint8_t* path);
+int32_t tmpfs_unlink(const uint8_t* path);
+int32_t tmpfs_stat(const uint8_t* path, stat_t* st);
+
+/* fd operations */
+int32_t tmpfs_lseek(int32_t fd, int32_t offset, int32_t whence);
+int32_t tmpfs_pread(int32_t fd, void* buf, int32_t nbytes, uint32_t offset);
+int32_t tmpfs_pwrite(int32_t fd, const void* buf, int32_t nbytes, uint32_t offset);
+int32_t tmpfs_truncate(int32_t fd, uint32_t length);
+int32_t tmpfs_fstat(int32_t fd, stat_t* st);
+int32_t tmpfs_getdents(int32_t fd, dirent_t* buf, int32_t nbytes);
+
+/* operations of the jump tables, open gives a file or the mount directory */
+int32_t tmpfs_open(const uint8_t* path);
+int32_t tmpfs_close(int32_t fd);
+int32_t tmpfs_read(int32_t fd, void* buf, int32_t nbytes);
+int32_t tmpfs_write(int32_t fd, const void* buf, int32_t nbytes);
+int32_t tmpfs_dir_read(int32_t fd, void* buf, int32_t nbytes);
+int32_t tmpfs_dir_write(int32_t fd, const void* buf, int32_t nbytes);
+
+extern operation_table_t tmpfs_operation_table;
+extern operation_table_t tmpfs_dir_operation_table;
+
+#endif /* _TMPFS_H */
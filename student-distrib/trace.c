@@ -0,0 +1,163 @@
+/* trace.c - Opt-in tracer of system calls, a ring of the newest calls of each traced
+ * process and a log2 histogram of the cycles each call number takes
+ * vim:ts=4 noexpandtab
+ */
+
+#include "trace.h"
+#include "pcb.h"
+#include "kpage.h"
+#include "lib.h"
+#include "devices/vt.h"
+
+#define TRACE_SYS_HALT 1                // halt does not come back, it is recorded on the way in
+#define TRACE_CYCLES_MAX 0xFFFFFFFF
+
+/* the table of idtentry.S, the entries take fewer arguments but the caller pops them */
+extern int32_t (*syscall_table[])(uint32_t, uint32_t, uint32_t, uint32_t);
+
+volatile uint32_t trace_active = 0;
+static uint32_t trace_hist[TRACE_SYSCALLS][TRACE_BUCKETS];
+
+/* trace_record
+ *
+ * append a call to a ring, writing over the oldest one once it is full
+ * Inputs: ring - the ring
+ *         num - the call number
+ *         args - its arguments
+ *         ret - what it returned
+ *         cycles - how long it took
+ * Outputs: None
+ * Side Effects: None
+ */
+static void trace_record(trace_ring_t* ring, uint32_t num, const uint32_t* args, int32_t ret, uint32_t cycles){
+    trace_entry_t* entry = &(ring->entries[ring->total % TRACE_ENTRIES]);
+    entry->num = num;
+    memcpy(entry->args, args, sizeof(entry->args));
+    entry->ret = ret;
+    entry->cycles = cycles;
+    ring->total++;
+}
+
+/* trace_dispatch
+ *
+ * run a system call for the syscall entries while some process is traced, timed with the
+ * TSC and recorded if the current process is one of them. The arguments are the frame the
+ * entry already pushed for the call, so the number is pushed on top of it
+ * Inputs: num - the call number, already checked against the table
+ *         arg1, arg2, arg3, arg4 - its arguments
+ * Outputs: what the call returns
+ * Side Effects: None
+ */
+int32_t trace_dispatch(uint32_t num, uint32_t arg1, uint32_t arg2, uint32_t arg3, uint32_t arg4){
+    trace_ring_t* ring = get_current_pcb()->trace;
+    uint32_t args[TRACE_ARGS] = {arg1, arg2, arg3, arg4};
+    uint32_t start_low, start_high, end_low, end_high, cycles;
+    int32_t ret;
+
+    if(ring == NULL) return syscall_table[num](arg1, arg2, arg3, arg4);
+    if(num == TRACE_SYS_HALT){
+        trace_record(ring, num, args, (uint8_t)arg1, 0);
+        return syscall_table[num](arg1, arg2, arg3, arg4);
+    }
+
+    rdtsc(start_low, start_high);
+    ret = syscall_table[num](arg1, arg2, arg3, arg4);
+    rdtsc(end_low, end_high);
+
+    /* the difference of the low words is right until it takes 2^32 cycles */
+    cycles = end_low - start_low;
+    if(end_high - start_high > 1 || (end_high != start_high && end_low >= start_low)) cycles = TRACE_CYCLES_MAX;
+    trace_record(ring, num, args, ret, cycles);
+    trace_hist[num][cycles ? bsr(cycles) : 0]++;
+    return ret;
+}
+
+/* trace_exec
+ *
+ * give a process just created a ring if its parent turned tracing on
+ * Inputs: pid - the new process, its pcb already points to its parent
+ * Outputs: None
+ * Side Effects: the process runs untraced if no kernel page is left
+ */
+void trace_exec(uint32_t pid){
+    pcb_t* pcb = get_pcb_by_pid(pid);
+    uint32_t flags;
+    if(pid < NUM_TERMS || !pcb->parent_pcb->trace_children) return;
+    pcb->trace = kpage_alloc();
+    if(pcb->trace == NULL) return;
+    cli_and_save(flags);
+    trace_active++;
+    restore_flags(flags);
+}
+
+/* trace_halt
+ *
+ * hand the ring of a halting process to its parent, in place of the one it held,
+ * and drop the ring the halting process got from its own children
+ * Inputs: pid - the halting process
+ * Outputs: None
+ * Side Effects: None
+ */
+void trace_halt(uint32_t pid){
+    pcb_t* pcb = get_pcb_by_pid(pid);
+    pcb_t* parent_pcb;
+    uint32_t flags;
+
+    if(pcb->trace_done != NULL) kpage_free(pcb->trace_done);
+    pcb->trace_done = NULL;
+    if(pcb->trace == NULL) return;
+
+    cli_and_save(flags);
+    trace_active--;
+    restore_flags(flags);
+    if(pid < NUM_TERMS){
+        kpage_free(pcb->trace);
+    } else {
+        parent_pcb = pcb->parent_pcb;
+        if(parent_pcb->trace_done != NULL) kpage_free(parent_pcb->trace_done);
+        parent_pcb->trace_done = pcb->trace;
+    }
+    pcb->trace = NULL;
+}
+
+/* trace_ctl
+ *
+ * turn tracing of the programs the current process starts on or off, or copy out what was traced
+ * Inputs: cmd - TRACE_OFF, TRACE_ON, TRACE_READ or TRACE_HIST
+ *         buf - filled by TRACE_READ and TRACE_HIST, unused otherwise
+ *         nbytes - the size of buf
+ * Outputs: the bytes copied for TRACE_READ and TRACE_HIST, 0 for the others,
+ *          -1 if cmd or buf is invalid or TRACE_READ finds no traced program that halted
+ * Side Effects: None
+ */
+int32_t trace_ctl(int32_t cmd, void* buf, int32_t nbytes){
+    pcb_t* pcb = get_current_pcb();
+    trace_ring_t* ring = pcb->trace_done;
+    uint32_t first, count, i;
+
+    if((cmd == TRACE_READ || cmd == TRACE_HIST) && (buf == NULL || nbytes < 0)) return -1;
+    switch(cmd){
+        case TRACE_OFF:
+            pcb->trace_children = 0;
+            return 0;
+        case TRACE_ON:
+            pcb->trace_children = 1;
+            memset(trace_hist, 0, sizeof(trace_hist));
+            return 0;
+        case TRACE_READ:
+            if(ring == NULL) return -1;
+            count = (ring->total < TRACE_ENTRIES) ? ring->total : TRACE_ENTRIES;
+            if(count > nbytes / sizeof(trace_entry_t)) count = nbytes / sizeof(trace_entry_t);
+            first = ring->total - ((ring->total < TRACE_ENTRIES) ? ring->total : TRACE_ENTRIES);
+            for(i = 0; i < count; i++){
+                memcpy((trace_entry_t*)buf + i, &(ring->entries[(first + i) % TRACE_ENTRIES]), sizeof(trace_entry_t));
+            }
+            return count * sizeof(trace_entry_t);
+        case TRACE_HIST:
+            if((uint32_t)nbytes > sizeof(trace_hist)) nbytes = sizeof(trace_hist);
+            memcpy(buf, trace_hist, nbytes);
+            return nbytes;
+        default:
+            return -1;
+    }
+}
@@ -0,0 +1,47 @@
+/* trace.h - Defines the tracer of system calls and their latency histograms
+ * vim:ts=4 noexpandtab
+ */
+
+#ifndef _TRACE_H
+#define _TRACE_H
+
+#include "types.h"
+
+#define TRACE_ENTRIES 128               // newest calls kept for one process
+#define TRACE_SYSCALLS 40               // numbers with a histogram, above the highest in syscall_table
+#define TRACE_BUCKETS 32                // bucket i counts calls of 2^i up to 2^(i+1)-1 cycles
+#define TRACE_ARGS 4
+
+/* commands of the trace system call */
+#define TRACE_OFF 0                     // programs started afterwards are not traced
+#define TRACE_ON 1                      // programs started afterwards are traced, the histograms start over
+#define TRACE_READ 2                    // copy the calls of the last traced program that halted, oldest first
+#define TRACE_HIST 3                    // copy the histograms, TRACE_SYSCALLS rows of TRACE_BUCKETS counts
+
+typedef struct trace_entry {
+    uint32_t num;
+    uint32_t args[TRACE_ARGS];
+    int32_t ret;                        // the status for halt, which does not come back
+    uint32_t cycles;                    // TSC cycles from the call to the return, 0 for halt
+} trace_entry_t;
+
+/* held in a kernel page while its process runs, handed to the parent when it halts */
+typedef struct trace_ring {
+    uint32_t total;                     // calls recorded, the entry of call i is entries[i % TRACE_ENTRIES]
+    trace_entry_t entries[TRACE_ENTRIES];
+} trace_ring_t;
+
+/* number of traced processes, the syscall entries skip the tracer while it is 0 */
+extern volatile uint32_t trace_active;
+
+/* run a system call of a traced process and record it */
+int32_t trace_dispatch(uint32_t num, uint32_t arg1, uint32_t arg2, uint32_t arg3, uint32_t arg4);
+
+/* give a new process a ring if its parent asked for it, and hand it back when it halts */
+void trace_exec(uint32_t pid);
+void trace_halt(uint32_t pid);
+
+/* the trace system call */
+int32_t trace_ctl(int32_t cmd, void* buf, int32_t nbytes);
+
+#endif /* _TRACE_H */
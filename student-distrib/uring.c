@@ -0,0 +1,85 @@
+/* uring.c - Submission and completion rings, so one trap runs a batch of system calls
+ * vim:ts=4 noexpandtab
+ */
+
+#include "uring.h"
+#include "pcb.h"
+#include "syscall_task.h"
+
+/* uring_run
+ *
+ * run queued submission entries in order and post a completion for each, stopping early
+ * when the completion ring is full so no result is lost
+ * Inputs: ring - the rings
+ *         to_submit - the most entries to run, 0 for every queued one
+ * Outputs: the number of entries run, -1 if the indices of the ring are broken
+ * Side Effects: advance sq_head and cq_tail
+ */
+int32_t uring_run(uring_t* ring, uint32_t to_submit){
+    uint32_t head = ring->sq_head;
+    uint32_t tail = ring->sq_tail;
+    uint32_t cq_tail = ring->cq_tail;
+    uint32_t done = 0;
+    uring_sqe_t* sqe;
+    int32_t res;
+
+    if(tail - head > URING_ENTRIES || cq_tail - ring->cq_head > URING_ENTRIES) return -1;
+    while(head != tail && (to_submit == 0 || done < to_submit) && cq_tail - ring->cq_head < URING_ENTRIES){
+        sqe = &(ring->sq[head & URING_MASK]);
+        switch(sqe->opcode){
+            case URING_OP_READ:
+                res = __syscall_read(sqe->fd, sqe->buf, sqe->len);
+                break;
+            case URING_OP_WRITE:
+                res = __syscall_write(sqe->fd, sqe->buf, sqe->len);
+                break;
+            case URING_OP_OPEN:
+                res = __syscall_open((const uint8_t*)sqe->buf);
+                break;
+            case URING_OP_CLOSE:
+                res = __syscall_close(sqe->fd);
+                break;
+            default:
+                res = -1;
+        }
+        ring->cq[cq_tail & URING_MASK].user_data = sqe->user_data;
+        ring->cq[cq_tail & URING_MASK].res = res;
+        cq_tail++;
+        head++;
+        done++;
+        /* publish each entry at once, a later one may block */
+        ring->cq_tail = cq_tail;
+        ring->sq_head = head;
+    }
+    return done;
+}
+
+/* uring_setup
+ *
+ * register a ring of the current process, emptied, it stays registered until the process halts
+ * Inputs: ring - the rings, must lie in the user page
+ * Outputs: 0 if successful, -1 if the ring is outside the user page
+ * Side Effects: None
+ */
+int32_t uring_setup(uring_t* ring){
+    if((uint32_t)ring < _128_MB || (uint32_t)ring + sizeof(uring_t) > _128_MB + FOUR_MB) return -1;
+    ring->sq_head = 0;
+    ring->sq_tail = 0;
+    ring->cq_head = 0;
+    ring->cq_tail = 0;
+    get_current_pcb()->uring = ring;
+    return 0;
+}
+
+/* uring_enter
+ *
+ * run the registered ring of the current process
+ * Inputs: to_submit - the most entries to run, 0 for every queued one
+ * Outputs: the number of entries run, -1 if no ring is registered or it is broken
+ * Side Effects: None
+ */
+int32_t uring_enter(uint32_t to_submit){
+    uring_t* ring = get_current_pcb()->uring;
+    if(ring == NULL) return -1;
+    return uring_run(ring, to_submit);
+}
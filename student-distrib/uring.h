@@ -0,0 +1,50 @@
+/* uring.h - Defines the submission and completion rings of batched system calls
+ * vim:ts=4 noexpandtab
+ */
+
+#ifndef _URING_H
+#define _URING_H
+
+#include "types.h"
+
+#define URING_ENTRIES 128               // slots of each ring, a power of 2
+#define URING_MASK (URING_ENTRIES - 1)
+
+/* operations of a submission entry */
+#define URING_OP_READ 0
+#define URING_OP_WRITE 1
+#define URING_OP_OPEN 2                 // buf is the file name, fd and len are unused
+#define URING_OP_CLOSE 3                // buf and len are unused
+
+typedef struct uring_sqe {
+    uint32_t opcode;
+    int32_t fd;
+    void* buf;
+    int32_t len;
+    uint32_t user_data;                 // copied to the completion, the kernel does not look at it
+} uring_sqe_t;
+
+typedef struct uring_cqe {
+    uint32_t user_data;
+    int32_t res;                        // what the system call would have returned
+} uring_cqe_t;
+
+/* lives in user memory, the program moves sq_tail and cq_head, the kernel sq_head and cq_tail,
+ * each index only grows and is taken modulo URING_ENTRIES */
+typedef struct uring {
+    volatile uint32_t sq_head;
+    volatile uint32_t sq_tail;
+    volatile uint32_t cq_head;
+    volatile uint32_t cq_tail;
+    uring_sqe_t sq[URING_ENTRIES];
+    uring_cqe_t cq[URING_ENTRIES];
+} uring_t;
+
+/* run the queued entries of a ring, at most to_submit of them, 0 for all */
+int32_t uring_run(uring_t* ring, uint32_t to_submit);
+
+/* register the ring of the current process and run it */
+int32_t uring_setup(uring_t* ring);
+int32_t uring_enter(uint32_t to_submit);
+
+#endif /* _URING_H */
@@ -0,0 +1,86 @@
+/* vdso.c - A page of kernel data mapped read-only into every program, so reading the
+ * time takes no system call
+ * vim:ts=4 noexpandtab
+ */
+
+#include "vdso.h"
+#include "lib.h"
+#include "signal.h"
+
+/* a whole page of the kernel image, the identity mapping gives its physical address */
+static union {
+    vdso_data_t data;
+    uint8_t page[PAGE_SIZE];
+} vdso __attribute__((aligned(PAGE_SIZE)));
+
+/* the code signal handlers return to, one copy shared by every program */
+static uint8_t sigtramp[PAGE_SIZE] __attribute__((aligned(PAGE_SIZE)));
+
+/* vdso_init
+ *
+ * map the page read-only for user programs at VDSO_ADDR, in the page table of the vidmap,
+ * and next to it a copy of EXECUTE_SIGRETURN at SIGTRAMP_ADDR
+ * Inputs: None
+ * Outputs: None
+ * Side Effects: flush the TLB
+ */
+void vdso_init(void){
+    int32_t index = VDSO_ADDR >> 22;
+    memset(&vdso, 0, sizeof(vdso));
+    vdso.data.hz = VDSO_HZ;
+    memcpy(sigtramp, EXECUTE_SIGRETURN, EXECUTE_SIGRETURN_END - EXECUTE_SIGRETURN);
+
+    page_directory[index].P = 1;
+    page_directory[index].PS = 0;
+    page_directory[index].US = 1;
+    page_directory[index].ADDR = ((uint32_t)vidmap_table) >> 12;
+
+    vidmap_table[VDSO_PTE].P = 1;
+    vidmap_table[VDSO_PTE].RW = 0;
+    vidmap_table[VDSO_PTE].US = 1;
+    vidmap_table[VDSO_PTE].ADDR = ((uint32_t)&vdso) >> 12;
+
+    vidmap_table[SIGTRAMP_PTE].P = 1;
+    vidmap_table[SIGTRAMP_PTE].RW = 0;
+    vidmap_table[SIGTRAMP_PTE].US = 1;
+    vidmap_table[SIGTRAMP_PTE].ADDR = ((uint32_t)sigtramp) >> 12;
+
+    asm volatile (
+        "movl %%cr3, %%eax;"
+        "movl %%eax, %%cr3;"
+        : : : "eax", "memory"
+    );
+}
+
+/* vdso_tick
+ *
+ * publish the monotonic tick count
+ * Inputs: ticks - PIT interrupts since boot
+ * Outputs: None
+ * Side Effects: None
+ */
+void vdso_tick(uint32_t ticks){
+    vdso.data.ticks = ticks;
+}
+
+/* vdso_set_date
+ *
+ * publish a new date, odd seq tells readers it is being written
+ * Inputs: the fields of the date
+ * Outputs: None
+ * Side Effects: None
+ */
+void vdso_set_date(int32_t sec, int32_t min, int32_t hour, int32_t day, int32_t month, int32_t year){
+    uint32_t flags;
+    /* one writer at a time, the RTC handler or the date system call */
+    cli_and_save(flags);
+    vdso.data.seq++;
+    vdso.data.sec = sec;
+    vdso.data.min = min;
+    vdso.data.hour = hour;
+    vdso.data.day = day;
+    vdso.data.month = month;
+    vdso.data.year = year;
+    vdso.data.seq++;
+    restore_flags(flags);
+}
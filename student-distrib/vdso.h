@@ -0,0 +1,36 @@
+/* vdso.h - Defines the page of kernel data every program can read without a system call
+ * vim:ts=4 noexpandtab
+ */
+
+#ifndef _VDSO_H
+#define _VDSO_H
+
+#include "types.h"
+#include "paging.h"
+
+#define VDSO_PTE 1                  // in vidmap_table, the page after the vidmap page
+#define SIGTRAMP_PTE 2              // in vidmap_table, the page after the vdso page
+#define VDSO_HZ 100                 // ticks per second, the PIT rate
+
+/* the date fields change together, so they are read under seq: it is odd while they are
+ * written and a reader that saw it change reads them again, ticks is a single store */
+typedef struct vdso_data {
+    volatile uint32_t seq;
+    volatile uint32_t ticks;        // PIT interrupts since boot
+    volatile uint32_t hz;
+    volatile int32_t sec;
+    volatile int32_t min;
+    volatile int32_t hour;
+    volatile int32_t day;
+    volatile int32_t month;
+    volatile int32_t year;          // two digits, as the CMOS keeps it
+} vdso_data_t;
+
+/* map the page read-only for user programs at VDSO_ADDR, and the signal trampoline at SIGTRAMP_ADDR */
+void vdso_init(void);
+/* publish the monotonic tick count, from the PIT handler */
+void vdso_tick(uint32_t ticks);
+/* publish a new date */
+void vdso_set_date(int32_t sec, int32_t min, int32_t hour, int32_t day, int32_t month, int32_t year);
+
+#endif /* _VDSO_H */
@@ -3,8 +3,35 @@
 #include "ece391support.h"
 #include "ece391syscall.h"
 
+/* print a field with two digits */
+static void
+put2 (int32_t value)
+{
+    uint8_t buf[11];
+
+    if (value < 10)
+        ece391_fdputs (1, (uint8_t*)"0");
+    ece391_fdputs (1, ece391_itoa (value, buf, 10));
+}
+
 int main ()
 {
-    ece391_date();
+    ece391_date_t date;
+    uint8_t buf[11];
+
+    /* from the kernel page, no system call */
+    ece391_getdate (&date);
+    ece391_fdputs (1, ece391_itoa (date.month, buf, 10));
+    ece391_fdputs (1, (uint8_t*)"/");
+    ece391_fdputs (1, ece391_itoa (date.day, buf, 10));
+    ece391_fdputs (1, (uint8_t*)"/");
+    ece391_fdputs (1, ece391_itoa (date.year, buf, 10));
+    ece391_fdputs (1, (uint8_t*)" ");
+    put2 (date.hour);
+    ece391_fdputs (1, (uint8_t*)":");
+    put2 (date.min);
+    ece391_fdputs (1, (uint8_t*)":");
+    put2 (date.sec);
+    ece391_fdputs (1, (uint8_t*)"\n");
     return 0;
-}
\ No newline at end of file
+}
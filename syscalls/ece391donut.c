@@ -50,6 +50,37 @@ float cos(float x) {
     return result;
 }
 
+static ece391_uring_t ring;
+static int use_ring;
+
+/* run every queued write with one system call */
+void flush_writes() {
+    if (!use_ring) {
+        return;
+    }
+    ece391_uring_enter(0);
+    ring.cq_head = ring.cq_tail;
+}
+
+/* queue a write to the screen, buf must stay untouched until the next flush */
+void queue_write(char* buf, int len) {
+    ece391_uring_sqe_t* sqe;
+    if (!use_ring) {
+        ece391_write(1, buf, len);
+        return;
+    }
+    if (ring.sq_tail - ring.sq_head == ECE391_URING_ENTRIES) {
+        flush_writes();
+    }
+    sqe = &ring.sq[ring.sq_tail % ECE391_URING_ENTRIES];
+    sqe->opcode = ECE391_URING_WRITE;
+    sqe->fd = 1;
+    sqe->buf = buf;
+    sqe->len = len;
+    sqe->user_data = 0;
+    ring.sq_tail++;
+}
+
 int main ()
 {
     float A = 0, B = 0;
@@ -58,6 +89,8 @@ int main ()
     int k;
     float z[1760];
     char b[1760];
+    char frame[1761];
+    use_ring = (0 == ece391_uring_setup(&ring));
     ece391_ioctl(1, 1);
     ece391_fdputs(1, (uint8_t *)"\x1b[2J");
     for(;;) {
@@ -93,11 +126,12 @@ int main ()
         }
         ece391_fdputs(1, (uint8_t *)"\x1b[H");
         for(k = 0; k < 1761; k++) {
-            char ch = k % 80 ? b[k] : 10;
-            ece391_write(1, &ch, 1);
+            frame[k] = k % 80 ? b[k] : 10;
+            queue_write(&frame[k], 1);
             A += 0.00004;
             B += 0.00002;
         }
+        flush_writes();
     }
     ece391_ioctl(1, 0);
     return 0;
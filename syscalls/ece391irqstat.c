@@ -0,0 +1,102 @@
+#include <stdint.h>
+
+#include "ece391support.h"
+#include "ece391syscall.h"
+
+#define NUM_SIZE 12		/* a 32-bit number in decimal */
+#define ARGSIZE 16
+#define FIRST_IRQ 0x20		/* vectors below are exceptions */
+
+static ece391_irqstat_t stats[ECE391_IRQSTAT_VECTORS];
+
+/* the name of a vector, its number in hex for those with no name */
+static void
+put_vector (uint32_t vector)
+{
+    uint8_t buf[NUM_SIZE];
+
+    switch (vector) {
+        case 0x20: ece391_fdputs (1, (uint8_t*)"pit"); return;
+        case 0x21: ece391_fdputs (1, (uint8_t*)"keyboard"); return;
+        case 0x28: ece391_fdputs (1, (uint8_t*)"rtc"); return;
+        case 0x2E: ece391_fdputs (1, (uint8_t*)"ide"); return;
+    }
+    ece391_fdputs (1, (uint8_t*)((vector < FIRST_IRQ) ? "exception 0x" : "irq 0x"));
+    ece391_fdputs (1, ece391_itoa (vector, buf, 16));
+}
+
+/* high:low / d, one bit at a time, the quotient must fit in 32 bits */
+static uint32_t
+div64 (uint32_t high, uint32_t low, uint32_t d)
+{
+    uint32_t q = 0, r = 0, bit, carry;
+    int32_t i;
+
+    for (i = 63; i >= 0; i--) {
+        bit = (i >= 32) ? (high >> (i - 32)) & 1 : (low >> i) & 1;
+        carry = r >> 31;
+        r = (r << 1) | bit;
+        if (carry || r >= d) {
+            r -= d;
+            if (i < 32)
+                q |= 1 << i;
+        }
+    }
+    return q;
+}
+
+static void
+put_field (const char* name, uint32_t value)
+{
+    uint8_t buf[NUM_SIZE];
+
+    ece391_fdputs (1, (uint8_t*)name);
+    ece391_fdputs (1, ece391_itoa (value, buf, 10));
+}
+
+/* "irqstat on" starts counting over, "irqstat off" stops it, and "irqstat" prints one line
+ * per vector that ran, then "2^i:n" for every bucket in use */
+int main ()
+{
+    uint8_t buf[NUM_SIZE];
+    uint8_t arg[ARGSIZE];
+    uint32_t vector, i, shown = 0;
+    ece391_irqstat_t* stat;
+
+    if (0 == ece391_getargs (arg, ARGSIZE)) {
+        if (0 == ece391_strcmp (arg, (uint8_t*)"on"))
+            return (-1 == ece391_irqstat (ECE391_IRQSTAT_ON, 0, 0)) ? 3 : 0;
+        if (0 == ece391_strcmp (arg, (uint8_t*)"off"))
+            return (-1 == ece391_irqstat (ECE391_IRQSTAT_OFF, 0, 0)) ? 3 : 0;
+        ece391_fdputs (1, (uint8_t*)"usage: irqstat [on|off]\n");
+        return 3;
+    }
+
+    if (-1 == ece391_irqstat (ECE391_IRQSTAT_READ, stats, sizeof (stats))) {
+        ece391_fdputs (1, (uint8_t*)"could not read the counts\n");
+        return 3;
+    }
+
+    for (vector = 0; vector < ECE391_IRQSTAT_VECTORS; vector++) {
+        stat = &stats[vector];
+        if (0 == stat->count)
+            continue;
+        shown++;
+        put_vector (vector);
+        put_field (": ", stat->count);
+        put_field (" runs, avg ", div64 (stat->total_high, stat->total_low, stat->count));
+        put_field (", max ", stat->max);
+        ece391_fdputs (1, (uint8_t*)" cycles\n   ");
+        for (i = 0; i < ECE391_IRQSTAT_BUCKETS; i++) {
+            if (0 == stat->hist[i])
+                continue;
+            ece391_fdputs (1, (uint8_t*)" 2^");
+            ece391_fdputs (1, ece391_itoa (i, buf, 10));
+            put_field (":", stat->hist[i]);
+        }
+        ece391_fdputs (1, (uint8_t*)"\n");
+    }
+    if (0 == shown)
+        ece391_fdputs (1, (uint8_t*)"nothing counted, start with \"irqstat on\"\n");
+    return 0;
+}
@@ -0,0 +1,48 @@
+#include <stdint.h>
+
+#include "ece391support.h"
+#include "ece391syscall.h"
+
+#define BUFSIZE 1024
+
+/* read a decimal number, -1 if there is none */
+static int32_t
+parse_num (uint8_t** s)
+{
+    int32_t value = 0;
+
+    while (' ' == **s)
+        (*s)++;
+    if (**s < '0' || **s > '9')
+        return -1;
+    while (**s >= '0' && **s <= '9') {
+        value = value * 10 + (**s - '0');
+        (*s)++;
+    }
+    return value;
+}
+
+int main ()
+{
+    uint8_t buf[BUFSIZE];
+    uint8_t* arg = buf;
+    int32_t pid, signum = INTERRUPT;
+
+    if (0 != ece391_getargs (buf, BUFSIZE) || -1 == (pid = parse_num (&arg))) {
+        ece391_fdputs (1, (uint8_t*)"usage: kill <pid> [signal number]\n");
+	return 3;
+    }
+    while (' ' == *arg)
+        arg++;
+    if ('\0' != *arg && -1 == (signum = parse_num (&arg))) {
+        ece391_fdputs (1, (uint8_t*)"usage: kill <pid> [signal number]\n");
+	return 3;
+    }
+
+    if (-1 == ece391_kill (pid, signum)) {
+        ece391_fdputs (1, (uint8_t*)"no such process or signal\n");
+	return 2;
+    }
+
+    return 0;
+}
@@ -4,25 +4,49 @@
 #include "ece391syscall.h"
 
 #define SBUFSIZE 33
+#define ARGSIZE 128
+#define DIRENT_NUM 64	/* a full directory block per call */
+#define NAME_COLUMN 34	/* padded name and its terminator */
 
 int main ()
 {
-    int32_t fd, cnt;
-    uint8_t buf[SBUFSIZE];
+    int32_t fd, cnt, i, len;
+    uint8_t buf[NAME_COLUMN];
+    uint8_t num[SBUFSIZE];
+    uint8_t path[ARGSIZE];
+    ece391_dirent_t ents[DIRENT_NUM];
 
-    if (-1 == (fd = ece391_open ((uint8_t*)"."))) {
+    /* list the working directory unless another one is given */
+    if (0 != ece391_getargs (path, ARGSIZE))
+        ece391_strcpy (path, (uint8_t*)".");
+
+    if (-1 == (fd = ece391_open (path))) {
         ece391_fdputs (1, (uint8_t*)"directory open failed\n");
         return 2;
     }
 
-    while (0 != (cnt = ece391_read (fd, buf, SBUFSIZE-1))) {
+    while (0 != (cnt = ece391_getdents (fd, ents, sizeof (ents)))) {
         if (-1 == cnt) {
 	        ece391_fdputs (1, (uint8_t*)"directory entry read failed\n");
 	        return 3;
 	    }
-	    buf[cnt] = '\n';
-	    if (-1 == ece391_write (1, buf, cnt + 1))
-	        return 3;
+	    for (i = 0; i < cnt / (int32_t)sizeof (ece391_dirent_t); i++) {
+	        /* name, type and size on one line */
+	        for (len = 0; len < ECE391_NAME_LEN && '\0' != ents[i].name[len]; len++)
+	            buf[len] = ents[i].name[len];
+	        while (len < NAME_COLUMN - 1)
+	            buf[len++] = ' ';
+	        buf[len] = '\0';
+	        ece391_fdputs (1, buf);
+	        if (ECE391_TYPE_DIR == ents[i].type)
+	            ece391_fdputs (1, (uint8_t*)"dir  ");
+	        else if (ECE391_TYPE_FILE == ents[i].type)
+	            ece391_fdputs (1, (uint8_t*)"file ");
+	        else
+	            ece391_fdputs (1, (uint8_t*)"dev  ");
+	        ece391_fdputs (1, ece391_itoa (ents[i].length, num, 10));
+	        ece391_fdputs (1, (uint8_t*)"\n");
+	    }
     }
 
     return 0;
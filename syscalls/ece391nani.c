@@ -7,7 +7,6 @@
 
 int32_t ece391_memcpy(void* dest, const void* src, int32_t n);
 void ece391_memset(void* memory, char c, int n);
-int32_t ece391_getline(char* buf, int32_t fd, int32_t n);
 
 #define NULL 0
 #define NUM_TERM_COLS    (80 - 1)
@@ -16,6 +15,7 @@ int32_t ece391_getline(char* buf, int32_t fd, int32_t n);
 #define MAX_ROWS         1000
 #define NANI_STATIC_BUF_ADDR 0x07000000
 #define NANI_FILEBUF_ADDR 0x07C00000
+#define NANI_FILEBUF_SIZE 0x00400000
 #define NANI_STATUS_BAR_LINEINFO_START 55
 #define NANI_TAB_SIZE 4
 #define COMMAND_BUF_SIZE 51
@@ -507,8 +507,13 @@ static int32_t NANI_save() {
     int32_t fd;
     int32_t len = erow_to_filebuf();
     if (-1 == (fd = ece391_open (NANI.filename))) {
+        /* a new file is created on its first save */
+        if (-1 == ece391_create ((uint8_t *)NANI.filename) || -1 == (fd = ece391_open ((uint8_t *)NANI.filename)))
+            return -1;
     }
     ece391_write(fd, (uint8_t *)NANI_FILEBUF_ADDR, len);
+    /* writes start at the beginning now, drop what is left of a longer old version */
+    ece391_truncate(fd, len);
     ece391_close(fd);
     NANI.dirty = 0;
     return 0;
@@ -1113,23 +1118,27 @@ static void NANI_init() {
     NANI.dirty = 0;
 }
 
-static char line_buf[MAX_COLS + 1];
-
 static int32_t NANI_open(int32_t fd) {
-    int linelen;
+    ece391_stat_t st;
+    char *p = (char *)NANI_FILEBUF_ADDR;
+    int32_t start, end;
     NANI_select_syntax();
-    while (0 != (linelen = ece391_getline(line_buf, fd, MAX_COLS + 1))) {
-        if (NANI.numrows == MAX_ROWS) {
-            ece391_fdputs(1, (uint8_t*)"file too long\n");
-            return -1;
-        }
-        if (linelen == -2) {
+    /* the file is sized first and read with one call */
+    if (-1 == ece391_fstat(fd, &st) || st.length > NANI_FILEBUF_SIZE) {
+        ece391_fdputs(1, (uint8_t*)"file too long\n");
+        return -1;
+    }
+    if ((int32_t)st.length != ece391_pread(fd, p, st.length, 0)) {
+        ece391_fdputs(1, (uint8_t*)"file read failed\n");
+        return -1;
+    }
+    for (start = 0; start < (int32_t)st.length; start = end + 1) {
+        for (end = start; end < (int32_t)st.length && p[end] != '\n'; end++);
+        if (NANI.numrows == MAX_ROWS || end - start > MAX_COLS) {
             ece391_fdputs(1, (uint8_t*)"file too long\n");
             return -1;
         }
-        while (linelen > 0 && line_buf[linelen - 1] == '\n')
-        linelen--;
-        NANI_insert_row(NANI.numrows, line_buf, linelen);
+        NANI_insert_row(NANI.numrows, p + start, end - start);
     }
     NANI.dirty = 0;
     return 0;
@@ -1174,25 +1183,6 @@ int32_t ece391_memcpy(void* dest, const void* src, int32_t n)
     return 0;
 }
 
-int32_t ece391_getline(char* buf, int32_t fd, int32_t n) {
-    int32_t i;
-    for (i = 0; i < n; i++) {
-        char c;
-        if (1 != ece391_read(fd, &c, 1)) {
-            break;
-        }
-        if (c == '\n') {
-            buf[i] = c;
-            i++;
-            break;
-        }
-        buf[i] = c;
-    }
-    if (i == n && buf[i - 1] != '\n')
-        i = -2;
-    return i;
-}
-
 void ece391_memset(void* memory, char c, int n)
 {
     char* mem = (char*)memory;
@@ -4,10 +4,171 @@
 #include "ece391syscall.h"
 
 #define BUFSIZE 1024
+#define BAD_REDIRECT -2	/* a redirection failed, the command did not run */
+
+/* open the file of a redirection, '>' empties it first and '>>' writes at its end */
+int32_t
+open_redirect (uint8_t* name, uint8_t op, int32_t append)
+{
+    int32_t fd;
+
+    if ('<' == op)
+        return ece391_open (name);
+    if (-1 == (fd = ece391_open (name))) {
+        if (-1 == ece391_create (name))
+	    return -1;
+	return ece391_open (name);
+    }
+    if ((append && -1 == ece391_lseek (fd, 0, ECE391_SEEK_END)) ||
+        (!append && -1 == ece391_truncate (fd, 0))) {
+        ece391_close (fd);
+	return -1;
+    }
+    return fd;
+}
+
+/* take the '<', '>' and '>>' redirections out of cmd and open their files,
+ * a later one of the same direction replaces an earlier one */
+int32_t
+redirect (uint8_t* cmd, int32_t* in_fd, int32_t* out_fd)
+{
+    uint8_t* src = cmd;
+    uint8_t* dst = cmd;
+    uint8_t* name;
+    uint8_t op, c;
+    int32_t append, fd;
+    int32_t* target;
+
+    while ('\0' != *src) {
+        if ('<' != *src && '>' != *src) {
+	    *dst++ = *src++;
+	    continue;
+	}
+	op = *src++;
+	append = ('>' == op && '>' == *src);
+	if (append)
+	    src++;
+	while (' ' == *src)
+	    src++;
+	name = src;
+	while ('\0' != *src && ' ' != *src && '<' != *src && '>' != *src && '|' != *src)
+	    src++;
+	c = *src;
+	*src = '\0';
+	fd = (name == src) ? -1 : open_redirect (name, op, append);
+	*src = c;
+	if (-1 == fd) {
+	    ece391_fdputs (1, (uint8_t*)"cannot redirect\n");
+	    return -1;
+	}
+	target = ('<' == op) ? in_fd : out_fd;
+	if (-1 != *target)
+	    ece391_close (*target);
+	*target = fd;
+    }
+    /* the kernel takes trailing spaces as part of the arguments */
+    while (dst > cmd && ' ' == dst[-1])
+        dst--;
+    *dst = '\0';
+    return 0;
+}
+
+/* run one command with fd 0 and fd 1 moved to in_fd and out_fd, -1 keeps the shell's own,
+ * its own redirections win over both */
+int32_t
+run_command (uint8_t* cmd, int32_t in_fd, int32_t out_fd)
+{
+    int32_t rval, save_in = -1, save_out = -1, file_in = -1, file_out = -1;
+
+    if (-1 == redirect (cmd, &file_in, &file_out))
+        rval = BAD_REDIRECT;
+    else {
+	if (-1 != file_in)
+	    in_fd = file_in;
+	if (-1 != file_out)
+	    out_fd = file_out;
+	rval = -1;
+	if ((-1 == in_fd || (-1 != (save_in = ece391_dup (0)) && -1 != ece391_dup2 (in_fd, 0))) &&
+	    (-1 == out_fd || (-1 != (save_out = ece391_dup (1)) && -1 != ece391_dup2 (out_fd, 1))))
+	    rval = ece391_execute (cmd);
+    }
+    if (-1 != save_out) {
+        ece391_dup2 (save_out, 1);
+	ece391_close (save_out);
+    }
+    if (-1 != save_in) {
+        ece391_dup2 (save_in, 0);
+	ece391_close (save_in);
+    }
+    if (-1 != file_in)
+        ece391_close (file_in);
+    if (-1 != file_out)
+        ece391_close (file_out);
+    return rval;
+}
+
+/* report how a program ended */
+void
+report (int32_t rval)
+{
+    if (BAD_REDIRECT == rval)
+	return;
+    if (-1 == rval)
+	ece391_fdputs (1, (uint8_t*)"no such command\n");
+    else if (256 == rval)
+	ece391_fdputs (1, (uint8_t*)"program terminated by exception\n");
+    else if (0 != rval)
+	ece391_fdputs (1, (uint8_t*)"program terminated abnormally\n");
+}
+
+/* run the commands of a line split by '|', each one's output is the next one's input.
+ * A terminal runs one program at a time, so each stage runs to its end and leaves its
+ * output in the pipe for the next one. A stage whose output did not all fit in the pipe
+ * has lost the rest, so the line stops there rather than run on part of the data. */
+void
+run_pipeline (uint8_t* buf)
+{
+    int32_t fds[2], in_fd = -1, rval;
+    ece391_stat_t st;
+    uint8_t* cmd = buf;
+    uint8_t* bar;
+
+    while (1) {
+	for (bar = cmd; '\0' != *bar && '|' != *bar; bar++);
+	if ('\0' == *bar) {
+	    rval = run_command (cmd, in_fd, -1);
+	    if (-1 != in_fd)
+	        ece391_close (in_fd);
+	    report (rval);
+	    return;
+	}
+	*bar = '\0';
+	if (-1 == ece391_pipe (fds)) {
+	    ece391_fdputs (1, (uint8_t*)"pipe failed\n");
+	    if (-1 != in_fd)
+	        ece391_close (in_fd);
+	    return;
+	}
+	rval = run_command (cmd, in_fd, fds[1]);
+	/* the write end goes away so the next stage sees the end of the data */
+	ece391_close (fds[1]);
+	if (-1 != in_fd)
+	    ece391_close (in_fd);
+	if (0 != rval)
+	    report (rval);
+	if (-1 == ece391_fstat (fds[0], &st) || (st.flags & ECE391_STAT_PIPE_LOST)) {
+	    ece391_fdputs (1, (uint8_t*)"output did not fit in the pipe, pipeline stopped\n");
+	    ece391_close (fds[0]);
+	    return;
+	}
+	in_fd = fds[0];
+	for (cmd = bar + 1; ' ' == *cmd; cmd++);
+    }
+}
 
 int main ()
 {
-    int32_t cnt, rval;
+    int32_t cnt;
     uint8_t buf[BUFSIZE];
     ece391_fdputs (1, (uint8_t*)"Starting 391 Shell\n");
 
@@ -24,13 +185,13 @@ int main ()
 	    return 0;
 	if ('\0' == buf[0])
 	    continue;
-	rval = ece391_execute (buf);
-	if (-1 == rval)
-	    ece391_fdputs (1, (uint8_t*)"no such command\n");
-	else if (256 == rval)
-	    ece391_fdputs (1, (uint8_t*)"program terminated by exception\n");
-	else if (0 != rval)
-	    ece391_fdputs (1, (uint8_t*)"program terminated abnormally\n");
+	/* the working directory belongs to the shell, so cd cannot be a program */
+	if (0 == ece391_strcmp (buf, (uint8_t*)"cd") || 0 == ece391_strncmp (buf, (uint8_t*)"cd ", 3)) {
+	    if (-1 == ece391_chdir ('\0' == buf[2] ? (uint8_t*)"/" : buf + 3))
+	        ece391_fdputs (1, (uint8_t*)"no such directory\n");
+	    continue;
+	}
+	run_pipeline (buf);
     }
 }
 
@@ -0,0 +1,163 @@
+#include <stdint.h>
+
+#include "ece391support.h"
+#include "ece391syscall.h"
+
+#define BUFSIZE 1024
+#define NUM_SIZE 12		/* a 32-bit number in decimal with its sign */
+#define USER_START 0x08000000	/* arguments from here up are printed as addresses */
+
+/* names and argument counts of the calls, by number */
+static const struct {
+    const char* name;
+    int32_t nargs;
+} calls[] = {
+    {"null", 0}, {"halt", 1}, {"execute", 1}, {"read", 3}, {"write", 3},
+    {"open", 1}, {"close", 1}, {"getargs", 2}, {"vidmap", 1}, {"set_handler", 2},
+    {"sigreturn", 0}, {"malloc", 1}, {"free", 1}, {"ioctl", 2}, {"ps", 0},
+    {"date", 0}, {"readv", 3}, {"truncate", 2}, {"create", 1}, {"unlink", 1},
+    {"mkdir", 1}, {"chdir", 1}, {"sync", 0}, {"getdents", 3}, {"lseek", 3},
+    {"pread", 4}, {"pwrite", 4}, {"fstat", 2}, {"stat", 2}, {"dup", 1},
+    {"dup2", 2}, {"pipe", 1}, {"uring_setup", 1}, {"uring_enter", 1}, {"poll", 3},
+    {"trace", 3}, {"sigaction", 3}, {"kill", 2}, {"irqstat", 3}
+};
+#define NUM_CALLS (sizeof (calls) / sizeof (calls[0]))
+
+static ece391_trace_entry_t entries[ECE391_TRACE_ENTRIES];
+static uint32_t hist[ECE391_TRACE_SYSCALLS][ECE391_TRACE_BUCKETS];
+
+static void
+put_name (uint32_t num)
+{
+    uint8_t buf[NUM_SIZE];
+
+    if (num < NUM_CALLS) {
+        ece391_fdputs (1, (uint8_t*)calls[num].name);
+    } else {
+        ece391_fdputs (1, (uint8_t*)"syscall_");
+        ece391_fdputs (1, ece391_itoa (num, buf, 10));
+    }
+}
+
+static void
+put_int (int32_t value)
+{
+    uint8_t buf[NUM_SIZE];
+
+    if (value < 0) {
+        ece391_fdputs (1, (uint8_t*)"-");
+        value = -value;
+    }
+    ece391_fdputs (1, ece391_itoa ((uint32_t)value, buf, 10));
+}
+
+static void
+put_arg (uint32_t value)
+{
+    uint8_t buf[NUM_SIZE];
+
+    if (value >= USER_START) {
+        ece391_fdputs (1, (uint8_t*)"0x");
+        ece391_fdputs (1, ece391_itoa (value, buf, 16));
+    } else {
+        put_int ((int32_t)value);
+    }
+}
+
+/* one line per call, like "write(1, 0x83ff000, 1) = 1 <640 cycles>" */
+static void
+put_calls (int32_t cnt)
+{
+    uint8_t buf[NUM_SIZE];
+    int32_t i, j, nargs;
+
+    if (ECE391_TRACE_ENTRIES == cnt)
+        ece391_fdputs (1, (uint8_t*)"... only the newest calls are kept\n");
+    for (i = 0; i < cnt; i++) {
+        put_name (entries[i].num);
+        ece391_fdputs (1, (uint8_t*)"(");
+        nargs = (entries[i].num < NUM_CALLS) ? calls[entries[i].num].nargs : 4;
+        for (j = 0; j < nargs; j++) {
+            if (0 != j)
+                ece391_fdputs (1, (uint8_t*)", ");
+            put_arg (entries[i].args[j]);
+        }
+        if (1 == entries[i].num) {
+            ece391_fdputs (1, (uint8_t*)") = ?\n");
+            continue;
+        }
+        ece391_fdputs (1, (uint8_t*)") = ");
+        put_int (entries[i].ret);
+        ece391_fdputs (1, (uint8_t*)" <");
+        ece391_fdputs (1, ece391_itoa (entries[i].cycles, buf, 10));
+        ece391_fdputs (1, (uint8_t*)" cycles>\n");
+    }
+}
+
+/* one line per call number, its count then "2^i:n" for every bucket in use */
+static void
+put_hist (void)
+{
+    uint8_t buf[NUM_SIZE];
+    uint32_t num, i, total;
+
+    for (num = 0; num < ECE391_TRACE_SYSCALLS; num++) {
+        total = 0;
+        for (i = 0; i < ECE391_TRACE_BUCKETS; i++)
+            total += hist[num][i];
+        if (0 == total)
+            continue;
+        put_name (num);
+        ece391_fdputs (1, (uint8_t*)": ");
+        ece391_fdputs (1, ece391_itoa (total, buf, 10));
+        ece391_fdputs (1, (uint8_t*)" calls, cycles");
+        for (i = 0; i < ECE391_TRACE_BUCKETS; i++) {
+            if (0 == hist[num][i])
+                continue;
+            ece391_fdputs (1, (uint8_t*)" 2^");
+            ece391_fdputs (1, ece391_itoa (i, buf, 10));
+            ece391_fdputs (1, (uint8_t*)":");
+            ece391_fdputs (1, ece391_itoa (hist[num][i], buf, 10));
+        }
+        ece391_fdputs (1, (uint8_t*)"\n");
+    }
+}
+
+int main ()
+{
+    uint8_t buf[BUFSIZE];
+    uint8_t* command = buf;
+    int32_t summary = 0;
+    int32_t status, cnt;
+
+    if (0 != ece391_getargs (buf, BUFSIZE)) {
+        ece391_fdputs (1, (uint8_t*)"usage: strace [-c] command [args]\n");
+        return 3;
+    }
+    if (0 == ece391_strncmp (buf, (uint8_t*)"-c ", 3)) {
+        summary = 1;
+        command = buf + 3;
+    }
+
+    ece391_trace (ECE391_TRACE_ON, 0, 0);
+    status = ece391_execute (command);
+    ece391_trace (ECE391_TRACE_OFF, 0, 0);
+    if (-1 == status) {
+        ece391_fdputs (1, (uint8_t*)"could not run the command\n");
+        return 2;
+    }
+
+    if (summary) {
+        if (-1 == ece391_trace (ECE391_TRACE_HIST, hist, sizeof (hist)))
+            return 3;
+        put_hist ();
+    } else {
+        if (-1 == (cnt = ece391_trace (ECE391_TRACE_READ, entries, sizeof (entries))))
+            return 3;
+        put_calls (cnt / (int32_t)sizeof (ece391_trace_entry_t));
+    }
+    ece391_fdputs (1, (uint8_t*)"+++ exited with ");
+    put_int (status);
+    ece391_fdputs (1, (uint8_t*)" +++\n");
+    return 0;
+}
@@ -102,3 +102,32 @@ uint8_t* ece391_strrev(uint8_t* s)
    return s;
 }
 
+
+/* Copy the date from the kernel page, again if the kernel changed it meanwhile */
+void ece391_getdate(ece391_date_t* date)
+{
+    ece391_vdso_t* vdso = (ece391_vdso_t*)ECE391_VDSO_ADDR;
+    uint32_t seq;
+
+    do {
+        seq = vdso->seq;
+        date->sec = vdso->sec;
+        date->min = vdso->min;
+        date->hour = vdso->hour;
+        date->day = vdso->day;
+        date->month = vdso->month;
+        date->year = vdso->year;
+    } while ((seq & 1) || seq != vdso->seq);
+}
+
+/* Timer ticks since boot, from the kernel page */
+uint32_t ece391_ticks(void)
+{
+    return ((ece391_vdso_t*)ECE391_VDSO_ADDR)->ticks;
+}
+
+/* Timer ticks per second */
+uint32_t ece391_hz(void)
+{
+    return ((ece391_vdso_t*)ECE391_VDSO_ADDR)->hz;
+}
@@ -0,0 +1,50 @@
+#include <stdint.h>
+
+#include "ece391support.h"
+#include "ece391syscall.h"
+
+#define CALLS_SHIFT 16		/* 65536 calls per path, the average is a shift away */
+#define CALLS (1 << CALLS_SHIFT)
+
+static uint64_t
+rdtsc (void)
+{
+    uint32_t lo, hi;
+    asm volatile ("rdtsc" : "=a" (lo), "=d" (hi));
+    return ((uint64_t)hi << 32) | lo;
+}
+
+/* cycles of one call, averaged over CALLS of them */
+static uint32_t
+time_calls (int32_t (*call) (void))
+{
+    uint64_t start, cycles;
+    int32_t i;
+
+    start = rdtsc ();
+    for (i = 0; i < CALLS; i++)
+        call ();
+    cycles = rdtsc () - start;
+    return (uint32_t)(cycles >> CALLS_SHIFT);
+}
+
+static void
+report (const char* path, uint32_t cycles)
+{
+    uint8_t buf[11];
+
+    ece391_fdputs (1, (uint8_t*)path);
+    ece391_fdputs (1, ece391_itoa (cycles, buf, 10));
+    ece391_fdputs (1, (uint8_t*)" cycles per call\n");
+}
+
+int main ()
+{
+    /* once through each path first, the fast one checks the CPU on its first call */
+    ece391_null_int ();
+    ece391_null_fast ();
+
+    report ("int $0x80: ", time_calls (ece391_null_int));
+    report ("sysenter:  ", time_calls (ece391_null_fast));
+    return 0;
+}
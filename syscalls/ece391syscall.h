@@ -5,6 +5,122 @@
 
 /* All calls return >= 0 on success or -1 on failure. */
 
+/* One buffer of a vectored read, at most 16 per call */
+typedef struct ece391_iovec {
+	void* iov_base;
+	int32_t iov_len;
+} ece391_iovec_t;
+
+/* One directory entry filled by getdents */
+#define ECE391_NAME_LEN 32
+#define ECE391_TYPE_RTC 0
+#define ECE391_TYPE_DIR 1
+#define ECE391_TYPE_FILE 2
+#define ECE391_TYPE_PIPE 3
+typedef struct ece391_dirent {
+	uint8_t name[ECE391_NAME_LEN];	/* not terminated when 32 bytes long */
+	uint32_t type;
+	uint32_t inode;
+	uint32_t length;
+} ece391_dirent_t;
+
+/* Origins of lseek */
+#define ECE391_SEEK_SET 0
+#define ECE391_SEEK_CUR 1
+#define ECE391_SEEK_END 2
+
+/* File information filled by stat and fstat */
+typedef struct ece391_stat {
+	uint32_t type;
+	uint32_t inode;
+	uint32_t length;
+	uint32_t flags;
+} ece391_stat_t;
+/* Set in flags of a pipe some write to came back short, when it was full or out of memory */
+#define ECE391_STAT_PIPE_LOST 0x1
+
+/* Rings of batched system calls, one ece391_uring_enter runs every queued entry.
+ * The program fills sq[sq_tail % ECE391_URING_ENTRIES] and bumps sq_tail, and reads
+ * cq[cq_head % ECE391_URING_ENTRIES] up to cq_tail and bumps cq_head. */
+#define ECE391_URING_ENTRIES 128
+#define ECE391_URING_READ 0
+#define ECE391_URING_WRITE 1
+#define ECE391_URING_OPEN 2		/* buf is the file name */
+#define ECE391_URING_CLOSE 3
+typedef struct ece391_uring_sqe {
+	uint32_t opcode;
+	int32_t fd;
+	void* buf;
+	int32_t len;
+	uint32_t user_data;
+} ece391_uring_sqe_t;
+typedef struct ece391_uring_cqe {
+	uint32_t user_data;
+	int32_t res;
+} ece391_uring_cqe_t;
+typedef struct ece391_uring {
+	volatile uint32_t sq_head;
+	volatile uint32_t sq_tail;
+	volatile uint32_t cq_head;
+	volatile uint32_t cq_tail;
+	ece391_uring_sqe_t sq[ECE391_URING_ENTRIES];
+	ece391_uring_cqe_t cq[ECE391_URING_ENTRIES];
+} ece391_uring_t;
+
+/* One fd waited on by poll, negative fds are skipped */
+#define ECE391_POLLIN 0x0001		/* a read would not wait */
+#define ECE391_POLLOUT 0x0004		/* a write would not wait */
+#define ECE391_POLLNVAL 0x0020		/* the fd is not open */
+typedef struct ece391_pollfd {
+	int32_t fd;
+	int16_t events;
+	int16_t revents;
+} ece391_pollfd_t;
+
+/* System calls traced in the programs started after ECE391_TRACE_ON. ECE391_TRACE_READ copies
+ * the newest calls of the last traced program that halted, oldest first, ECE391_TRACE_HIST
+ * the count of calls of each number taking 2^i up to 2^(i+1)-1 cycles */
+#define ECE391_TRACE_OFF 0
+#define ECE391_TRACE_ON 1
+#define ECE391_TRACE_READ 2
+#define ECE391_TRACE_HIST 3
+#define ECE391_TRACE_ENTRIES 128
+#define ECE391_TRACE_SYSCALLS 40
+#define ECE391_TRACE_BUCKETS 32
+typedef struct ece391_trace_entry {
+	uint32_t num;
+	uint32_t args[4];
+	int32_t ret;			/* the status for halt */
+	uint32_t cycles;		/* 0 for halt */
+} ece391_trace_entry_t;
+
+/* How often the handler of each vector ran and its TSC cycles, counted from ECE391_IRQSTAT_ON
+ * to ECE391_IRQSTAT_OFF and filled by ECE391_IRQSTAT_READ */
+#define ECE391_IRQSTAT_OFF 0
+#define ECE391_IRQSTAT_ON 1
+#define ECE391_IRQSTAT_READ 2
+#define ECE391_IRQSTAT_VECTORS 0x30
+#define ECE391_IRQSTAT_BUCKETS 32
+typedef struct ece391_irqstat {
+	uint32_t count;
+	uint32_t total_low;		/* cycles of every run, 64 bits */
+	uint32_t total_high;
+	uint32_t max;
+	uint32_t hist[ECE391_IRQSTAT_BUCKETS];	/* runs of 2^i up to 2^(i+1)-1 cycles */
+} ece391_irqstat_t;
+
+/* The read-only page the kernel keeps up to date for every program */
+#define ECE391_VDSO_ADDR 0x8401000
+typedef struct ece391_vdso {
+	volatile uint32_t seq;		/* odd while the date is being written */
+	volatile uint32_t ticks;	/* timer ticks since boot */
+	volatile uint32_t hz;		/* ticks per second */
+	volatile int32_t sec, min, hour, day, month, year;
+} ece391_vdso_t;
+typedef struct ece391_date {
+	int32_t sec, min, hour, day, month, year;
+} ece391_date_t;
+
 /*  
  * Note that the system call for halt will have to make sure that only
  * the low byte of EBX (the status argument) is returned to the calling
@@ -25,6 +141,44 @@ extern void* ece391_malloc(int32_t size);
 extern int32_t ece391_free(void* ptr);
 extern int32_t ece391_ioctl(int32_t fd, int32_t flag);
 extern int32_t ece391_ps(void);
+extern int32_t ece391_readv(int32_t fd, const ece391_iovec_t* iov, int32_t iovcnt);
+extern int32_t ece391_truncate(int32_t fd, uint32_t length);
+extern int32_t ece391_create(const uint8_t* filename);
+extern int32_t ece391_unlink(const uint8_t* filename);
+extern int32_t ece391_mkdir(const uint8_t* path);
+extern int32_t ece391_chdir(const uint8_t* path);
+extern int32_t ece391_sync(void);
+extern int32_t ece391_getdents(int32_t fd, ece391_dirent_t* buf, int32_t nbytes);
+extern int32_t ece391_lseek(int32_t fd, int32_t offset, int32_t whence);
+extern int32_t ece391_pread(int32_t fd, void* buf, int32_t nbytes, uint32_t offset);
+extern int32_t ece391_pwrite(int32_t fd, const void* buf, int32_t nbytes, uint32_t offset);
+extern int32_t ece391_fstat(int32_t fd, ece391_stat_t* st);
+extern int32_t ece391_stat(const uint8_t* filename, ece391_stat_t* st);
+extern int32_t ece391_dup(int32_t fd);
+extern int32_t ece391_dup2(int32_t oldfd, int32_t newfd);
+extern int32_t ece391_pipe(int32_t fds[2]);
+extern int32_t ece391_uring_setup(ece391_uring_t* ring);
+extern int32_t ece391_uring_enter(uint32_t to_submit);
+extern int32_t ece391_poll(ece391_pollfd_t* fds, uint32_t nfds, int32_t timeout);
+extern int32_t ece391_trace(int32_t cmd, void* buf, int32_t nbytes);
+extern int32_t ece391_sigaction(int32_t signum, void* handler, uint32_t mask);
+extern int32_t ece391_kill(int32_t pid, int32_t signum);
+extern int32_t ece391_irqstat(int32_t cmd, ece391_irqstat_t* buf, int32_t nbytes);
+
+/* Read from the kernel page, no trap */
+extern void ece391_getdate(ece391_date_t* date);
+extern uint32_t ece391_ticks(void);
+extern uint32_t ece391_hz(void);
+
+/* No call, for timing SYSENTER against int $0x80, -1 every time */
+extern int32_t ece391_null_fast(void);
+extern int32_t ece391_null_int(void);
+
+/* Handlers of sigaction besides a function, its mask is ECE391_SIG_BIT of the signals
+ * blocked while the function runs, the signal itself always is */
+#define ECE391_SIG_DFL ((void*)0)
+#define ECE391_SIG_IGN ((void*)1)
+#define ECE391_SIG_BIT(signum) (1 << (signum))
 
 enum signums {
 	DIV_ZERO = 0,
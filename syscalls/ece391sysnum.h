@@ -1,6 +1,7 @@
 #if !defined(ECE391SYSNUM_H)
 #define ECE391SYSNUM_H
 
+#define SYS_NULL         0
 #define SYS_HALT         1
 #define SYS_EXECUTE      2
 #define SYS_READ         3
@@ -16,5 +17,28 @@
 #define SYS_IOCTL  13
 #define SYS_PS           14
 #define SYS_DATE         15
+#define SYS_READV        16
+#define SYS_TRUNCATE     17
+#define SYS_CREATE       18
+#define SYS_UNLINK       19
+#define SYS_MKDIR        20
+#define SYS_CHDIR        21
+#define SYS_SYNC         22
+#define SYS_GETDENTS     23
+#define SYS_LSEEK        24
+#define SYS_PREAD        25
+#define SYS_PWRITE       26
+#define SYS_FSTAT        27
+#define SYS_STAT         28
+#define SYS_DUP          29
+#define SYS_DUP2         30
+#define SYS_PIPE         31
+#define SYS_URING_SETUP  32
+#define SYS_URING_ENTER  33
+#define SYS_POLL         34
+#define SYS_TRACE        35
+#define SYS_SIGACTION    36
+#define SYS_KILL         37
+#define SYS_IRQSTAT      38
 
 #endif /* ECE391SYSNUM_H */
@@ -0,0 +1,29 @@
+#include <stdint.h>
+
+#include "ece391support.h"
+#include "ece391syscall.h"
+
+int main ()
+{
+    int32_t fd;
+    uint8_t buf[1024];
+
+    if (0 != ece391_getargs (buf, 1024)) {
+        ece391_fdputs (1, (uint8_t*)"could not read arguments\n");
+	return 3;
+    }
+
+    /* an existing file is left as it is */
+    if (-1 != (fd = ece391_open (buf))) {
+        ece391_close (fd);
+	return 0;
+    }
+
+    if (-1 == ece391_create (buf)) {
+        ece391_fdputs (1, (uint8_t*)"file create failed\n");
+	return 2;
+    }
+
+    return 0;
+}
+
@@ -0,0 +1,311 @@
+/* createfs.c - Builds a file system image out of a host directory
+ * vim:ts=4 noexpandtab
+ *
+ * Usage: createfs -i <dir> -o <image> [-n inodes] [-f free blocks] [-b]
+ *
+ * The image is a boot block holding the statistics and the root dentries,
+ * then the inodes, then the data blocks, all BLOCK_SIZE bytes. Every file
+ * and subdirectory gets the data blocks of one contiguous extent, laid out
+ * in the order the tree is walked, so a reader streaming a file touches
+ * consecutive blocks and can copy runs of them at once. A file or directory of
+ * at most INLINE_MAX_SIZE bytes is held by its inode and takes no data block,
+ * unless -b asks for every file to have blocks.
+ */
+
+#include <dirent.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* the on-disk format, see student-distrib/filesys.h */
+#define BLOCK_SIZE 4096
+#define DIR_ENTRY_SIZE 64
+#define MAX_FILE_NUM 63
+#define MAX_FILE_NAME 32
+#define RTC_FILE_TYPE 0
+#define DIR_FILE_TYPE 1
+#define REGULAR_FILE_TYPE 2
+#define ROOT_DIR_INODE 0
+#define MAX_FILE_BLOCKS ((BLOCK_SIZE - 4) / 4)
+#define INODE_INLINE 0x80000000
+#define INLINE_MAX_SIZE (BLOCK_SIZE - 4)
+#define MAX_INODE_NUM 1024
+#define MAX_DATA_BLOCK_NUM 8192
+#define BOOT_STATS_SIZE 64          // dir_entry_num, inodes_num, data_blocks_num and the reserved bytes
+
+#define DEFAULT_INODE_NUM 64
+#define DEFAULT_FREE_BLOCKS 256     // 1 MB for files written at run time
+#define RTC_NAME "rtc"
+#define MAX_PATH_LEN 4096
+
+typedef struct node node_t;
+struct node {
+    char name[MAX_FILE_NAME + 1];
+    char path[MAX_PATH_LEN];        // host path of the file, unused for directories
+    uint32_t type;
+    uint32_t inode;                 // ROOT_DIR_INODE for the root
+    uint32_t length;                // bytes of data, dentries for a directory
+    uint32_t first_block;           // the extent starts here
+    uint32_t is_inline;             // the data is held by the inode
+    node_t* parent;
+    node_t* child;                  // first entry of a directory
+    node_t* next;                   // next entry of the same directory
+    uint32_t child_num;
+};
+
+static uint32_t inode_next = ROOT_DIR_INODE + 1;
+static uint32_t block_next = 0;
+static uint32_t use_inline = 1;      // 0 with -b
+
+/* die
+ *
+ * report an error and stop
+ * Inputs: msg - what went wrong
+ *         path - the file involved, may be NULL
+ * Outputs: None
+ * Side Effects: exit the process
+ */
+static void die(const char* msg, const char* path){
+    if(path != NULL){
+        fprintf(stderr, "createfs: %s: %s\n", path, msg);
+    } else {
+        fprintf(stderr, "createfs: %s\n", msg);
+    }
+    exit(1);
+}
+
+/* block_count
+ *
+ * get the data blocks holding length bytes
+ * Inputs: length - the size in bytes
+ * Outputs: the number of blocks
+ * Side Effects: None
+ */
+static uint32_t block_count(uint32_t length){
+    return (length + BLOCK_SIZE - 1) / BLOCK_SIZE;
+}
+
+/* scan_dir
+ *
+ * read a host directory into the tree, entries sorted by name so the image is reproducible
+ * Inputs: dir - the node of the directory, path - its host path
+ * Outputs: None
+ * Side Effects: allocate the nodes of the entries and number their inodes
+ */
+static void scan_dir(node_t* dir, const char* path){
+    struct dirent** list;
+    struct stat st;
+    node_t** tail = &(dir->child);
+    node_t* cur;
+    char sub[MAX_PATH_LEN];
+    int num, i;
+
+    num = scandir(path, &list, NULL, alphasort);
+    if(num < 0) die(strerror(errno), path);
+    for(i = 0; i < num; i++){
+        if(strcmp(list[i]->d_name, ".") == 0 || strcmp(list[i]->d_name, "..") == 0 ||
+           (dir->parent == NULL && strcmp(list[i]->d_name, RTC_NAME) == 0)){
+            free(list[i]);
+            continue;
+        }
+        if((size_t)snprintf(sub, sizeof(sub), "%s/%s", path, list[i]->d_name) >= sizeof(sub)) die("path too long", path);
+        if(stat(sub, &st) == -1) die(strerror(errno), sub);
+        if(!S_ISREG(st.st_mode) && !S_ISDIR(st.st_mode)){
+            fprintf(stderr, "createfs: %s: skipped, not a file or directory\n", sub);
+            free(list[i]);
+            continue;
+        }
+        if(strlen(list[i]->d_name) > MAX_FILE_NAME){
+            fprintf(stderr, "createfs: %s: name cut to %d bytes\n", sub, MAX_FILE_NAME);
+        }
+
+        cur = calloc(1, sizeof(node_t));
+        if(cur == NULL) die("out of memory", NULL);
+        memcpy(cur->name, list[i]->d_name, strnlen(list[i]->d_name, MAX_FILE_NAME));
+        cur->parent = dir;
+        cur->inode = inode_next++;
+        if(S_ISDIR(st.st_mode)){
+            cur->type = DIR_FILE_TYPE;
+            scan_dir(cur, sub);
+            /* "." and ".." come first in a subdirectory */
+            cur->length = (cur->child_num + 2) * DIR_ENTRY_SIZE;
+        } else {
+            if(st.st_size > (off_t)MAX_FILE_BLOCKS * BLOCK_SIZE) die("file too large", sub);
+            cur->type = REGULAR_FILE_TYPE;
+            cur->length = (uint32_t)st.st_size;
+            strcpy(cur->path, sub);
+        }
+        if(cur->length > MAX_FILE_BLOCKS * BLOCK_SIZE) die("directory too large", sub);
+        *tail = cur;
+        tail = &(cur->next);
+        dir->child_num++;
+        free(list[i]);
+    }
+    free(list);
+}
+
+/* place
+ *
+ * give every file and subdirectory of the tree its extent, in walk order
+ * Inputs: dir - the directory to lay out
+ * Outputs: None
+ * Side Effects: None
+ */
+static void place(node_t* dir){
+    node_t* cur;
+    for(cur = dir->child; cur != NULL; cur = cur->next){
+        cur->is_inline = (use_inline && cur->length <= INLINE_MAX_SIZE);
+        if(!cur->is_inline){
+            cur->first_block = block_next;
+            block_next += block_count(cur->length);
+        }
+        if(cur->type == DIR_FILE_TYPE) place(cur);
+    }
+}
+
+/* put_dentry
+ *
+ * fill a dentry
+ * Inputs: out - DIR_ENTRY_SIZE bytes, name - the file name, type - the file type, inode - the inode
+ * Outputs: None
+ * Side Effects: None
+ */
+static void put_dentry(uint8_t* out, const char* name, uint32_t type, uint32_t inode){
+    memset(out, 0, DIR_ENTRY_SIZE);
+    memcpy(out, name, strnlen(name, MAX_FILE_NAME));
+    memcpy(out + MAX_FILE_NAME, &type, sizeof(type));
+    memcpy(out + MAX_FILE_NAME + sizeof(type), &inode, sizeof(inode));
+}
+
+/* put_entries
+ *
+ * fill the dentries of a directory's entries
+ * Inputs: out - child_num dentries, dir - the directory
+ * Outputs: None
+ * Side Effects: None
+ */
+static void put_entries(uint8_t* out, const node_t* dir){
+    const node_t* cur;
+    for(cur = dir->child; cur != NULL; cur = cur->next){
+        put_dentry(out, cur->name, cur->type, cur->inode);
+        out += DIR_ENTRY_SIZE;
+    }
+}
+
+/* write_tree
+ *
+ * fill the inodes and data blocks of the tree
+ * Inputs: image - the image, data - its first data block
+ *         dir - the directory to write
+ * Outputs: None
+ * Side Effects: None
+ */
+static void write_tree(uint8_t* image, uint8_t* data, const node_t* dir){
+    const node_t* cur;
+    uint8_t* inode;
+    uint8_t* content;
+    uint32_t length, i;
+    FILE* file;
+    for(cur = dir->child; cur != NULL; cur = cur->next){
+        inode = image + (1 + cur->inode) * BLOCK_SIZE;
+        length = cur->length;
+        if(cur->is_inline){
+            length |= INODE_INLINE;
+            content = inode + sizeof(length);
+        } else {
+            content = data + cur->first_block * BLOCK_SIZE;
+            for(i = 0; i < block_count(cur->length); i++){
+                ((uint32_t*)inode)[1 + i] = cur->first_block + i;
+            }
+        }
+        memcpy(inode, &length, sizeof(length));
+        if(cur->type == DIR_FILE_TYPE){
+            put_dentry(content, ".", DIR_FILE_TYPE, cur->inode);
+            put_dentry(content + DIR_ENTRY_SIZE, "..", DIR_FILE_TYPE, dir->inode);
+            put_entries(content + 2 * DIR_ENTRY_SIZE, cur);
+            write_tree(image, data, cur);
+            continue;
+        }
+        file = fopen(cur->path, "rb");
+        if(file == NULL) die(strerror(errno), cur->path);
+        if(fread(content, 1, cur->length, file) != cur->length) die("short read", cur->path);
+        fclose(file);
+    }
+}
+
+/* usage
+ *
+ * print how to run the tool and stop
+ * Inputs: None
+ * Outputs: None
+ * Side Effects: exit the process
+ */
+static void usage(void){
+    fprintf(stderr, "usage: createfs -i <dir> -o <image> [-n inodes] [-f free blocks] [-b]\n"
+                    "  -n  inodes in the image, %d by default\n"
+                    "  -f  empty data blocks left for files written at run time, %d by default\n"
+                    "  -b  give small files data blocks instead of holding them in the inode\n",
+                    DEFAULT_INODE_NUM, DEFAULT_FREE_BLOCKS);
+    exit(1);
+}
+
+int main(int argc, char** argv){
+    const char* in = NULL;
+    const char* out = NULL;
+    uint32_t inodes_num = DEFAULT_INODE_NUM;
+    uint32_t spare = DEFAULT_FREE_BLOCKS;
+    uint32_t data_blocks_num, stats[3];
+    node_t root;
+    uint8_t* image;
+    size_t size;
+    FILE* file;
+    int opt;
+
+    while((opt = getopt(argc, argv, "i:o:n:f:b")) != -1){
+        switch(opt){
+            case 'i': in = optarg; break;
+            case 'o': out = optarg; break;
+            case 'n': inodes_num = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'f': spare = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'b': use_inline = 0; break;
+            default: usage();
+        }
+    }
+    if(in == NULL || out == NULL || optind != argc) usage();
+    if(inodes_num == 0 || inodes_num > MAX_INODE_NUM) die("bad inode count", NULL);
+
+    memset(&root, 0, sizeof(root));
+    root.type = DIR_FILE_TYPE;
+    root.inode = ROOT_DIR_INODE;
+    scan_dir(&root, in);
+    /* the boot block also holds "." and the RTC */
+    if(root.child_num + 2 > MAX_FILE_NUM) die("too many files in the root directory", in);
+    if(inode_next > inodes_num) die("not enough inodes, raise -n", NULL);
+    place(&root);
+    data_blocks_num = block_next + spare;
+    if(data_blocks_num > MAX_DATA_BLOCK_NUM) die("image too large", NULL);
+
+    size = (size_t)(1 + inodes_num + data_blocks_num) * BLOCK_SIZE;
+    image = calloc(1, size);
+    if(image == NULL) die("out of memory", NULL);
+    stats[0] = root.child_num + 2;
+    stats[1] = inodes_num;
+    stats[2] = data_blocks_num;
+    memcpy(image, stats, sizeof(stats));
+    put_dentry(image + BOOT_STATS_SIZE, ".", DIR_FILE_TYPE, ROOT_DIR_INODE);
+    put_dentry(image + BOOT_STATS_SIZE + DIR_ENTRY_SIZE, RTC_NAME, RTC_FILE_TYPE, 0);
+    put_entries(image + BOOT_STATS_SIZE + 2 * DIR_ENTRY_SIZE, &root);
+    write_tree(image, image + (1 + inodes_num) * BLOCK_SIZE, &root);
+
+    file = fopen(out, "wb");
+    if(file == NULL) die(strerror(errno), out);
+    if(fwrite(image, 1, size, file) != size || fclose(file) != 0) die("write failed", out);
+    printf("%s: %u entries, %u of %u inodes, %u data blocks (%u free)\n",
+           out, root.child_num + 2, inode_next, inodes_num, data_blocks_num, spare);
+    free(image);
+    return 0;
+}